@@ -0,0 +1,318 @@
+/***********************************************************************************
+ * Copyright (c) 2017, UT-Battelle
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the xacc nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *   Implementation - Thien Nguyen
+ *
+ **********************************************************************************/
+#include "GateFusion.hpp"
+#include "xacc.hpp"
+#include "base/Gates.hpp"
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+namespace {
+using Matrix = std::vector<std::vector<std::complex<double>>>;
+// Tolerance to consider a fused product the identity (i.e. drop it).
+constexpr double IDENTITY_TOLERANCE = 1e-12;
+// No fused operation on this qubit to absorb single-qubit gates into.
+constexpr int NO_OPERATION = -1;
+
+Matrix matMul(const Matrix &in_a, const Matrix &in_b) {
+  const size_t dim = in_a.size();
+  Matrix result(dim, std::vector<std::complex<double>>(dim, 0.0));
+  for (size_t i = 0; i < dim; ++i) {
+    for (size_t k = 0; k < dim; ++k) {
+      if (in_a[i][k] == 0.0) {
+        continue;
+      }
+      for (size_t j = 0; j < dim; ++j) {
+        result[i][j] += in_a[i][k] * in_b[k][j];
+      }
+    }
+  }
+  return result;
+}
+
+// Kronecker product (in_a acts on the most significant bit).
+Matrix kron(const Matrix &in_a, const Matrix &in_b) {
+  const size_t dimB = in_b.size();
+  const size_t dim = in_a.size() * dimB;
+  Matrix result(dim, std::vector<std::complex<double>>(dim, 0.0));
+  for (size_t i = 0; i < dim; ++i) {
+    for (size_t j = 0; j < dim; ++j) {
+      result[i][j] = in_a[i / dimB][j / dimB] * in_b[i % dimB][j % dimB];
+    }
+  }
+  return result;
+}
+
+Matrix identity(size_t in_dim) {
+  Matrix result(in_dim, std::vector<std::complex<double>>(in_dim, 0.0));
+  for (size_t i = 0; i < in_dim; ++i) {
+    result[i][i] = 1.0;
+  }
+  return result;
+}
+
+bool isIdentity(const Matrix &in_mat) {
+  for (size_t i = 0; i < in_mat.size(); ++i) {
+    for (size_t j = 0; j < in_mat.size(); ++j) {
+      const std::complex<double> expected = (i == j) ? 1.0 : 0.0;
+      if (std::abs(in_mat[i][j] - expected) > IDENTITY_TOLERANCE) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Swaps the roles of the two qubits of a two-qubit gate matrix (SWAP.M.SWAP).
+Matrix swapQubitOrder(const Matrix &in_mat) {
+  const auto permute = [](size_t idx) { return ((idx & 1) << 1) | (idx >> 1); };
+  Matrix result(4, std::vector<std::complex<double>>(4, 0.0));
+  for (size_t i = 0; i < 4; ++i) {
+    for (size_t j = 0; j < 4; ++j) {
+      result[i][j] = in_mat[permute(i)][permute(j)];
+    }
+  }
+  return result;
+}
+
+// Gate matrix (bits()[0] is the MSB for two-qubit gates),
+// empty if the instruction cannot be fused.
+Matrix getFusableGateMatrix(xacc::Instruction &in_inst) {
+  using tnqvm::CommonGates;
+  using tnqvm::GetGateMatrix;
+  std::vector<double> params;
+  for (auto &param : in_inst.getParameters()) {
+    if (!param.isNumeric()) {
+      // e.g. symbolic parameters
+      return {};
+    }
+    params.emplace_back(xacc::InstructionParameterToDouble(param));
+  }
+  switch (tnqvm::GetGateType(in_inst.name())) {
+  case CommonGates::I: return GetGateMatrix<CommonGates::I>();
+  case CommonGates::H: return GetGateMatrix<CommonGates::H>();
+  case CommonGates::X: return GetGateMatrix<CommonGates::X>();
+  case CommonGates::Y: return GetGateMatrix<CommonGates::Y>();
+  case CommonGates::Z: return GetGateMatrix<CommonGates::Z>();
+  case CommonGates::T: return GetGateMatrix<CommonGates::T>();
+  case CommonGates::Tdg: return GetGateMatrix<CommonGates::Tdg>();
+  case CommonGates::Rx: return GetGateMatrix<CommonGates::Rx>(params[0]);
+  case CommonGates::Ry: return GetGateMatrix<CommonGates::Ry>(params[0]);
+  case CommonGates::Rz: return GetGateMatrix<CommonGates::Rz>(params[0]);
+  case CommonGates::U:
+    return GetGateMatrix<CommonGates::U>(params[0], params[1], params[2]);
+  case CommonGates::CNOT: return GetGateMatrix<CommonGates::CNOT>();
+  case CommonGates::CZ: return GetGateMatrix<CommonGates::CZ>();
+  case CommonGates::CPhase: return GetGateMatrix<CommonGates::CPhase>(params[0]);
+  case CommonGates::Swap: return GetGateMatrix<CommonGates::Swap>();
+  case CommonGates::iSwap: return GetGateMatrix<CommonGates::iSwap>();
+  case CommonGates::fSim:
+    return GetGateMatrix<CommonGates::fSim>(params[0], params[1]);
+  default: return {};
+  }
+}
+
+// An operation in the fused circuit (before conversion to FusedOperation).
+struct FusionNode {
+  std::shared_ptr<xacc::Instruction> instruction;
+  std::vector<size_t> bits;
+  Matrix matrix;
+  // Number of original gates in this node.
+  int nbGates = 0;
+  bool removed = false;
+};
+
+// Single-qubit gates waiting to be absorbed (product, in circuit order).
+struct PendingGates {
+  Matrix matrix;
+  std::shared_ptr<xacc::Instruction> instruction;
+  int nbGates = 0;
+};
+
+class GateFuser {
+public:
+  void addInstruction(const std::shared_ptr<xacc::Instruction> &in_inst) {
+    const auto bits = in_inst->bits();
+    const auto gateMatrix =
+        (bits.size() == 1 || bits.size() == 2) ? getFusableGateMatrix(*in_inst)
+                                               : Matrix{};
+    if (gateMatrix.empty() || gateMatrix.size() != (1ULL << bits.size())) {
+      // Barrier: flush everything on these qubits and keep the instruction.
+      for (const auto &bit : bits) {
+        flush(bit);
+        m_lastNode[bit] = NO_OPERATION;
+      }
+      FusionNode node;
+      node.instruction = in_inst;
+      node.nbGates = 1;
+      m_nodes.emplace_back(std::move(node));
+      return;
+    }
+
+    if (bits.size() == 1) {
+      auto &pending = m_pending[bits[0]];
+      pending.matrix = pending.nbGates == 0
+                           ? gateMatrix
+                           : matMul(gateMatrix, pending.matrix);
+      pending.instruction = in_inst;
+      pending.nbGates++;
+      return;
+    }
+
+    // Two-qubit gate: absorb the pending single-qubit gates on its qubits.
+    FusionNode node;
+    node.instruction = in_inst;
+    node.bits = {bits[0], bits[1]};
+    node.matrix = gateMatrix;
+    node.nbGates = 1;
+    const Matrix pendingMsb = takePending(bits[0], node.nbGates);
+    const Matrix pendingLsb = takePending(bits[1], node.nbGates);
+    if (node.nbGates > 1) {
+      node.matrix = matMul(node.matrix, kron(pendingMsb, pendingLsb));
+    }
+
+    // Merge with the previous two-qubit op on the same qubit pair.
+    const int lastNodeId = lastNode(bits[0]);
+    if (lastNodeId != NO_OPERATION && lastNodeId == lastNode(bits[1])) {
+      auto &lastNode = m_nodes[lastNodeId];
+      const Matrix matrix = lastNode.bits[0] == bits[0]
+                                ? node.matrix
+                                : swapQubitOrder(node.matrix);
+      lastNode.matrix = matMul(matrix, lastNode.matrix);
+      lastNode.nbGates += node.nbGates;
+      if (isIdentity(lastNode.matrix)) {
+        lastNode.removed = true;
+        m_lastNode[bits[0]] = NO_OPERATION;
+        m_lastNode[bits[1]] = NO_OPERATION;
+      }
+      return;
+    }
+
+    m_nodes.emplace_back(std::move(node));
+    m_lastNode[bits[0]] = m_nodes.size() - 1;
+    m_lastNode[bits[1]] = m_nodes.size() - 1;
+  }
+
+  std::vector<tnqvm::FusedOperation> finalize() {
+    std::vector<size_t> pendingQubits;
+    for (const auto &iter : m_pending) {
+      pendingQubits.emplace_back(iter.first);
+    }
+    std::sort(pendingQubits.begin(), pendingQubits.end());
+    for (const auto &qubit : pendingQubits) {
+      flush(qubit);
+    }
+
+    std::vector<tnqvm::FusedOperation> result;
+    for (auto &node : m_nodes) {
+      if (node.removed) {
+        continue;
+      }
+      tnqvm::FusedOperation op;
+      if (node.nbGates == 1) {
+        // Nothing has been fused: keep the original instruction.
+        op.instruction = node.instruction;
+      } else {
+        op.bits = std::move(node.bits);
+        op.matrix = std::move(node.matrix);
+      }
+      result.emplace_back(std::move(op));
+    }
+    return result;
+  }
+
+private:
+  int lastNode(size_t in_qubit) const {
+    const auto iter = m_lastNode.find(in_qubit);
+    return iter == m_lastNode.end() ? NO_OPERATION : iter->second;
+  }
+
+  // Removes the pending single-qubit gates on a qubit, returns their product.
+  Matrix takePending(size_t in_qubit, int &io_nbGates) {
+    const auto iter = m_pending.find(in_qubit);
+    if (iter == m_pending.end()) {
+      return identity(2);
+    }
+    io_nbGates += iter->second.nbGates;
+    Matrix matrix = std::move(iter->second.matrix);
+    m_pending.erase(iter);
+    return matrix;
+  }
+
+  // Emits the pending single-qubit gates on a qubit: absorbed into the last
+  // two-qubit op on that qubit if any, else as a single-qubit op.
+  void flush(size_t in_qubit) {
+    const auto iter = m_pending.find(in_qubit);
+    if (iter == m_pending.end()) {
+      return;
+    }
+    PendingGates pending = std::move(iter->second);
+    m_pending.erase(iter);
+    const int lastNodeId = lastNode(in_qubit);
+    if (lastNodeId != NO_OPERATION) {
+      // Nothing else acted on this qubit after that node.
+      auto &lastNode = m_nodes[lastNodeId];
+      const Matrix gateMatrix = lastNode.bits[0] == in_qubit
+                                    ? kron(pending.matrix, identity(2))
+                                    : kron(identity(2), pending.matrix);
+      lastNode.matrix = matMul(gateMatrix, lastNode.matrix);
+      lastNode.nbGates += pending.nbGates;
+      return;
+    }
+
+    if (isIdentity(pending.matrix)) {
+      return;
+    }
+    FusionNode node;
+    node.instruction = pending.instruction;
+    node.bits = {in_qubit};
+    node.matrix = std::move(pending.matrix);
+    node.nbGates = pending.nbGates;
+    m_nodes.emplace_back(std::move(node));
+  }
+
+private:
+  std::vector<FusionNode> m_nodes;
+  std::unordered_map<size_t, PendingGates> m_pending;
+  // Last (two-qubit) node acting on each qubit that can still absorb gates.
+  std::unordered_map<size_t, int> m_lastNode;
+};
+} // namespace
+
+namespace tnqvm {
+std::vector<FusedOperation> FuseGates(
+    const std::vector<std::shared_ptr<xacc::Instruction>> &in_instructions) {
+  GateFuser fuser;
+  for (const auto &inst : in_instructions) {
+    fuser.addInstruction(inst);
+  }
+  return fuser.finalize();
+}
+} // namespace tnqvm
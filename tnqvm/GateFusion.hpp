@@ -0,0 +1,61 @@
+/***********************************************************************************
+ * Copyright (c) 2017, UT-Battelle
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the xacc nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *   Implementation - Thien Nguyen
+ *
+ **********************************************************************************/
+#pragma once
+
+#include <complex>
+#include <memory>
+#include <vector>
+#include "Instruction.hpp"
+
+namespace tnqvm {
+// Gate fusion: a peephole pass over the (flattened) circuit before it is
+// handed to a visitor, to reduce the number of gate tensors in the network.
+// - Consecutive single-qubit gates on a qubit are multiplied into one matrix.
+// - Single-qubit gates are absorbed into the adjacent two-qubit gate (before
+//   or after it) and consecutive two-qubit gates on the same qubit pair are
+//   multiplied together.
+// - Products that are the identity (e.g. H-H, CNOT-CNOT, T-Tdg) are dropped.
+// Fused matrices are exact (incl. the global phase). Measurements and gates
+// that cannot be fused (e.g. symbolic parameters, 3-qubit gates) are kept in
+// place and act as fusion barriers on their qubits.
+struct FusedOperation {
+  // The original instruction if it was not fused with anything, else null.
+  std::shared_ptr<xacc::Instruction> instruction;
+  // Fused operation: qubits and unitary matrix.
+  // For two-qubit ops, bits[0] is the most significant bit of the matrix
+  // index, i.e. the same convention as the control qubit of a CNOT matrix.
+  std::vector<size_t> bits;
+  std::vector<std::vector<std::complex<double>>> matrix;
+};
+
+// Returns the fused operations, in execution order.
+std::vector<FusedOperation> FuseGates(
+    const std::vector<std::shared_ptr<xacc::Instruction>> &in_instructions);
+} // namespace tnqvm
@@ -0,0 +1,173 @@
+/***********************************************************************************
+ * Copyright (c) 2017, UT-Battelle
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the xacc nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *   Implementation - Thien Nguyen
+ *
+ **********************************************************************************/
+#include "PrefixSharing.hpp"
+#include "xacc.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <limits>
+#include <numeric>
+#include <sstream>
+
+namespace {
+// Length of the common prefix of two key sequences.
+size_t commonPrefixLength(const std::vector<std::string> &in_a,
+                          const std::vector<std::string> &in_b) {
+  const size_t maxLength = std::min(in_a.size(), in_b.size());
+  size_t length = 0;
+  while (length < maxLength && in_a[length] == in_b[length]) {
+    ++length;
+  }
+  return length;
+}
+} // namespace
+
+namespace tnqvm {
+std::string GetInstructionKey(const xacc::Instruction &in_inst) {
+  std::stringstream key;
+  key << std::setprecision(std::numeric_limits<double>::max_digits10)
+      << in_inst.name() << "(";
+  for (auto &param : in_inst.getParameters()) {
+    if (param.isNumeric()) {
+      key << xacc::InstructionParameterToDouble(param) << ",";
+    } else {
+      // e.g. symbolic parameters
+      key << param.toString() << ",";
+    }
+  }
+  key << ")";
+  for (const auto &bit : in_inst.bits()) {
+    key << " q" << bit;
+  }
+  return key.str();
+}
+
+PrefixSharingPlan
+PlanPrefixSharing(const std::vector<std::vector<std::string>> &in_kernelKeys) {
+  PrefixSharingPlan plan;
+  const size_t nbKernels = in_kernelKeys.size();
+  plan.order.resize(nbKernels);
+  std::iota(plan.order.begin(), plan.order.end(), 0);
+  // Depth-first traversal of the prefix trie: lexicographic order
+  // (stable, i.e. identical kernels keep their input order).
+  std::stable_sort(plan.order.begin(), plan.order.end(),
+                   [&](size_t in_lhs, size_t in_rhs) {
+                     return in_kernelKeys[in_lhs] < in_kernelKeys[in_rhs];
+                   });
+  // Common prefix length of consecutive kernels (in simulation order):
+  // in sorted order, the prefix shared by kernels i < j is the min over [i, j).
+  std::vector<size_t> nextPrefixLengths(nbKernels, 0);
+  for (size_t i = 0; i + 1 < nbKernels; ++i) {
+    nextPrefixLengths[i] = commonPrefixLength(in_kernelKeys[plan.order[i]],
+                                              in_kernelKeys[plan.order[i + 1]]);
+  }
+  plan.resumeDepths.resize(nbKernels, 0);
+  plan.snapshotDepths.resize(nbKernels);
+  for (size_t i = 0; i < nbKernels; ++i) {
+    plan.resumeDepths[i] = (i > 0) ? nextPrefixLengths[i - 1] : 0;
+    plan.nbInstructions += in_kernelKeys[plan.order[i]].size();
+    plan.nbSharedInstructions += plan.resumeDepths[i];
+    // A later kernel j resumes at the min over [i, j): snapshot each of these
+    // (non-increasing) depths beyond the one this kernel resumes from.
+    size_t depth = std::numeric_limits<size_t>::max();
+    for (size_t j = i; j + 1 < nbKernels; ++j) {
+      depth = std::min(depth, nextPrefixLengths[j]);
+      if (depth <= plan.resumeDepths[i]) {
+        break;
+      }
+      if (plan.snapshotDepths[i].empty() ||
+          plan.snapshotDepths[i].back() != depth) {
+        plan.snapshotDepths[i].emplace_back(depth);
+      }
+    }
+    std::reverse(plan.snapshotDepths[i].begin(), plan.snapshotDepths[i].end());
+  }
+  return plan;
+}
+
+std::vector<PrefixSharingPlan>
+PlanPrefixSharing(const std::vector<std::vector<std::string>> &in_kernelKeys,
+                  size_t in_nbParts) {
+  const auto plan = PlanPrefixSharing(in_kernelKeys);
+  const size_t nbKernels = plan.order.size();
+  if (in_nbParts < 2 || nbKernels < 2) {
+    return {plan};
+  }
+  // Greedy split (in simulation order) into groups of at most `in_maxCost`
+  // simulated instructions, returns the index of the first kernel of each group.
+  const auto split = [&](size_t in_maxCost) {
+    std::vector<size_t> groupStarts{0};
+    size_t cost = in_kernelKeys[plan.order[0]].size();
+    for (size_t i = 1; i < nbKernels; ++i) {
+      const size_t length = in_kernelKeys[plan.order[i]].size();
+      const size_t kernelCost = length - plan.resumeDepths[i];
+      if (cost + kernelCost > in_maxCost) {
+        groupStarts.emplace_back(i);
+        cost = length;
+      } else {
+        cost += kernelCost;
+      }
+    }
+    return groupStarts;
+  };
+  // Binary search of the smallest cost such that there are at most
+  // `in_nbParts` groups.
+  size_t lowCost = 0;
+  for (const auto &keys : in_kernelKeys) {
+    lowCost = std::max(lowCost, keys.size());
+  }
+  size_t highCost = std::max(lowCost, plan.nbInstructions - plan.nbSharedInstructions);
+  while (lowCost < highCost) {
+    const size_t midCost = lowCost + (highCost - lowCost) / 2;
+    if (split(midCost).size() <= in_nbParts) {
+      highCost = midCost;
+    } else {
+      lowCost = midCost + 1;
+    }
+  }
+  const auto groupStarts = split(lowCost);
+  std::vector<PrefixSharingPlan> plans;
+  for (size_t g = 0; g < groupStarts.size(); ++g) {
+    const size_t groupEnd =
+        (g + 1 < groupStarts.size()) ? groupStarts[g + 1] : nbKernels;
+    std::vector<size_t> kernelIndices(plan.order.begin() + groupStarts[g],
+                                      plan.order.begin() + groupEnd);
+    std::vector<std::vector<std::string>> groupKeys;
+    for (const auto &kernelIdx : kernelIndices) {
+      groupKeys.emplace_back(in_kernelKeys[kernelIdx]);
+    }
+    auto groupPlan = PlanPrefixSharing(groupKeys);
+    for (auto &kernelIdx : groupPlan.order) {
+      kernelIdx = kernelIndices[kernelIdx];
+    }
+    plans.emplace_back(std::move(groupPlan));
+  }
+  return plans;
+}
+} // namespace tnqvm
@@ -0,0 +1,75 @@
+/***********************************************************************************
+ * Copyright (c) 2017, UT-Battelle
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the xacc nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *   Implementation - Thien Nguyen
+ *
+ **********************************************************************************/
+#pragma once
+
+#include <string>
+#include <vector>
+#include "Instruction.hpp"
+
+namespace tnqvm {
+// Prefix sharing: kernels of a batch often share a long common prefix, e.g.
+// the same ansatz with different final rotations or parameter-shift variants.
+// The kernels are simulated in the order of a depth-first traversal of their
+// prefix trie (i.e. sorted by instruction keys); the visitor state is saved at
+// the branching points and each kernel resumes from the snapshot of the prefix
+// it shares with the kernels simulated before it.
+
+// Key of an instruction (name, qubits and parameters):
+// instructions with the same key have the same effect.
+std::string GetInstructionKey(const xacc::Instruction &in_inst);
+
+struct PrefixSharingPlan {
+  // Kernel indices, in simulation order.
+  std::vector<size_t> order;
+  // For each kernel in simulation order:
+  // number of instructions resumed from a snapshot (0: simulated from the start),
+  std::vector<size_t> resumeDepths;
+  // and the (ascending) depths at which to save a snapshot for the next kernels.
+  std::vector<std::vector<size_t>> snapshotDepths;
+  // Total number of instructions in the batch, and those that are not simulated.
+  size_t nbInstructions = 0;
+  size_t nbSharedInstructions = 0;
+};
+
+// Plans the simulation of kernels given their instruction key sequences.
+// Snapshots are stacked: before simulating a kernel, those deeper than its
+// resume depth are dropped and the top one is at its resume depth.
+PrefixSharingPlan
+PlanPrefixSharing(const std::vector<std::vector<std::string>> &in_kernelKeys);
+
+// Plans the simulation of kernels by (at most) `in_nbParts` independent
+// workers: the trie traversal order is split into contiguous groups, each
+// planned on its own (`order` refers to the input kernel indices). The split
+// minimizes the largest number of simulated instructions of a group (the first
+// kernel of a group is simulated from the start, i.e. its prefix is duplicated).
+std::vector<PrefixSharingPlan>
+PlanPrefixSharing(const std::vector<std::vector<std::string>> &in_kernelKeys,
+                  size_t in_nbParts);
+} // namespace tnqvm
@@ -30,6 +30,12 @@
  **********************************************************************************/
 #include "TNQVM.hpp"
 #include "IRUtils.hpp"
+#include "GateFusion.hpp"
+#include "PrefixSharing.hpp"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
 
 namespace {
 inline int getShotCountOption(const xacc::HeterogeneousMap &in_options) {
@@ -39,6 +45,266 @@ inline int getShotCountOption(const xacc::HeterogeneousMap &in_options) {
   }
   return result;
 }
+
+// MPS visitors only handle nearest-neighbor two-qubit gates, hence the kernel
+// is transformed (SWAP insertion) unless the visitor can apply long-range gates
+// natively and `long-range-gates` is not disabled.
+// The qubit layout may only be permuted (`lazy-permutation`) for complete
+// kernels, i.e. not for a VQE-mode base circuit whose observable sub-circuits
+// act on the original qubits.
+void applyNearestNeighborTransform(
+    const std::shared_ptr<xacc::CompositeInstruction> &in_kernel,
+    const std::shared_ptr<tnqvm::TNQVMVisitor> &in_visitor,
+    const xacc::HeterogeneousMap &in_options,
+    bool in_allowPermutation = true) {
+  if (in_visitor->name() != "itensor-mps" &&
+      in_visitor->name() != "exatn-mps" && in_visitor->name() != "exatn-pmps" &&
+      in_visitor->name() != "exatn-mps-traj") {
+    return;
+  }
+  if (in_visitor->supportLongRangeGates() &&
+      (!in_options.keyExists<bool>("long-range-gates") ||
+       in_options.get<bool>("long-range-gates"))) {
+    return;
+  }
+  // `lazy-permutation`: route against a tracked qubit layout instead of
+  // swapping back after each long-range gate (see NearestNeighborTransform.hpp).
+  // Noiseless visitors only: the noisy ones look up gate noise and readout
+  // errors by (physical) qubit, which the permuted layout would mismatch.
+  const bool lazyPermutation = in_allowPermutation &&
+                               in_options.keyExists<bool>("lazy-permutation") &&
+                               in_options.get<bool>("lazy-permutation");
+  if (lazyPermutation) {
+    if (in_visitor->name() != "itensor-mps" &&
+        in_visitor->name() != "exatn-mps") {
+      xacc::warning("'lazy-permutation' is not supported by the noisy visitor '" +
+                    in_visitor->name() +
+                    "', using the default transform instead.");
+    } else if (xacc::hasService<xacc::IRTransformation>("lnn-transform")) {
+      auto opt = xacc::getService<xacc::IRTransformation>("lnn-transform");
+      opt->apply(in_kernel, nullptr,
+                 {std::make_pair("max-distance", 1),
+                  std::make_pair("lazy-permutation", true)});
+      return;
+    } else {
+      xacc::warning("'lazy-permutation' requires the 'lnn-transform' service "
+                    "(ExaTN visitors), using the default transform instead.");
+    }
+  }
+  auto opt = xacc::getService<xacc::IRTransformation>("nnizer");
+  opt->apply(in_kernel, nullptr, {std::make_pair("max-distance", 1)});
+}
+
+// Attaches the metrics of a job to its buffer (numeric extra info):
+// `metrics:<counter>`, `metrics:<stage>:count` and `metrics:<stage>:seconds`.
+void addMetricsToBuffer(const std::shared_ptr<xacc::AcceleratorBuffer> &in_buffer,
+                        const tnqvm::MetricsRegistry::Snapshot &in_metrics) {
+  for (const auto &[name, value] : in_metrics.counters) {
+    in_buffer->addExtraInfo("metrics:" + name, value);
+  }
+  for (const auto &[name, histogram] : in_metrics.timings) {
+    in_buffer->addExtraInfo("metrics:" + name + ":count",
+                            static_cast<int>(histogram.count));
+    in_buffer->addExtraInfo("metrics:" + name + ":seconds", histogram.total);
+  }
+}
+
+bool isGateFusionEnabled(const std::shared_ptr<tnqvm::TNQVMVisitor> &in_visitor,
+                         const xacc::HeterogeneousMap &in_options) {
+  return in_visitor->supportGateFusion() &&
+         (!in_options.keyExists<bool>("gate-fusion") ||
+          in_options.get<bool>("gate-fusion"));
+}
+
+// Walks the IR tree and visits each (enabled) node.
+// If the visitor supports it, the gates are fused first (see GateFusion.hpp).
+void visitKernel(const std::shared_ptr<xacc::CompositeInstruction> &in_kernel,
+                 const std::shared_ptr<tnqvm::TNQVMVisitor> &in_visitor,
+                 const xacc::HeterogeneousMap &in_options,
+                 bool in_skipComposites) {
+  tnqvm::MetricsRegistry::ScopedTimer timer(in_visitor->name() + "::visit");
+  const bool fusionEnabled = isGateFusionEnabled(in_visitor, in_options);
+  InstructionIterator it(in_kernel);
+  if (!fusionEnabled) {
+    size_t nbVisited = 0;
+    while (it.hasNext()) {
+      auto nextInst = it.next();
+      if (nextInst->isEnabled() &&
+          !(in_skipComposites && nextInst->isComposite())) {
+        nextInst->accept(in_visitor);
+        ++nbVisited;
+      }
+    }
+    tnqvm::MetricsRegistry::get_instance().increment(
+        in_visitor->name() + "::gates", nbVisited);
+    return;
+  }
+
+  std::vector<std::shared_ptr<xacc::Instruction>> instructions;
+  while (it.hasNext()) {
+    auto nextInst = it.next();
+    if (nextInst->isEnabled() && !nextInst->isComposite()) {
+      instructions.emplace_back(nextInst);
+    }
+  }
+  const auto fusedOps = tnqvm::FuseGates(instructions);
+  xacc::info("Gate fusion: " + std::to_string(instructions.size()) + " -> " +
+             std::to_string(fusedOps.size()) + " operations.");
+  for (const auto &op : fusedOps) {
+    if (op.instruction) {
+      op.instruction->accept(in_visitor);
+    } else {
+      in_visitor->applyFusedGate(op.bits, op.matrix);
+    }
+  }
+  tnqvm::MetricsRegistry::get_instance().increment(
+      in_visitor->name() + "::gates", fusedOps.size());
+}
+
+// Initializes the visitor (timed as the `<visitor>::initialize` stage).
+void initializeVisitor(const std::shared_ptr<tnqvm::TNQVMVisitor> &in_visitor,
+                       std::shared_ptr<xacc::AcceleratorBuffer> in_buffer,
+                       int in_nbShots) {
+  tnqvm::MetricsRegistry::ScopedTimer timer(in_visitor->name() +
+                                            "::initialize");
+  in_visitor->initialize(in_buffer, in_nbShots);
+}
+
+// Finalizes the visitor (timed as the `<visitor>::finalize` stage).
+void finalizeVisitor(const std::shared_ptr<tnqvm::TNQVMVisitor> &in_visitor) {
+  tnqvm::MetricsRegistry::ScopedTimer timer(in_visitor->name() + "::finalize");
+  in_visitor->finalize();
+}
+
+// Simulates a kernel into its buffer: initialize, visit and finalize the
+// visitor. The kernel must have been transformed for the visitor already.
+void simulateKernel(const std::shared_ptr<xacc::CompositeInstruction> &in_kernel,
+                    const std::shared_ptr<tnqvm::TNQVMVisitor> &in_visitor,
+                    std::shared_ptr<xacc::AcceleratorBuffer> in_buffer,
+                    const xacc::HeterogeneousMap &in_options) {
+  initializeVisitor(in_visitor, in_buffer, getShotCountOption(in_options));
+  in_visitor->setKernelName(in_kernel->name());
+  xacc::info("Number of instructions: " +
+             std::to_string(in_kernel->nInstructions()));
+  visitKernel(in_kernel, in_visitor, in_options, false);
+  finalizeVisitor(in_visitor);
+}
+
+// Number of kernels simulated concurrently in normal (non-VQE) mode:
+// `kernel-threads` if set, otherwise all hardware threads, except for seeded
+// runs (concurrent kernels draw their shots from the shared random engine in a
+// non-deterministic order).
+size_t getKernelThreadCount(const std::shared_ptr<tnqvm::TNQVMVisitor> &in_visitor,
+                            const xacc::HeterogeneousMap &in_options,
+                            size_t in_nbKernels) {
+  if (!in_visitor->supportConcurrentKernels() || in_nbKernels < 2) {
+    return 1;
+  }
+  int nbThreads = std::thread::hardware_concurrency();
+  if (in_options.keyExists<int>("kernel-threads")) {
+    nbThreads = in_options.get<int>("kernel-threads");
+  } else if (in_options.keyExists<int>("seed")) {
+    nbThreads = 1;
+  }
+  return std::min<size_t>(std::max(nbThreads, 1), in_nbKernels);
+}
+
+// Simulates the kernels concurrently, each into its own buffer: each worker
+// thread has its own visitor and picks the next kernel (in input order).
+// The first exception thrown by a worker is rethrown once all have stopped.
+void simulateKernelsConcurrently(
+    const std::vector<std::shared_ptr<xacc::CompositeInstruction>> &in_kernels,
+    const std::vector<std::shared_ptr<xacc::AcceleratorBuffer>> &in_buffers,
+    const std::vector<std::shared_ptr<tnqvm::TNQVMVisitor>> &in_visitors,
+    const xacc::HeterogeneousMap &in_options) {
+  assert(in_kernels.size() == in_buffers.size());
+  std::atomic<size_t> nextKernel{0};
+  std::vector<std::exception_ptr> errors(in_visitors.size());
+  std::vector<std::thread> workers;
+  workers.reserve(in_visitors.size());
+  for (size_t w = 0; w < in_visitors.size(); ++w) {
+    workers.emplace_back([&, w]() {
+      try {
+        for (size_t i = nextKernel++; i < in_kernels.size(); i = nextKernel++) {
+          simulateKernel(in_kernels[i], in_visitors[w], in_buffers[i],
+                         in_options);
+        }
+      } catch (...) {
+        errors[w] = std::current_exception();
+        // Stop the other workers early.
+        nextKernel = in_kernels.size();
+      }
+    });
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  for (const auto &error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
+// Simulates the kernels (already transformed for the visitor) by prefix sharing
+// (see PrefixSharing.hpp): each kernel resumes from the visitor state snapshot
+// of the prefix it shares with the previously simulated ones.
+void simulateKernelsWithSharedPrefixes(
+    const std::vector<std::shared_ptr<xacc::CompositeInstruction>> &in_kernels,
+    const std::vector<std::vector<std::shared_ptr<xacc::Instruction>>> &in_instructions,
+    const tnqvm::PrefixSharingPlan &in_plan,
+    const std::vector<std::shared_ptr<xacc::AcceleratorBuffer>> &in_buffers,
+    const std::shared_ptr<tnqvm::TNQVMVisitor> &in_visitor,
+    const xacc::HeterogeneousMap &in_options) {
+  // Snapshots (depth, state): only those deeper than the resume depth of the
+  // next kernel are dropped.
+  std::vector<std::pair<size_t, std::shared_ptr<tnqvm::VisitorState>>> snapshots;
+  for (size_t i = 0; i < in_plan.order.size(); ++i) {
+    const size_t kernelIdx = in_plan.order[i];
+    const auto &instructions = in_instructions[kernelIdx];
+    const size_t resumeDepth = in_plan.resumeDepths[i];
+    while (!snapshots.empty() && snapshots.back().first > resumeDepth) {
+      snapshots.pop_back();
+    }
+    initializeVisitor(in_visitor, in_buffers[kernelIdx],
+                      getShotCountOption(in_options));
+    in_visitor->setKernelName(in_kernels[kernelIdx]->name());
+    if (resumeDepth > 0) {
+      assert(!snapshots.empty() && snapshots.back().first == resumeDepth);
+      in_visitor->restoreState(snapshots.back().second);
+    }
+    {
+      tnqvm::MetricsRegistry::ScopedTimer timer(in_visitor->name() + "::visit");
+      auto snapshotIter = in_plan.snapshotDepths[i].begin();
+      for (size_t depth = resumeDepth;; ++depth) {
+        if (snapshotIter != in_plan.snapshotDepths[i].end() &&
+            *snapshotIter == depth) {
+          snapshots.emplace_back(depth, in_visitor->saveState());
+          ++snapshotIter;
+        }
+        if (depth == instructions.size()) {
+          break;
+        }
+        instructions[depth]->accept(in_visitor);
+      }
+      tnqvm::MetricsRegistry::get_instance().increment(
+          in_visitor->name() + "::gates", instructions.size() - resumeDepth);
+    }
+    finalizeVisitor(in_visitor);
+  }
+  tnqvm::MetricsRegistry::get_instance().increment(
+      "prefix-sharing:shared-gates", in_plan.nbSharedInstructions);
+}
+
+// Evaluates the observable sub-circuits in VQE mode
+// (timed as the `<visitor>::observables` stage).
+std::vector<double> evaluateObservables(
+    const std::shared_ptr<tnqvm::TNQVMVisitor> &in_visitor,
+    const std::vector<std::shared_ptr<xacc::CompositeInstruction>> &in_obsCircuits) {
+  tnqvm::MetricsRegistry::ScopedTimer timer(in_visitor->name() +
+                                            "::observables");
+  return in_visitor->getExpectationValueZBatch(in_obsCircuits);
+}
 } // namespace
 namespace tnqvm {
 
@@ -47,6 +313,7 @@ const std::string TNQVM::DEFAULT_VISITOR_BACKEND = "itensor-mps";
 void TNQVM::execute(
     std::shared_ptr<AcceleratorBuffer> buffer,
     const std::vector<std::shared_ptr<xacc::CompositeInstruction>> functions) {
+  const auto metricsBefore = MetricsRegistry::get_instance().snapshot();
   visitor = xacc::getService<TNQVMVisitor>(getVisitorName())->clone();
   // If in VQE mode and there are more than one kernels
   if (vqeMode && functions.size() > 1 && visitor->supportVqeMode()) {
@@ -57,85 +324,58 @@ void TNQVM::execute(
     visitor->setOptions(options);
 
     // Nearest neighbor transform:
-    if (visitor->name() == "itensor-mps" || visitor->name() == "exatn-mps" ||
-        visitor->name() == "exatn-pmps") {
-      auto opt = xacc::getService<xacc::IRTransformation>("nnizer");
-      opt->apply(kernelDecomposed.getBase(), nullptr,
-                 {std::make_pair("max-distance", 1)});
-    }
+    applyNearestNeighborTransform(kernelDecomposed.getBase(), visitor, options,
+                                  false);
     // Initialize the visitor
-    visitor->initialize(buffer, getShotCountOption(options));
+    initializeVisitor(visitor, buffer, getShotCountOption(options));
     visitor->setKernelName(kernelDecomposed.getBase()->name());
     xacc::info("Number of instructions: " +
                std::to_string(kernelDecomposed.getBase()->nInstructions()));
     // Walk the base IR tree, and visit each node
-    InstructionIterator it(kernelDecomposed.getBase());
-    while (it.hasNext()) {
-      auto nextInst = it.next();
-      if (nextInst->isEnabled() && !nextInst->isComposite()) {
-        nextInst->accept(visitor);
-      }
-    }
+    visitKernel(kernelDecomposed.getBase(), visitor, options, true);
 
     // Now we have a wavefunction that represents execution of the ansatz.
     // Run the observable sub-circuits (change of basis + measurements)
     auto obsCircuits = kernelDecomposed.getObservedSubCircuits();
+    const auto expVals = evaluateObservables(visitor, obsCircuits);
+    assert(expVals.size() == obsCircuits.size());
     for (int i = 0; i < obsCircuits.size(); ++i) {
       auto tmpBuffer = std::make_shared<xacc::AcceleratorBuffer>(
           obsCircuits[i]->name(), buffer->size());
-      double e = visitor->getExpectationValueZ(obsCircuits[i]);
-      tmpBuffer->addExtraInfo("exp-val-z", e);
+      tmpBuffer->addExtraInfo("exp-val-z", expVals[i]);
       buffer->appendChild(obsCircuits[i]->name(), tmpBuffer);
     }
     // Finalize the visitor
-    visitor->finalize();
+    finalizeVisitor(visitor);
   }
   // Normal execution mode
   else {
-    for (auto f : functions) {
-      auto tmpBuffer =
-          std::make_shared<xacc::AcceleratorBuffer>(f->name(), buffer->size());
-      execute(tmpBuffer, f);
-      buffer->appendChild(f->name(), tmpBuffer);
-    }
+    executeKernels(buffer, functions);
   }
 
+  m_metrics = MetricsRegistry::get_instance().snapshot().since(metricsBefore);
+  addMetricsToBuffer(buffer, m_metrics);
   return;
 }
 
 void TNQVM::execute(std::shared_ptr<xacc::AcceleratorBuffer> buffer,
                     const std::shared_ptr<xacc::CompositeInstruction> kernel) {
+  const auto metricsBefore = MetricsRegistry::get_instance().snapshot();
   // Get the visitor backend
   visitor = xacc::getService<TNQVMVisitor>(getVisitorName());
   visitor->setOptions(options);
 
-  // Initialize the visitor
-  visitor->initialize(buffer, getShotCountOption(options));
-  visitor->setKernelName(kernel->name());
   // If this is an MPS visitor, transform the kernel to nearest-neighbor
   // Note: currently, we don't support MPS aggregated blocks (multiple qubit MPS
   // tensors in one block). Hence, the circuit must always be transformed into
-  // *nearest* neighbor only (distance = 1 for two-qubit gates).
-  if (visitor->name() == "itensor-mps" || visitor->name() == "exatn-mps" ||
-      visitor->name() == "exatn-pmps") {
-    auto opt = xacc::getService<xacc::IRTransformation>("nnizer");
-    opt->apply(kernel, nullptr, {std::make_pair("max-distance", 1)});
-    // std::cout << "After LNN transform: \n" << kernel->toString() << "\n";
-  }
+  // *nearest* neighbor only (distance = 1 for two-qubit gates),
+  // unless the visitor applies long-range gates natively.
+  applyNearestNeighborTransform(kernel, visitor, options);
 
-  // Walk the IR tree, and visit each node
-  xacc::info("Number of instructions: " +
-             std::to_string(kernel->nInstructions()));
-  InstructionIterator it(kernel);
-  while (it.hasNext()) {
-    auto nextInst = it.next();
-    if (nextInst->isEnabled()) {
-      nextInst->accept(visitor);
-    }
-  }
-
-  // Finalize the visitor
-  visitor->finalize();
+  // Initialize the visitor, walk the IR tree (visit each node) and finalize.
+  simulateKernel(kernel, visitor, buffer, options);
+  m_metrics = MetricsRegistry::get_instance().snapshot().since(metricsBefore);
+  addMetricsToBuffer(buffer, m_metrics);
 }
 
 void TNQVM::execute(
@@ -143,6 +383,7 @@ std::shared_ptr<AcceleratorBuffer> buffer,
           const std::shared_ptr<CompositeInstruction> baseCircuit,
           const std::vector<std::shared_ptr<CompositeInstruction>> basisRotations) {
 
+  const auto metricsBefore = MetricsRegistry::get_instance().snapshot();
   auto provider = xacc::getIRProvider("quantum");
   visitor = xacc::getService<TNQVMVisitor>(getVisitorName())->clone();
   // If in VQE mode and there are more than one kernels
@@ -150,55 +391,186 @@ std::shared_ptr<AcceleratorBuffer> buffer,
 
     visitor->setOptions(options);
     // Nearest neighbor transform:
-    if (visitor->name() == "itensor-mps" || visitor->name() == "exatn-mps" ||
-        visitor->name() == "exatn-pmps") {
-      auto opt = xacc::getService<xacc::IRTransformation>("nnizer");
-      opt->apply(baseCircuit, nullptr,
-                 {std::make_pair("max-distance", 1)});
-    }
+    applyNearestNeighborTransform(baseCircuit, visitor, options, false);
     // Initialize the visitor
-    visitor->initialize(buffer, getShotCountOption(options));
+    initializeVisitor(visitor, buffer, getShotCountOption(options));
     visitor->setKernelName(baseCircuit->name());
     xacc::info("Number of instructions: " +
                std::to_string(baseCircuit->nInstructions()));
     // Walk the base IR tree, and visit each node
-    InstructionIterator it(baseCircuit);
-    while (it.hasNext()) {
-      auto nextInst = it.next();
-      if (nextInst->isEnabled() && !nextInst->isComposite()) {
-        nextInst->accept(visitor);
-      }
-    }
+    visitKernel(baseCircuit, visitor, options, true);
 
     // Now we have a wavefunction that represents execution of the ansatz.
     // Run the observable sub-circuits (change of basis + measurements)
-    for (int i = 0; i < basisRotations.size(); ++i) {
+    std::vector<std::shared_ptr<CompositeInstruction>> obsCircuits;
+    for (const auto &basisRotation : basisRotations) {
+      auto obsCircuit = provider->createComposite(basisRotation->name());
+      obsCircuit->addInstructions(basisRotation->getInstructions());
+      obsCircuits.emplace_back(obsCircuit);
+    }
+    const auto expVals = evaluateObservables(visitor, obsCircuits);
+    assert(expVals.size() == obsCircuits.size());
+    for (int i = 0; i < obsCircuits.size(); ++i) {
       auto tmpBuffer = std::make_shared<xacc::AcceleratorBuffer>(
-          basisRotations[i]->name(), buffer->size());
-      auto obsCircuit = provider->createComposite(basisRotations[i]->name());
-      obsCircuit->addInstructions(basisRotations[i]->getInstructions());
-      double e = visitor->getExpectationValueZ(obsCircuit);
-      tmpBuffer->addExtraInfo("exp-val-z", e);
-      buffer->appendChild(obsCircuit->name(), tmpBuffer);
+          obsCircuits[i]->name(), buffer->size());
+      tmpBuffer->addExtraInfo("exp-val-z", expVals[i]);
+      buffer->appendChild(obsCircuits[i]->name(), tmpBuffer);
     }
     // Finalize the visitor
-    visitor->finalize();
+    finalizeVisitor(visitor);
   }
   // Normal execution mode
   else {
-    for (auto b : basisRotations) {
-      auto tmpBuffer =
-          std::make_shared<xacc::AcceleratorBuffer>(b->name(), buffer->size());
+    std::vector<std::shared_ptr<CompositeInstruction>> obsCircuits;
+    for (const auto &b : basisRotations) {
       auto obsCircuit = provider->createComposite(b->name());
       obsCircuit->addInstructions(b->getInstructions());
-      execute(tmpBuffer, obsCircuit);
-      buffer->appendChild(b->name(), tmpBuffer);
+      obsCircuits.emplace_back(obsCircuit);
     }
+    executeKernels(buffer, obsCircuits);
   }
 
+  m_metrics = MetricsRegistry::get_instance().snapshot().since(metricsBefore);
+  addMetricsToBuffer(buffer, m_metrics);
   return;
 }
 
+void TNQVM::executeKernels(
+    std::shared_ptr<AcceleratorBuffer> buffer,
+    const std::vector<std::shared_ptr<CompositeInstruction>> &kernels) {
+  const size_t nbThreads = getKernelThreadCount(visitor, options, kernels.size());
+  // Kernel transformations and visitor clones (service registry) are done here
+  // (single thread), the workers only simulate.
+  std::vector<std::shared_ptr<AcceleratorBuffer>> childBuffers;
+  childBuffers.reserve(kernels.size());
+  for (const auto &f : kernels) {
+    applyNearestNeighborTransform(f, visitor, options);
+    childBuffers.emplace_back(
+        std::make_shared<xacc::AcceleratorBuffer>(f->name(), buffer->size()));
+  }
+  // Hardware threads are split between the workers, i.e. nested parallelism
+  // (e.g. shot sampling within a visitor) collapses when all are busy.
+  const auto createWorkerVisitors = [&](size_t in_nbWorkers) {
+    std::vector<std::shared_ptr<TNQVMVisitor>> workerVisitors{visitor};
+    while (workerVisitors.size() < in_nbWorkers) {
+      workerVisitors.emplace_back(visitor->clone());
+    }
+    const size_t threadBudget = std::max<size_t>(
+        1, std::thread::hardware_concurrency() / in_nbWorkers);
+    for (auto &workerVisitor : workerVisitors) {
+      workerVisitor->setOptions(options);
+      workerVisitor->setThreadBudget(threadBudget);
+    }
+    return workerVisitors;
+  };
+  // Child buffers are appended in input order.
+  // Note: the metrics of concurrent kernels are only reported for the whole
+  // batch (parent buffer).
+  const auto appendChildBuffers = [&]() {
+    for (size_t i = 0; i < kernels.size(); ++i) {
+      buffer->appendChild(kernels[i]->name(), childBuffers[i]);
+    }
+  };
+
+  // Prefix sharing: if the visitor can snapshot its state, the kernels are
+  // split into (trie) groups, one per kernel thread, see PrefixSharing.hpp.
+  // It is used if it cuts the estimated number of instructions simulated per
+  // thread by at least a quarter (snapshots are not free) w.r.t. simulating
+  // whole kernels on the same number of threads.
+  const bool prefixSharing =
+      kernels.size() > 1 && visitor->supportStateSnapshot() &&
+      !isGateFusionEnabled(visitor, options) &&
+      (!options.keyExists<bool>("prefix-sharing") ||
+       options.get<bool>("prefix-sharing"));
+  if (prefixSharing) {
+    std::vector<std::vector<std::shared_ptr<Instruction>>> instructions;
+    std::vector<std::vector<std::string>> instructionKeys;
+    size_t maxKernelLength = 0;
+    for (const auto &f : kernels) {
+      instructions.emplace_back();
+      instructionKeys.emplace_back();
+      InstructionIterator it(f);
+      while (it.hasNext()) {
+        auto nextInst = it.next();
+        if (nextInst->isEnabled() && !nextInst->isComposite()) {
+          instructions.back().emplace_back(nextInst);
+          instructionKeys.back().emplace_back(GetInstructionKey(*nextInst));
+        }
+      }
+      maxKernelLength = std::max(maxKernelLength, instructions.back().size());
+    }
+    const auto plans = PlanPrefixSharing(instructionKeys, nbThreads);
+    size_t nbInstructions = 0;
+    size_t nbSimulatedInstructions = 0;
+    size_t prefixSharingCost = 0;
+    for (const auto &plan : plans) {
+      const size_t cost = plan.nbInstructions - plan.nbSharedInstructions;
+      nbInstructions += plan.nbInstructions;
+      nbSimulatedInstructions += cost;
+      prefixSharingCost = std::max(prefixSharingCost, cost);
+    }
+    const size_t kernelThreadsCost = std::max(
+        maxKernelLength, (nbInstructions + nbThreads - 1) / nbThreads);
+    if (4 * prefixSharingCost <= 3 * kernelThreadsCost) {
+      xacc::info("Prefix sharing: simulating " +
+                 std::to_string(nbSimulatedInstructions) + " out of " +
+                 std::to_string(nbInstructions) + " instructions on " +
+                 std::to_string(plans.size()) + " threads.");
+      const auto workerVisitors = createWorkerVisitors(plans.size());
+      if (plans.size() == 1) {
+        simulateKernelsWithSharedPrefixes(kernels, instructions, plans[0],
+                                          childBuffers, visitor, options);
+      } else {
+        // Groups are independent: one worker thread (and visitor) each.
+        std::vector<std::exception_ptr> errors(plans.size());
+        std::vector<std::thread> workers;
+        workers.reserve(plans.size());
+        for (size_t w = 0; w < plans.size(); ++w) {
+          workers.emplace_back([&, w]() {
+            try {
+              simulateKernelsWithSharedPrefixes(kernels, instructions, plans[w],
+                                                childBuffers, workerVisitors[w],
+                                                options);
+            } catch (...) {
+              errors[w] = std::current_exception();
+            }
+          });
+        }
+        for (auto &worker : workers) {
+          worker.join();
+        }
+        for (const auto &error : errors) {
+          if (error) {
+            std::rethrow_exception(error);
+          }
+        }
+      }
+      appendChildBuffers();
+      return;
+    }
+  }
+
+  if (nbThreads < 2) {
+    visitor->setOptions(options);
+    visitor->setThreadBudget(0);
+    for (size_t i = 0; i < kernels.size(); ++i) {
+      const auto metricsBefore = MetricsRegistry::get_instance().snapshot();
+      simulateKernel(kernels[i], visitor, childBuffers[i], options);
+      addMetricsToBuffer(
+          childBuffers[i],
+          MetricsRegistry::get_instance().snapshot().since(metricsBefore));
+    }
+    appendChildBuffers();
+    return;
+  }
+
+  xacc::info("Simulating " + std::to_string(kernels.size()) + " kernels on " +
+             std::to_string(nbThreads) + " threads.");
+  simulateKernelsConcurrently(kernels, childBuffers,
+                              createWorkerVisitors(nbThreads), options);
+  appendChildBuffers();
+}
+
 const std::vector<std::complex<double>>
 TNQVM::getAcceleratorState(std::shared_ptr<CompositeInstruction> program) {
   // Get the visitor backend
@@ -226,7 +598,7 @@ TNQVM::getAcceleratorState(std::shared_ptr<CompositeInstruction> program) {
   auto buffer = std::make_shared<xacc::AcceleratorBuffer>("q", maxBit + 1);
 
   // Initialize the visitor
-  visitor->initialize(buffer, getShotCountOption(options));
+  initializeVisitor(visitor, buffer, getShotCountOption(options));
 
   // Walk the IR tree, and visit each node
   InstructionIterator it(program);
@@ -238,7 +610,7 @@ TNQVM::getAcceleratorState(std::shared_ptr<CompositeInstruction> program) {
   }
 
   // Finalize the visitor
-  visitor->finalize();
+  finalizeVisitor(visitor);
 
   return visitor->getState();
 }
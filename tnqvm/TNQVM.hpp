@@ -35,6 +35,7 @@
 #include "xacc_service.hpp"
 #include "TNQVMVisitor.hpp"
 #include "RandomEngine.hpp"
+#include "MetricsRegistry.hpp"
 #include <cassert>
 
 // Documentation: https://xacc.readthedocs.io/en/latest/extensions.html#tnqvm
@@ -54,6 +55,18 @@ public:
     // Force a configuration update,
     // which will update the cache appropriately.
     updateConfiguration(params);
+    // Let the visitor backend start any expensive one-time setup (e.g. ExaTN
+    // runtime initialization) in the background while the kernels are being
+    // compiled. Can be opted out with {"prewarm", false}.
+    const bool prewarm =
+        !params.keyExists<bool>("prewarm") || params.get<bool>("prewarm");
+    if (prewarm) {
+      auto visitorService =
+          xacc::getService<TNQVMVisitor>(getVisitorName(), false);
+      if (visitorService) {
+        visitorService->prewarm(options);
+      }
+    }
   }
 
   // Update TNQVM configurations:
@@ -105,10 +118,6 @@ public:
       if (nbShots < 1) {
         xacc::error("Invalid 'shots' parameter.");
       }
-
-      if (nbShots > 1 && backendName == "itensor-mps") {
-        xacc::warning("Multi-shot simulation is not available for 'itensor-mps' backend. This option will be ignored. \nPlease use 'exatn' backend if you want to run multi-shot simulation.");
-      }
     }
 
     if (config.keyExists<int>("seed")) {
@@ -150,9 +159,27 @@ public:
 
   virtual ~TNQVM() {}
 
+  // Also returns the performance metrics of the last execution:
+  // - `metrics` (std::map<std::string, double>): counters, e.g. `contractions`,
+  //   `contract-flops` (FMA), `contract-bytes` (intermediates), `<visitor>::gates`.
+  //   Only whole tensor network evaluations (incl. expansions) are counted as
+  //   contractions, not the per-gate tensor contractions/SVDs of the MPS visitors;
+  // - `metrics-timings` (std::map<std::string, std::vector<double>>): per-stage
+  //   timing histograms {count, total, buckets...} (seconds, see
+  //   MetricsRegistry::BUCKET_BOUNDS). Min/max are only tracked process-wide,
+  //   hence not reported per execution.
   virtual HeterogeneousMap getExecutionInfo() const override {
     auto result = visitor->getExecutionInfo();
     result.insert("visitor", visitor->name());
+    result.insert("metrics", m_metrics.counters);
+    std::map<std::string, std::vector<double>> timings;
+    for (const auto &[name, histogram] : m_metrics.timings) {
+      std::vector<double> data{static_cast<double>(histogram.count),
+                               histogram.total};
+      data.insert(data.end(), histogram.buckets.begin(), histogram.buckets.end());
+      timings.emplace(name, std::move(data));
+    }
+    result.insert("metrics-timings", timings);
     return result;
   }
 
@@ -163,6 +190,15 @@ public:
   void unmute() { __verbose = 1; } // default to 1
 
 protected:
+  // Normal (non-VQE) mode: simulates independent kernels into child buffers
+  // (appended in input order), concurrently if the visitor supports it (see
+  // `kernel-threads`). If the visitor supports state snapshots (unless
+  // `prefix-sharing` is false), each thread may instead simulate a group of
+  // kernels, their shared prefixes only once, if that is estimated faster.
+  void executeKernels(
+      std::shared_ptr<AcceleratorBuffer> buffer,
+      const std::vector<std::shared_ptr<CompositeInstruction>> &kernels);
+
   std::shared_ptr<TNQVMVisitor> visitor;
 
 private:
@@ -182,6 +218,8 @@ private:
   int nbShots = -1;
   // Cache of the TNQVM options (to send on to the visitor)
   HeterogeneousMap options;
+  // Metrics recorded during the last execution.
+  MetricsRegistry::Snapshot m_metrics;
 };
 } // namespace tnqvm
 
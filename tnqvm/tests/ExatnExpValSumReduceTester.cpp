@@ -251,6 +251,48 @@ TEST(ExatnExpValSumReduceTester, testDeuteronH3) {
   }
 }
 
+TEST(ExatnExpValSumReduceTester, testConcurrentSlices) {
+  xacc::qasm(R"(
+        .compiler xasm
+        .circuit test_concurrent_slices
+        .qbit q
+        H(q[0]);
+        Ry(q[1], 0.3);
+        CNOT(q[0], q[1]);
+        Rx(q[2], -1.2);
+        CNOT(q[1], q[2]);
+        U(q[3], 1.5708,0,3.14159);
+        CNOT(q[2], q[3]);
+        Ry(q[4], 2.1);
+        CNOT(q[3], q[4]);
+        Rz(q[5], 0.7);
+        H(q[5]);
+        CNOT(q[4], q[5]);
+        H(q[0]);
+        H(q[5]);
+        Measure(q[0]);
+        Measure(q[2]);
+        Measure(q[4]);
+        Measure(q[5]);
+    )");
+  auto program = xacc::getCompiled("test_concurrent_slices");
+  // Validate with QPP
+  auto qpp = xacc::getAccelerator("qpp");
+  auto buffer_qpp = xacc::qalloc(6);
+  qpp->execute(buffer_qpp, program);
+  // The result must not depend on the number of slices in flight.
+  for (int nbConcurrentSlices : {1, 2, 4, 16}) {
+    auto accelerator = xacc::getAccelerator(
+        "tnqvm", {{"tnqvm-visitor", "exatn"},
+                  {"max-qubit", 4},
+                  {"max-concurrent-slices", nbConcurrentSlices}});
+    auto buffer = xacc::qalloc(6);
+    accelerator->execute(buffer, program);
+    EXPECT_NEAR(buffer->getExpectationValueZ(),
+                buffer_qpp->getExpectationValueZ(), 1e-6);
+  }
+}
+
 int main(int argc, char **argv) {
   xacc::Initialize();
   ::testing::InitGoogleTest(&argc, argv);
@@ -34,6 +34,11 @@
 #include "xacc.hpp"
 #include "base/Gates.hpp"
 #include "utils/GateMatrixAlgebra.hpp"
+#include "ExatnRuntime.hpp"
+#include <dirent.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
 
 using namespace tnqvm;
 using namespace xacc::quantum;
@@ -257,6 +262,107 @@ TEST(ExatnVisitorTester, checkDeuteuron) {
   }
 }
 
+TEST(ExatnVisitorTester, testLargeStateVectorKernels) {
+  // 15 qubits: above PARALLEL_STATE_VECTOR_SIZE, i.e. the multi-threaded kernels,
+  // checked against a naive (serial) gate application.
+  const size_t nbQubits = 15;
+  auto stateVector = AllocateStateVector(nbQubits);
+  for (size_t i = 0; i < nbQubits; ++i) {
+    ApplySingleQubitGate(stateVector, i, GetGateMatrix<CommonGates::Ry>(0.1 * (i + 1)));
+  }
+  const auto applyGateNaive = [](const StateVectorType& in_psi, size_t in_index, const GateMatrixType& in_mat) {
+    StateVectorType result(in_psi.size());
+    const size_t mask = 1ULL << in_index;
+    for (size_t k = 0; k < in_psi.size(); ++k) {
+      const size_t bit = (k & mask) ? 1 : 0;
+      result[k] = in_mat[bit][0] * in_psi[k & ~mask] + in_mat[bit][1] * in_psi[k | mask];
+    }
+    return result;
+  };
+  const auto applyCnotNaive = [](const StateVectorType& in_psi, size_t in_ctrl, size_t in_target) {
+    StateVectorType result(in_psi.size());
+    for (size_t k = 0; k < in_psi.size(); ++k) {
+      result[k] = ((k >> in_ctrl) & 1) ? in_psi[k ^ (1ULL << in_target)] : in_psi[k];
+    }
+    return result;
+  };
+  const auto expectSameState = [](const StateVectorType& in_lhs, const StateVectorType& in_rhs) {
+    ASSERT_EQ(in_lhs.size(), in_rhs.size());
+    for (size_t k = 0; k < in_lhs.size(); ++k) {
+      EXPECT_NEAR(std::abs(in_lhs[k] - in_rhs[k]), 0.0, 1e-12);
+    }
+  };
+
+  const auto uMat = GetGateMatrix<CommonGates::U>(0.3, 1.2, -0.7);
+  for (const size_t qubit : { 0, 7, 14 }) {
+    auto expected = applyGateNaive(stateVector, qubit, uMat);
+    ApplySingleQubitGate(stateVector, qubit, uMat);
+    expectSameState(stateVector, expected);
+  }
+  for (const auto& [ctrl, target] : std::vector<std::pair<size_t, size_t>>{ { 0, 14 }, { 14, 3 }, { 5, 6 } }) {
+    auto expected = applyCnotNaive(stateVector, ctrl, target);
+    ApplyCNOTGate(stateVector, ctrl, target);
+    expectSameState(stateVector, expected);
+  }
+
+  // Sampling (chunked cumulative distribution): two basis states in distant chunks.
+  StateVectorType twoStates(1ULL << nbQubits);
+  twoStates[1] = std::sqrt(0.25);
+  twoStates[(1ULL << nbQubits) - 1] = std::sqrt(0.75);
+  const std::vector<size_t> measBits{ 0, 1, 14 };
+  const int nbShots = 4096;
+  const auto samples = GenerateSamples(twoStates, nbShots, measBits);
+  ASSERT_EQ(samples.size(), nbShots);
+  int nbLowState = 0;
+  for (const auto& bitString : samples) {
+    EXPECT_TRUE(bitString == "100" || bitString == "111");
+    nbLowState += (bitString == "100") ? 1 : 0;
+  }
+  EXPECT_NEAR(static_cast<double>(nbLowState) / nbShots, 0.25, 0.05);
+
+  // Measurement: collapsed onto the measured value and renormalized.
+  const size_t measQubit = 9;
+  const bool result = ApplyMeasureOp(stateVector, measQubit);
+  double norm = 0.0;
+  for (size_t k = 0; k < stateVector.size(); ++k) {
+    norm += std::norm(stateVector[k]);
+    if (((k >> measQubit) & 1) != static_cast<size_t>(result)) {
+      EXPECT_EQ(std::norm(stateVector[k]), 0.0);
+    }
+  }
+  EXPECT_NEAR(norm, 1.0, 1e-9);
+}
+
+TEST(ExatnVisitorTester, testSplitStateVectorKernels) {
+  // Split (real/imag) layout: same gates as the interleaved kernels,
+  // both below and above PARALLEL_STATE_VECTOR_SIZE.
+  for (const size_t nbQubits : { 4, 15 }) {
+    auto stateVector = AllocateStateVector(nbQubits);
+    for (size_t i = 0; i < nbQubits; ++i) {
+      ApplySingleQubitGate(stateVector, i, GetGateMatrix<CommonGates::Ry>(0.1 * (i + 1)));
+    }
+    auto splitStateVector = ToSplitStateVector(stateVector);
+    ASSERT_EQ(splitStateVector.real.size(), stateVector.size());
+    ASSERT_EQ(splitStateVector.imag.size(), stateVector.size());
+
+    const auto uMat = GetGateMatrix<CommonGates::U>(0.3, 1.2, -0.7);
+    for (const size_t qubit : { size_t(0), nbQubits / 2, nbQubits - 1 }) {
+      ApplySingleQubitGate(stateVector, qubit, uMat);
+      ApplySingleQubitGate(splitStateVector, qubit, uMat);
+    }
+    for (const auto& [ctrl, target] : std::vector<std::pair<size_t, size_t>>{ { 0, nbQubits - 1 }, { nbQubits - 1, 1 }, { 2, 3 } }) {
+      ApplyCNOTGate(stateVector, ctrl, target);
+      ApplyCNOTGate(splitStateVector, ctrl, target);
+    }
+
+    const auto result = FromSplitStateVector(splitStateVector);
+    ASSERT_EQ(result.size(), stateVector.size());
+    for (size_t k = 0; k < stateVector.size(); ++k) {
+      EXPECT_NEAR(std::abs(result[k] - stateVector[k]), 0.0, 1e-12);
+    }
+  }
+}
+
 TEST(ExatnVisitorTester, testPostMeasurementSimulation) {
   // Test that after-measurement simulation mode,
   // i.e. multiple tensor evaluation runs on the backend.  
@@ -290,6 +396,40 @@ TEST(ExatnVisitorTester, testPostMeasurementSimulation) {
   }
 }
 
+TEST(ExatnVisitorTester, testMultiSegmentSimulation) {
+  // Gates after measurements: each segment continues from the state tensor
+  // of the previous evaluation.
+  auto qpu = xacc::getAccelerator("tnqvm", {std::make_pair("tnqvm-visitor", "exatn"), std::make_pair("shots", 1024)});
+  auto qubitReg = xacc::qalloc(4);
+  auto xasmCompiler = xacc::getCompiler("xasm");
+  auto ir = xasmCompiler->compile(R"(__qpu__ void testMultiSegment(qbit q) {
+    H(q[0]);
+    Measure(q[0]);
+    CNOT(q[0], q[1]);
+    Measure(q[1]);
+    CNOT(q[1], q[2]);
+    H(q[3]);
+    X(q[3]);
+    H(q[3]);
+    Measure(q[2]);
+    Measure(q[3]);
+  })", qpu);
+  auto program = ir->getComposites()[0];
+  qpu->execute(qubitReg, program);
+  // GHZ state on the first 3 qubits, q[3] = H.X.H |0> = Z |0> = |0>
+  // Bit i of a result is the i-th measured qubit (q[0] first).
+  const auto measurementCounts = qubitReg->getMeasurementCounts();
+  EXPECT_EQ(measurementCounts.size(), 2);
+  for (const auto &resultToCount : measurementCounts) {
+    EXPECT_TRUE(resultToCount.first == "0000" || resultToCount.first == "1110");
+  }
+  EXPECT_NEAR(qubitReg->computeMeasurementProbability("0000"), 0.5, 0.1);
+  EXPECT_NEAR(qubitReg->computeMeasurementProbability("1110"), 0.5, 0.1);
+  // One evaluation per segment: earlier segments are never contracted again.
+  const auto counters = qpu->getExecutionInfo().get<std::map<std::string, double>>("metrics");
+  EXPECT_DOUBLE_EQ(counters.at("contractions"), 3.0);
+}
+
 TEST(ExatnVisitorTester, testGrover) {
   // Test Grover's algorithm
   // Amplify the amplitude of number 6 (110) state 
@@ -653,6 +793,237 @@ TEST(ExatnVisitorTester, testBitStringAmplitude)
   }
 }
 
+TEST(ExatnVisitorTester, testContractionSeqCache)
+{
+  // Private (empty) cache directory, removed at the end of the test.
+  char cacheDirTemplate[] = "/tmp/tnqvm_contract_seq_cache_XXXXXX";
+  ASSERT_NE(mkdtemp(cacheDirTemplate), nullptr);
+  const std::string cacheDir = cacheDirTemplate;
+  const auto listCacheFiles = [&cacheDir]() {
+    std::vector<std::string> fileNames;
+    if (auto dir = opendir(cacheDir.c_str())) {
+      while (auto entry = readdir(dir)) {
+        const std::string fileName = entry->d_name;
+        if (fileName.size() > 5 && fileName.substr(fileName.size() - 5) == ".cseq") {
+          fileNames.emplace_back(cacheDir + "/" + fileName);
+        }
+      }
+      closedir(dir);
+    }
+    return fileNames;
+  };
+
+  auto xasmCompiler = xacc::getCompiler("xasm");
+  auto ir = xasmCompiler->compile(R"(__qpu__ void testGhzCache(qbit q) {
+    H(q[0]);
+    for (int i = 1; i < 40; i++) {
+      CX(q[0], q[i]);
+    }
+  })", nullptr);
+  auto program = ir->getComposites()[0];
+  const std::vector<int> bitstring(40, 1);
+  // Second run: the contraction sequence is loaded from the cache.
+  for (int run = 0; run < 2; ++run) {
+    auto qpu = xacc::getAccelerator(
+        "tnqvm", {std::make_pair("tnqvm-visitor", "exatn"),
+                  std::make_pair("bitstring", bitstring),
+                  std::make_pair("exatn-contract-seq-cache-dir", cacheDir)});
+    auto buffer = xacc::qalloc(40);
+    qpu->execute(buffer, program);
+    EXPECT_NEAR((*buffer)["amplitude-real"].as<double>(), M_SQRT1_2, 1e-6);
+    EXPECT_NEAR((*buffer)["amplitude-imag"].as<double>(), 0.0, 1e-6);
+    EXPECT_EQ(listCacheFiles().size(), 1);
+  }
+
+  if (auto dir = opendir(cacheDir.c_str())) {
+    while (auto entry = readdir(dir)) {
+      const std::string fileName = entry->d_name;
+      if (fileName != "." && fileName != "..") {
+        std::remove((cacheDir + "/" + fileName).c_str());
+      }
+    }
+    closedir(dir);
+  }
+  EXPECT_EQ(rmdir(cacheDir.c_str()), 0);
+}
+
+TEST(ExatnVisitorTester, testGateFusion)
+{
+  auto xasmCompiler = xacc::getCompiler("xasm");
+  auto ir = xasmCompiler->compile(R"(__qpu__ void testGateFusion(qbit q) {
+    H(q[0]);
+    T(q[0]);
+    H(q[0]);
+    Rz(q[1], 0.3);
+    Ry(q[1], -1.2);
+    Rz(q[1], 0.7);
+    CNOT(q[0], q[1]);
+    CNOT(q[0], q[1]);
+    CNOT(q[1], q[2]);
+    Rx(q[2], 0.5);
+    T(q[3]);
+    Tdg(q[3]);
+    H(q[3]);
+    CZ(q[2], q[3]);
+    U(q[2], 0.1, 0.2, 0.3);
+    CZ(q[3], q[2]);
+    fSim(q[0], q[3], 0.4, 0.9);
+    Y(q[0]);
+  })", nullptr);
+  auto program = ir->getComposites()[0];
+  // Amplitudes must be identical (incl. the global phase) w/ and w/o fusion.
+  for (int i = 0; i < 16; ++i) {
+    std::vector<int> bitstring;
+    for (int j = 0; j < 4; ++j) {
+      bitstring.emplace_back((i >> j) & 1);
+    }
+    std::vector<std::complex<double>> amplitudes;
+    for (const bool fusion : {false, true}) {
+      auto qpu = xacc::getAccelerator(
+          "tnqvm", {std::make_pair("tnqvm-visitor", "exatn"),
+                    std::make_pair("bitstring", bitstring),
+                    std::make_pair("gate-fusion", fusion)});
+      auto buffer = xacc::qalloc(4);
+      qpu->execute(buffer, program);
+      amplitudes.emplace_back((*buffer)["amplitude-real"].as<double>(),
+                              (*buffer)["amplitude-imag"].as<double>());
+    }
+    EXPECT_NEAR(amplitudes[0].real(), amplitudes[1].real(), 1e-9);
+    EXPECT_NEAR(amplitudes[0].imag(), amplitudes[1].imag(), 1e-9);
+  }
+}
+
+TEST(ExatnVisitorTester, testSharedRuntime)
+{
+  auto xasmCompiler = xacc::getCompiler("xasm");
+  auto ir = xasmCompiler->compile(R"(__qpu__ void testSharedRuntime(qbit q) {
+    H(q[0]);
+    CX(q[0], q[1]);
+    Measure(q[0]);
+    Measure(q[1]);
+  })", nullptr);
+  auto program = ir->getComposites()[0];
+  const auto runBell = [&](const std::string &visitor, int bufferSizeGb) {
+    auto qpu = xacc::getAccelerator(
+        "tnqvm", {std::make_pair("tnqvm-visitor", visitor),
+                  std::make_pair("shots", 1024),
+                  std::make_pair("exatn-buffer-size-gb", bufferSizeGb)});
+    auto buffer = xacc::qalloc(2);
+    qpu->execute(buffer, program);
+    EXPECT_NEAR(buffer->computeMeasurementProbability("00") +
+                    buffer->computeMeasurementProbability("11"),
+                1.0, 1e-12);
+  };
+  // All ExaTN visitors share the same runtime:
+  // a different buffer size request resizes it, the same one reuses it.
+  runBell("exatn", 2);
+  EXPECT_EQ(tnqvm::ExatnRuntime::get().getHostBufferSize(), 2 * (1LL << 30));
+  runBell("exatn-mps", 2);
+  EXPECT_EQ(tnqvm::ExatnRuntime::get().getHostBufferSize(), 2 * (1LL << 30));
+  runBell("exatn-mps", 1);
+  EXPECT_EQ(tnqvm::ExatnRuntime::get().getHostBufferSize(), 1LL << 30);
+  runBell("exatn", 1);
+  EXPECT_EQ(tnqvm::ExatnRuntime::get().getHostBufferSize(), 1LL << 30);
+}
+
+TEST(ExatnVisitorTester, testMetrics)
+{
+  auto xasmCompiler = xacc::getCompiler("xasm");
+  auto ir = xasmCompiler->compile(R"(__qpu__ void testMetrics(qbit q) {
+    H(q[0]);
+    CNOT(q[0], q[1]);
+    CNOT(q[1], q[2]);
+    Measure(q[0]);
+  })");
+  auto program = ir->getComposite("testMetrics");
+  auto accelerator = xacc::getAccelerator("tnqvm", {std::make_pair("tnqvm-visitor", "exatn")});
+  auto qreg = xacc::qalloc(3);
+  accelerator->execute(qreg, program);
+  const auto counters = accelerator->getExecutionInfo().get<std::map<std::string, double>>("metrics");
+  // Tensor network evaluations are counted along with their (estimated) cost.
+  ASSERT_TRUE(counters.count("contractions"));
+  EXPECT_GE(counters.at("contractions"), 1.0);
+  EXPECT_GT(counters.at("contract-flops"), 0.0);
+  EXPECT_GT(counters.at("contract-bytes"), 0.0);
+  EXPECT_DOUBLE_EQ((*qreg)["metrics:contractions"].as<double>(), counters.at("contractions"));
+}
+
+TEST(ExatnVisitorTester, testFrugalRejectionSampling)
+{
+  // Too many qubits for the state vector: shots are sampled from amplitude batches.
+  const int nbQubits = 52;
+  const int nbShots = 1024;
+  auto xasmCompiler = xacc::getCompiler("xasm");
+  auto ir = xasmCompiler->compile(R"(__qpu__ void testFrugalSampling(qbit q) {
+    for (int i = 0; i < 52; i++) {
+      H(q[i]);
+    }
+    Measure(q[0]);
+    Measure(q[1]);
+    Measure(q[2]);
+    Measure(q[3]);
+  })");
+  auto program = ir->getComposite("testFrugalSampling");
+  auto accelerator = xacc::getAccelerator("tnqvm", {std::make_pair("tnqvm-visitor", "exatn"),
+                                                    std::make_pair("shots", nbShots),
+                                                    std::make_pair("sampling-method", "frugal-rejection"),
+                                                    std::make_pair("sampling-open-qubits", 4),
+                                                    // Exact for the uniform distribution (2^n p(x) = 1)
+                                                    std::make_pair("frugal-rejection-factor", 1.0)});
+  auto qreg = xacc::qalloc(nbQubits);
+  accelerator->execute(qreg, program);
+  qreg->print();
+  const auto counts = qreg->getMeasurementCounts();
+  int totalCount = 0;
+  for (const auto& [bitString, count] : counts)
+  {
+    EXPECT_EQ(bitString.size(), 4);
+    totalCount += count;
+  }
+  EXPECT_EQ(totalCount, nbShots);
+  // Uniform distribution: all 16 outcomes (expected count: 64)
+  EXPECT_EQ(counts.size(), 16);
+  for (const auto& [bitString, count] : counts)
+  {
+    EXPECT_GT(count, 20);
+  }
+  const auto counters = accelerator->getExecutionInfo().get<std::map<std::string, double>>("metrics");
+  EXPECT_DOUBLE_EQ(counters.at("exatn::frugal-sampling:accepted"), nbShots);
+}
+
+TEST(ExatnVisitorTester, testSamplingPlanReuse)
+{
+  // Too many qubits for the state vector: each shot contracts one marginal network per measured qubit.
+  const int nbShots = 3;
+  auto xasmCompiler = xacc::getCompiler("xasm");
+  auto ir = xasmCompiler->compile(R"(__qpu__ void testSamplingPlanReuse(qbit q) {
+    H(q[0]);
+    for (int i = 1; i < 52; i++) {
+      CX(q[0], q[i]);
+    }
+    Measure(q[0]);
+    Measure(q[1]);
+    Measure(q[2]);
+  })");
+  auto program = ir->getComposite("testSamplingPlanReuse");
+  auto accelerator = xacc::getAccelerator("tnqvm", {std::make_pair("tnqvm-visitor", "exatn"),
+                                                    std::make_pair("shots", nbShots)});
+  auto qreg = xacc::qalloc(52);
+  accelerator->execute(qreg, program);
+  qreg->print();
+  int totalCount = 0;
+  for (const auto& [bitString, count] : qreg->getMeasurementCounts())
+  {
+    EXPECT_TRUE(bitString == "000" || bitString == "111");
+    totalCount += count;
+  }
+  EXPECT_EQ(totalCount, nbShots);
+  // The marginal networks of the first shot are optimized, the other shots reuse their plans.
+  const auto counters = accelerator->getExecutionInfo().get<std::map<std::string, double>>("metrics");
+  EXPECT_DOUBLE_EQ(counters.at("exatn::contract-seq-cache:misses"), 3.0);
+  EXPECT_DOUBLE_EQ(counters.at("exatn::contract-seq-cache:hits"), 3.0 * (nbShots - 1));
+}
+
 int main(int argc, char **argv) 
 {
   xacc::Initialize();
@@ -218,6 +218,132 @@ TEST(TNQVMTester, checkKernelExecution) {
   acc->execute(qreg1, f);
 }
 
+TEST(TNQVMTester, checkMetrics) {
+  auto acc = xacc::getAccelerator("tnqvm");
+  auto qreg = xacc::qalloc(2);
+  auto provider = xacc::getIRProvider("quantum");
+  auto f = provider->createComposite("bell", {});
+  f->addInstruction(provider->createInstruction("H", 0));
+  f->addInstruction(provider->createInstruction("CNOT", { 0, 1 }));
+  acc->execute(qreg, f);
+
+  // Per-job metrics: exported via the execution info and the buffer.
+  auto exeInfo = acc->getExecutionInfo();
+  const auto visitorName = exeInfo.getString("visitor");
+  const auto counters = exeInfo.get<std::map<std::string, double>>("metrics");
+  ASSERT_TRUE(counters.count(visitorName + "::gates"));
+  EXPECT_GT(counters.at(visitorName + "::gates"), 0.0);
+  const auto timings =
+      exeInfo.get<std::map<std::string, std::vector<double>>>("metrics-timings");
+  for (const std::string stage : { "::initialize", "::visit", "::finalize" }) {
+    ASSERT_TRUE(timings.count(visitorName + stage));
+    // A single call per stage
+    EXPECT_EQ(timings.at(visitorName + stage)[0], 1.0);
+  }
+  EXPECT_TRUE(qreg->hasExtraInfoKey("metrics:" + visitorName + "::gates"));
+  EXPECT_TRUE(qreg->hasExtraInfoKey("metrics:" + visitorName + "::finalize:seconds"));
+}
+
+TEST(TNQVMTester, checkConcurrentKernels) {
+  // Independent kernels (normal mode) simulated on multiple threads.
+  auto acc = xacc::getAccelerator("tnqvm", {std::make_pair("tnqvm-visitor", "itensor-mps"),
+                                            std::make_pair("vqe-mode", false),
+                                            std::make_pair("shots", 100),
+                                            std::make_pair("kernel-threads", 4),
+                                            std::make_pair("prefix-sharing", false)});
+  auto provider = xacc::getIRProvider("quantum");
+  const int nbKernels = 16;
+  std::vector<std::shared_ptr<xacc::CompositeInstruction>> kernels;
+  for (int i = 0; i < nbKernels; ++i) {
+    // Kernel i: X on the set bits of i
+    auto f = provider->createComposite("kernel_" + std::to_string(i), {});
+    for (int q = 0; q < 4; ++q) {
+      if ((i >> (3 - q)) & 1) {
+        f->addInstruction(provider->createInstruction("X", q));
+      }
+    }
+    // Long-range gate (nearest-neighbor transform) on an entangled pair: q0 = q3.
+    f->addInstruction(provider->createInstruction("CNOT", { 0, 3 }));
+    f->addInstruction(provider->createInstruction("CNOT", { 0, 3 }));
+    for (int q = 0; q < 4; ++q) {
+      f->addInstruction(provider->createInstruction("Measure", q));
+    }
+    kernels.emplace_back(f);
+  }
+  auto qreg = xacc::qalloc(4);
+  acc->execute(qreg, kernels);
+  // Reference: serial execution
+  acc->updateConfiguration({std::make_pair("kernel-threads", 1)});
+  auto qregSerial = xacc::qalloc(4);
+  acc->execute(qregSerial, kernels);
+  const auto children = qreg->getChildren();
+  const auto serialChildren = qregSerial->getChildren();
+  ASSERT_EQ(children.size(), nbKernels);
+  ASSERT_EQ(serialChildren.size(), nbKernels);
+  for (int i = 0; i < nbKernels; ++i) {
+    // Children in input order, each with its own (deterministic) result.
+    EXPECT_EQ(children[i]->name(), "kernel_" + std::to_string(i));
+    const auto counts = children[i]->getMeasurementCounts();
+    ASSERT_EQ(counts.size(), 1);
+    EXPECT_EQ(counts.begin()->second, 100);
+    EXPECT_EQ(counts, serialChildren[i]->getMeasurementCounts());
+  }
+}
+
+TEST(TNQVMTester, checkPrefixSharing) {
+  // Parameter-shift style batch: same ansatz, different final rotations.
+  auto provider = xacc::getIRProvider("quantum");
+  const std::vector<double> angles{-M_PI_2, -0.5, 0.0, 0.5, M_PI_2, M_PI};
+  std::vector<std::shared_ptr<xacc::CompositeInstruction>> kernels;
+  for (size_t i = 0; i < angles.size(); ++i) {
+    auto f = provider->createComposite("kernel_" + std::to_string(i), {});
+    for (int q = 0; q < 4; ++q) {
+      f->addInstruction(provider->createInstruction("H", q));
+    }
+    for (size_t layer = 0; layer < 4; ++layer) {
+      for (size_t q = 0; q < 3; ++q) {
+        f->addInstruction(provider->createInstruction("CNOT", { q, q + 1 }));
+        f->addInstruction(provider->createInstruction("Ry", { q + 1 }, { 0.1 * (layer + q + 1) }));
+      }
+    }
+    f->addInstruction(provider->createInstruction("Rx", { 0 }, { angles[i] }));
+    for (int q = 0; q < 4; ++q) {
+      f->addInstruction(provider->createInstruction("Measure", q));
+    }
+    kernels.emplace_back(f);
+  }
+
+  const auto runBatch = [&](bool in_prefixSharing, int in_nbThreads) {
+    auto acc = xacc::getAccelerator("tnqvm", {std::make_pair("tnqvm-visitor", "itensor-mps"),
+                                              std::make_pair("vqe-mode", false),
+                                              std::make_pair("kernel-threads", in_nbThreads),
+                                              std::make_pair("prefix-sharing", in_prefixSharing)});
+    auto qreg = xacc::qalloc(4);
+    acc->execute(qreg, kernels);
+    const auto counters = acc->getExecutionInfo().get<std::map<std::string, double>>("metrics");
+    std::vector<double> expVals;
+    for (const auto &child : qreg->getChildren()) {
+      expVals.emplace_back(child->getExpectationValueZ());
+    }
+    return std::make_pair(expVals, counters.at("itensor-mps::gates"));
+  };
+  const auto [sharedExpVals, sharedGates] = runBatch(true, 1);
+  const auto [expVals, gates] = runBatch(false, 1);
+  // Split into (3) groups of kernels sharing prefixes, one per thread.
+  const auto [threadedExpVals, threadedGates] = runBatch(true, 3);
+  ASSERT_EQ(sharedExpVals.size(), angles.size());
+  ASSERT_EQ(expVals.size(), angles.size());
+  ASSERT_EQ(threadedExpVals.size(), angles.size());
+  for (size_t i = 0; i < angles.size(); ++i) {
+    EXPECT_NEAR(sharedExpVals[i], expVals[i], 1e-9);
+    EXPECT_NEAR(threadedExpVals[i], expVals[i], 1e-9);
+  }
+  // The ansatz is only simulated once (once per thread).
+  EXPECT_LT(sharedGates, gates / 2);
+  EXPECT_GT(threadedGates, sharedGates);
+  EXPECT_LT(threadedGates, gates);
+}
+
 int main(int argc, char **argv) {
   xacc::Initialize(argc, argv);
   ::testing::InitGoogleTest(&argc, argv);
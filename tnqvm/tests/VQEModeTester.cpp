@@ -126,6 +126,47 @@ TEST(VQEModeTester, checkUcc)
     EXPECT_NEAR(-1.13717, (*buffer)["opt-val"].as<double>(), 1e-4);
 }
 
+TEST(VQEModeTester, checkBatchedBasisGroups)
+{
+    xacc::qasm(R"(
+        .compiler xasm
+        .circuit batch_ansatz
+        .qbit q
+        Ry(q[0], 0.3);
+        Rx(q[1], -0.7);
+        H(q[2]);
+        CNOT(q[0], q[1]);
+        CNOT(q[1], q[2]);
+        Ry(q[3], 1.1);
+        CNOT(q[2], q[3]);
+    )");
+    auto ansatz = xacc::getCompiled("batch_ansatz");
+    // Qubit-wise compatible terms (e.g. X0 X1, X0, Z2 Z3, Z3) share a basis change.
+    auto observable = xacc::quantum::getObservable("pauli", std::string(
+        "X0 X1 + X0 + Z2 Z3 + Z3 + Y0 Y1 + X0 Z1 Y2 + Z0 + Y2 Y3"));
+    auto kernels = observable->observe(ansatz);
+
+    for (const auto& visitorName : { "exatn:double", "exatn:float" }) {
+        auto vqeBuffer = xacc::qalloc(4);
+        auto vqeAcc = xacc::getAccelerator("tnqvm", {{"tnqvm-visitor", visitorName}, {"vqe-mode", true}});
+        vqeAcc->execute(vqeBuffer, kernels);
+
+        auto refBuffer = xacc::qalloc(4);
+        auto refAcc = xacc::getAccelerator("tnqvm", {{"tnqvm-visitor", visitorName}, {"vqe-mode", false}});
+        refAcc->execute(refBuffer, kernels);
+
+        const auto vqeChildren = vqeBuffer->getChildren();
+        const auto refChildren = refBuffer->getChildren();
+        ASSERT_EQ(vqeChildren.size(), kernels.size());
+        ASSERT_EQ(refChildren.size(), kernels.size());
+        for (size_t i = 0; i < kernels.size(); ++i) {
+            // Children are in the input (kernel) order.
+            EXPECT_EQ(vqeChildren[i]->name(), kernels[i]->name());
+            EXPECT_NEAR(vqeChildren[i]->getExpectationValueZ(), refChildren[i]->getExpectationValueZ(), 1e-5);
+        }
+    }
+}
+
 int main(int argc, char **argv) 
 {
     xacc::set_verbose(true);   
@@ -33,9 +33,13 @@
 #pragma once
 #include<complex>
 #include<vector>
+#include <algorithm>
 #include <assert.h>
 #include <chrono>
+#include <cmath>
 #include <functional>
+#include <iterator>
+#include <string>
 #include "RandomEngine.hpp"
 typedef std::vector<std::complex<double>> StateVectorType;
 typedef std::vector<std::vector<std::complex<double>>> GateMatrixType;
@@ -60,25 +64,50 @@ inline double generateRandomProbability()
   return rng.randProb();
 }
 
-void ApplySingleQubitGate(StateVectorType& io_psi, size_t in_index, const GateMatrixType& in_gateMatrix)
+// State vectors of at least this size are processed by multiple (OpenMP) threads.
+// Below that, the threading overhead outweighs the (memory-bound) gate update.
+constexpr int64_t PARALLEL_STATE_VECTOR_SIZE = 1LL << 14;
+
+// Complex multiplication w/o the NaN/Inf recovery of std::complex::operator*,
+// which prevents the compiler from vectorizing the kernels below.
+template<typename RealType>
+inline std::complex<RealType> MulNoCheck(const std::complex<RealType>& in_a, const std::complex<RealType>& in_b)
+{
+  return { in_a.real() * in_b.real() - in_a.imag() * in_b.imag(),
+           in_a.real() * in_b.imag() + in_a.imag() * in_b.real() };
+}
+
+// Applies a single-qubit gate in-place.
+// The state vector is split into blocks of 2 * k_range amplitudes: each amplitude pair (i, i + k_range)
+// in a block is updated independently, hence we parallelize over the blocks and
+// vectorize the (contiguous) inner loop.
+// Note: the element type can be std::complex<float> (e.g. single-precision state vectors).
+template<typename ElementType>
+void ApplySingleQubitGate(std::vector<ElementType>& io_psi, size_t in_index, const GateMatrixType& in_gateMatrix)
 {
   assert(in_gateMatrix.size() == 2 && in_gateMatrix[0].size() == 2 &&  in_gateMatrix[1].size() == 2);
-  const uint64_t N = io_psi.size();
-  const uint64_t k_range = 1ULL << in_index;
+  const int64_t N = io_psi.size();
+  const int64_t k_range = 1LL << in_index;
+  const int64_t nbBlocks = N / (2 * k_range);
+  const ElementType m00 = static_cast<ElementType>(in_gateMatrix[0][0]);
+  const ElementType m01 = static_cast<ElementType>(in_gateMatrix[0][1]);
+  const ElementType m10 = static_cast<ElementType>(in_gateMatrix[1][0]);
+  const ElementType m11 = static_cast<ElementType>(in_gateMatrix[1][1]);
+  ElementType* psi = io_psi.data();
 
-  auto stateVectorCopy = io_psi;
-  for (uint64_t g = 0; g < N; g += (k_range * 2))
+  // See https://arxiv.org/pdf/1601.07195.pdf Figure 2 for pseudo-code
+#pragma omp parallel for collapse(2) if (N >= PARALLEL_STATE_VECTOR_SIZE)
+  for (int64_t b = 0; b < nbBlocks; ++b)
   {
-    for (uint64_t i = g; i < g + k_range; ++i)
+    for (int64_t i = 0; i < k_range; ++i)
     {
-      // See https://arxiv.org/pdf/1601.07195.pdf Figure 2 for pseudo-code
-      stateVectorCopy[i] = in_gateMatrix[0][0] * io_psi[i] + in_gateMatrix[0][1] * io_psi[i + k_range];
-      stateVectorCopy[i + k_range] = in_gateMatrix[1][0] * io_psi[i] + in_gateMatrix[1][1] * io_psi[i + k_range];
+      const int64_t i0 = b * 2 * k_range + i;
+      const ElementType psi0 = psi[i0];
+      const ElementType psi1 = psi[i0 + k_range];
+      psi[i0] = MulNoCheck(m00, psi0) + MulNoCheck(m01, psi1);
+      psi[i0 + k_range] = MulNoCheck(m10, psi0) + MulNoCheck(m11, psi1);
     }
   }
-
-  // Assign the result back to the state vector.
-  io_psi = stateVectorCopy;
 }
 
 void ApplyCNOTGate(StateVectorType& io_psi, size_t in_controlIndex, size_t in_targetIndex)
@@ -86,42 +115,124 @@ void ApplyCNOTGate(StateVectorType& io_psi, size_t in_controlIndex, size_t in_ta
   // Must have at least 2 qubits
   assert(io_psi.size() >= 4);
   // Qubit index
+  assert(io_psi.size() >= (1ULL << in_controlIndex));
   assert(io_psi.size() >= (1ULL << in_targetIndex));
-  assert(io_psi.size() >= (1ULL << in_targetIndex));
+  assert(in_controlIndex != in_targetIndex);
 
-  const uint64_t N = io_psi.size();
-  const uint64_t k_range = 1ULL << in_targetIndex;
-  const uint64_t ctrlmask = 1ULL << in_controlIndex;
   // Note: the effect of a CNOT gate is a remapping of state vector:
   // e.g. |1>|0> ==> |1>|1> (first qubit is the control), etc.
-  if (in_controlIndex > in_targetIndex)
+  // i.e. swap amplitudes (c = 1, t = 0) <=> (c = 1, t = 1).
+  // Enumerate the N/4 swap pairs by inserting the two bits into a compact index.
+  const int64_t nbPairs = io_psi.size() / 4;
+  const uint64_t ctrlmask = 1ULL << in_controlIndex;
+  const uint64_t targetmask = 1ULL << in_targetIndex;
+  const uint64_t lowMask = std::min(ctrlmask, targetmask) - 1;
+  const uint64_t highMask = std::max(ctrlmask, targetmask) - 1;
+  std::complex<double>* psi = io_psi.data();
+
+#pragma omp parallel for if (nbPairs >= PARALLEL_STATE_VECTOR_SIZE / 4)
+  for (int64_t j = 0; j < nbPairs; ++j)
   {
-    for (uint64_t g = ctrlmask; g < N; g += (ctrlmask * 2))
-    {
-      for (uint64_t i = 0; i < ctrlmask; i += (k_range * 2))
-      {
-        for (uint64_t ii = 0; ii < k_range; ++ii)
-        {
-          std::swap(io_psi[i + g + ii], io_psi[i + g + ii + k_range]);
-        }
-      }
-    }
+    // Insert a zero at the lower bit position, then at the higher bit position.
+    uint64_t idx = ((j & ~lowMask) << 1) | (j & lowMask);
+    idx = ((idx & ~highMask) << 1) | (idx & highMask);
+    idx |= ctrlmask;
+    std::swap(psi[idx], psi[idx | targetmask]);
+  }
+}
+
+// Structure-of-arrays (split real/imaginary) state vector:
+// Enables unit-stride SIMD loads/stores for the gate kernels (no complex shuffles),
+// at the cost of a conversion from/to the interleaved (std::complex) layout.
+struct SplitStateVectorType
+{
+  std::vector<double> real;
+  std::vector<double> imag;
+};
+
+inline SplitStateVectorType ToSplitStateVector(const StateVectorType& in_psi)
+{
+  SplitStateVectorType result;
+  result.real.resize(in_psi.size());
+  result.imag.resize(in_psi.size());
+  const int64_t N = in_psi.size();
+#pragma omp parallel for if (N >= PARALLEL_STATE_VECTOR_SIZE)
+  for (int64_t i = 0; i < N; ++i)
+  {
+    result.real[i] = in_psi[i].real();
+    result.imag[i] = in_psi[i].imag();
+  }
+  return result;
+}
+
+inline StateVectorType FromSplitStateVector(const SplitStateVectorType& in_psi)
+{
+  assert(in_psi.real.size() == in_psi.imag.size());
+  StateVectorType result(in_psi.real.size());
+  const int64_t N = result.size();
+#pragma omp parallel for if (N >= PARALLEL_STATE_VECTOR_SIZE)
+  for (int64_t i = 0; i < N; ++i)
+  {
+    result[i] = std::complex<double>(in_psi.real[i], in_psi.imag[i]);
   }
-  else
+  return result;
+}
+
+inline void ApplySingleQubitGate(SplitStateVectorType& io_psi, size_t in_index, const GateMatrixType& in_gateMatrix)
+{
+  assert(in_gateMatrix.size() == 2 && in_gateMatrix[0].size() == 2 &&  in_gateMatrix[1].size() == 2);
+  assert(io_psi.real.size() == io_psi.imag.size());
+  const int64_t N = io_psi.real.size();
+  const int64_t k_range = 1LL << in_index;
+  const int64_t nbBlocks = N / (2 * k_range);
+  const double m00r = in_gateMatrix[0][0].real(), m00i = in_gateMatrix[0][0].imag();
+  const double m01r = in_gateMatrix[0][1].real(), m01i = in_gateMatrix[0][1].imag();
+  const double m10r = in_gateMatrix[1][0].real(), m10i = in_gateMatrix[1][0].imag();
+  const double m11r = in_gateMatrix[1][1].real(), m11i = in_gateMatrix[1][1].imag();
+  double* re = io_psi.real.data();
+  double* im = io_psi.imag.data();
+
+#pragma omp parallel for collapse(2) if (N >= PARALLEL_STATE_VECTOR_SIZE)
+  for (int64_t b = 0; b < nbBlocks; ++b)
   {
-    for (uint64_t g = 0; g < N; g += (k_range * 2))
+    for (int64_t i = 0; i < k_range; ++i)
     {
-      for (uint64_t i = ctrlmask; i < k_range; i += (ctrlmask * 2))
-      {
-        for (uint64_t ii = 0; ii < ctrlmask; ++ii)
-        {
-          std::swap(io_psi[i + g + ii], io_psi[i + g + ii + k_range]);
-        }
-      }
+      const int64_t i0 = b * 2 * k_range + i;
+      const int64_t i1 = i0 + k_range;
+      const double r0 = re[i0], i0v = im[i0];
+      const double r1 = re[i1], i1v = im[i1];
+      re[i0] = m00r * r0 - m00i * i0v + m01r * r1 - m01i * i1v;
+      im[i0] = m00r * i0v + m00i * r0 + m01r * i1v + m01i * r1;
+      re[i1] = m10r * r0 - m10i * i0v + m11r * r1 - m11i * i1v;
+      im[i1] = m10r * i0v + m10i * r0 + m11r * i1v + m11i * r1;
     }
   }
 }
 
+inline void ApplyCNOTGate(SplitStateVectorType& io_psi, size_t in_controlIndex, size_t in_targetIndex)
+{
+  assert(io_psi.real.size() == io_psi.imag.size());
+  assert(io_psi.real.size() >= 4);
+  assert(in_controlIndex != in_targetIndex);
+  const int64_t nbPairs = io_psi.real.size() / 4;
+  const uint64_t ctrlmask = 1ULL << in_controlIndex;
+  const uint64_t targetmask = 1ULL << in_targetIndex;
+  const uint64_t lowMask = std::min(ctrlmask, targetmask) - 1;
+  const uint64_t highMask = std::max(ctrlmask, targetmask) - 1;
+  double* re = io_psi.real.data();
+  double* im = io_psi.imag.data();
+
+#pragma omp parallel for if (nbPairs >= PARALLEL_STATE_VECTOR_SIZE / 4)
+  for (int64_t j = 0; j < nbPairs; ++j)
+  {
+    uint64_t idx = ((j & ~lowMask) << 1) | (j & lowMask);
+    idx = ((idx & ~highMask) << 1) | (idx & highMask);
+    idx |= ctrlmask;
+    std::swap(re[idx], re[idx | targetmask]);
+    std::swap(im[idx], im[idx | targetmask]);
+  }
+}
+
 template <typename ElementType, typename IndexType>
 std::vector<std::string>
 GenerateSamples(const std::vector<ElementType> &state, uint64_t num_samples,
@@ -136,19 +247,65 @@ GenerateSamples(const std::vector<ElementType> &state, uint64_t num_samples,
     return result;
   };
   std::vector<std::string> bitstrings;
-  if (num_samples > 0) {
+  if (num_samples > 0 && !state.empty()) {
     const uint64_t size = state.size();
-    const auto rs =
-        tnqvm::randomEngine::get_instance().sortedRandProbs(num_samples);
-    bitstrings.reserve(num_samples);
-    double csum = 0.0;
-    uint64_t m = 0;
-    for (uint64_t k = 0; k < size; ++k) {
-      csum += std::norm(state[k]);
-      while (rs[m] < csum && m < num_samples) {
-        bitstrings.emplace_back(toBitString(k));
-        ++m;
+    auto rs = tnqvm::randomEngine::get_instance().sortedRandProbs(num_samples);
+    // Cumulative distribution in two passes:
+    // (1) partial sums of contiguous chunks (in parallel),
+    // (2) each chunk scans its own range starting from the prefix of the previous chunks,
+    // picking up the (sorted) random numbers which fall into that range.
+    const int64_t nbChunks = static_cast<int64_t>(size) >= PARALLEL_STATE_VECTOR_SIZE
+                                 ? (size / (PARALLEL_STATE_VECTOR_SIZE / 4))
+                                 : 1;
+    const uint64_t chunkSize = (size + nbChunks - 1) / nbChunks;
+    std::vector<double> chunkSums(nbChunks, 0.0);
+#pragma omp parallel for if (nbChunks > 1)
+    for (int64_t c = 0; c < nbChunks; ++c) {
+      double sum = 0.0;
+      const uint64_t end = std::min(size, (c + 1) * chunkSize);
+      for (uint64_t k = c * chunkSize; k < end; ++k) {
+        sum += std::norm(state[k]);
       }
+      chunkSums[c] = sum;
+    }
+    std::vector<double> chunkOffsets(nbChunks + 1, 0.0);
+    for (int64_t c = 0; c < nbChunks; ++c) {
+      chunkOffsets[c + 1] = chunkOffsets[c] + chunkSums[c];
+    }
+    // Scale the random numbers to the total norm (e.g. slightly off 1.0
+    // due to rounding) so that every shot is assigned to a state.
+    const double totalNorm = chunkOffsets[nbChunks];
+    for (auto &r : rs) {
+      r *= totalNorm;
+    }
+    // Samples are ordered by state index, as in a single serial scan.
+    std::vector<std::vector<std::string>> chunkSamples(nbChunks);
+#pragma omp parallel for if (nbChunks > 1)
+    for (int64_t c = 0; c < nbChunks; ++c) {
+      const uint64_t end = std::min(size, (c + 1) * chunkSize);
+      auto rIter = std::lower_bound(rs.begin(), rs.end(), chunkOffsets[c]);
+      const auto rEnd = (c == nbChunks - 1)
+                            ? rs.end()
+                            : std::lower_bound(rIter, rs.end(), chunkOffsets[c + 1]);
+      double csum = 0.0;
+      uint64_t lastNonZero = c * chunkSize;
+      for (uint64_t k = c * chunkSize; k < end && rIter != rEnd; ++k) {
+        const double prob = std::norm(state[k]);
+        lastNonZero = prob > 0.0 ? k : lastNonZero;
+        csum += prob;
+        while (rIter != rEnd && (*rIter - chunkOffsets[c]) < csum) {
+          chunkSamples[c].emplace_back(toBitString(k));
+          ++rIter;
+        }
+      }
+      // Rounding leftovers (if any)
+      for (; rIter != rEnd; ++rIter) {
+        chunkSamples[c].emplace_back(toBitString(lastNonZero));
+      }
+    }
+    bitstrings.reserve(num_samples);
+    for (auto &samples : chunkSamples) {
+      std::move(samples.begin(), samples.end(), std::back_inserter(bitstrings));
     }
   }
 
@@ -158,58 +315,131 @@ GenerateSamples(const std::vector<ElementType> &state, uint64_t num_samples,
 template<typename ElementType>
 bool ApplyMeasureOp(std::vector<ElementType>& io_psi, size_t in_qubitIndex)
 {
-  const auto N = io_psi.size();
-  const auto k_range = 1ULL << in_qubitIndex;
-  const double randProbPick = generateRandomProbability();
-  double cumulativeProb = 0.0;
-  size_t stateSelect = 0;
-  //select a state based on cumulative distribution
-  while (cumulativeProb < randProbPick && stateSelect < N)
+  const int64_t N = io_psi.size();
+  const int64_t k_range = 1LL << in_qubitIndex;
+  const int64_t nbBlocks = N / (2 * k_range);
+  // Probability of measuring 1 (and 0): single parallel reduction
+  double prob0 = 0.0;
+  double prob1 = 0.0;
+#pragma omp parallel for collapse(2) reduction(+:prob0,prob1) if (N >= PARALLEL_STATE_VECTOR_SIZE)
+  for (int64_t b = 0; b < nbBlocks; ++b)
   {
-    cumulativeProb += std::norm(io_psi[stateSelect++]);
+    for (int64_t i = 0; i < k_range; ++i)
+    {
+      const int64_t i0 = b * 2 * k_range + i;
+      prob0 += std::norm(io_psi[i0]);
+      prob1 += std::norm(io_psi[i0 + k_range]);
+    }
   }
-  stateSelect--;
 
+  const double randProbPick = generateRandomProbability();
   //take the value of the measured bit
-  bool result = ((stateSelect >> in_qubitIndex) & 1);
-  // Collapse the state vector according to the measurement result
-  double measProb = 0.0;
-  for (size_t g = 0; g < N; g += (k_range * 2))
+  const bool result = randProbPick * (prob0 + prob1) >= prob0;
+  // Collapse the state vector according to the measurement result and renormalize the state
+  const double measProb = std::sqrt(result ? prob1 : prob0);
+  const typename ElementType::value_type scale = 1.0 / measProb;
+  const int64_t keepOffset = result ? k_range : 0;
+  const int64_t zeroOffset = result ? 0 : k_range;
+#pragma omp parallel for collapse(2) if (N >= PARALLEL_STATE_VECTOR_SIZE)
+  for (int64_t b = 0; b < nbBlocks; ++b)
   {
-    for (size_t i = 0; i < k_range; ++i)
+    for (int64_t i = 0; i < k_range; ++i)
     {
-      if ((((i + g) >> in_qubitIndex) & 1) == result)
-      {
-        measProb += std::norm(io_psi[i + g]);
-        io_psi[i + g + k_range] = 0.0;
-      }
-      else
-      {
-        measProb += std::norm(io_psi[i + g + k_range]);
-        io_psi[i + g] = 0.0;
-      }
+      const int64_t i0 = b * 2 * k_range + i;
+      io_psi[i0 + keepOffset] *= scale;
+      io_psi[i0 + zeroOffset] = 0.0;
     }
   }
-  // Renormalize the state
-  measProb = std::sqrt(measProb);
-  for (size_t g = 0; g < N; g += (k_range * 2))
+
+  return result;
+}
+
+// Compensated (Neumaier) summation: keeps the exp-val-z reduction accurate
+// when summing 2^n terms of mixed signs.
+struct CompensatedSum
+{
+  double sum = 0.0;
+  double compensation = 0.0;
+  void add(double in_val)
   {
-    for (size_t i = 0; i < k_range; i += 1)
+    const double t = sum + in_val;
+    compensation += (std::fabs(sum) >= std::fabs(in_val)) ? ((sum - t) + in_val) : ((in_val - t) + sum);
+    sum = t;
+  }
+  double value() const { return sum + compensation; }
+};
+
+// Parity mask of a Pauli-Z string, i.e. bit q is set if Z acts on qubit q.
+template <typename IndexType>
+uint64_t ParityMask(const std::vector<IndexType>& in_bits)
+{
+  uint64_t mask = 0;
+  for (const auto& bit : in_bits)
+  {
+    mask |= (1ULL << bit);
+  }
+  return mask;
+}
+
+// Expectation values of a batch of Pauli-Z strings (as parity masks) in a single pass over the state vector:
+// <Z...Z> = sum_i (-1)^popcount(i & mask) |psi_i|^2
+// The vector is split into a fixed number of chunks (reduced in parallel),
+// then partial sums are combined in chunk order, i.e. the result doesn't depend on the number of threads.
+template <typename ElementType>
+std::vector<double> CalcExpValueZBatch(const ElementType* in_stateVec, uint64_t in_size, const std::vector<uint64_t>& in_parityMasks)
+{
+  const size_t nbMasks = in_parityMasks.size();
+  constexpr int64_t MAX_NB_CHUNKS = 1024;
+  const int64_t nbChunks = std::max<int64_t>(1, std::min<int64_t>(MAX_NB_CHUNKS, in_size / PARALLEL_STATE_VECTOR_SIZE));
+  const uint64_t chunkSize = (in_size + nbChunks - 1) / nbChunks;
+  std::vector<CompensatedSum> partialSums(nbChunks * nbMasks);
+#pragma omp parallel for if (nbChunks > 1)
+  for (int64_t c = 0; c < nbChunks; ++c)
+  {
+    CompensatedSum* sums = partialSums.data() + c * nbMasks;
+    const uint64_t end = std::min(in_size, (c + 1) * chunkSize);
+    for (uint64_t i = c * chunkSize; i < end; ++i)
     {
-      if ((((i + g) >> in_qubitIndex) & 1) == result)
+      const double prob = std::norm(in_stateVec[i]);
+      for (size_t m = 0; m < nbMasks; ++m)
       {
-        io_psi[i + g] /= measProb;
-      }
-      else
-      {
-        io_psi[i + g + k_range] /= measProb;
+        sums[m].add((__builtin_popcountll(i & in_parityMasks[m]) & 1) ? -prob : prob);
       }
     }
   }
 
+  std::vector<double> result(nbMasks);
+  for (size_t m = 0; m < nbMasks; ++m)
+  {
+    CompensatedSum total;
+    for (int64_t c = 0; c < nbChunks; ++c)
+    {
+      total.add(partialSums[c * nbMasks + m].sum);
+      total.add(partialSums[c * nbMasks + m].compensation);
+    }
+    result[m] = total.value();
+  }
   return result;
 }
 
+template <typename ElementType, typename IndexType>
+std::vector<double> CalcExpValueZBatch(const std::vector<ElementType>& in_stateVec, const std::vector<std::vector<IndexType>>& in_bitsList)
+{
+  std::vector<uint64_t> parityMasks;
+  parityMasks.reserve(in_bitsList.size());
+  for (const auto& bits : in_bitsList)
+  {
+    parityMasks.emplace_back(ParityMask(bits));
+  }
+  return CalcExpValueZBatch(in_stateVec.data(), in_stateVec.size(), parityMasks);
+}
+
+template <typename ElementType, typename IndexType>
+double CalcExpValueZ(const std::vector<ElementType>& in_stateVec, const std::vector<IndexType>& in_bits)
+{
+  return CalcExpValueZBatch(in_stateVec.data(), in_stateVec.size(), { ParityMask(in_bits) }).front();
+}
+
 StateVectorType AllocateStateVector(size_t in_nbQubits)
 {
   StateVectorType stateVector(1ULL << in_nbQubits);
@@ -0,0 +1,142 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+namespace tnqvm {
+// Process-wide performance metrics, shared by TNQVM and all visitors:
+// - counters (e.g. gates, contractions, FMA flops, bytes), accumulated as doubles;
+// - timing histograms (count, total, min, max and decade buckets from 1us to 10s).
+// Recording is a single (uncontended) lock + hash lookup, i.e. cheap enough to be always on.
+struct MetricsRegistry {
+  // Upper bounds (seconds) of the histogram buckets, the last bucket is unbounded.
+  static constexpr std::array<double, 8> BUCKET_BOUNDS{1e-6, 1e-5, 1e-4, 1e-3,
+                                                       1e-2, 1e-1, 1.0,  10.0};
+  static constexpr size_t NB_BUCKETS = BUCKET_BOUNDS.size() + 1;
+
+  struct Histogram {
+    uint64_t count = 0;
+    double total = 0.0;
+    double min = std::numeric_limits<double>::max();
+    double max = 0.0;
+    std::array<uint64_t, NB_BUCKETS> buckets{};
+
+    void add(double in_seconds) {
+      ++count;
+      total += in_seconds;
+      min = std::min(min, in_seconds);
+      max = std::max(max, in_seconds);
+      size_t bucket = 0;
+      while (bucket < BUCKET_BOUNDS.size() && in_seconds >= BUCKET_BOUNDS[bucket]) {
+        ++bucket;
+      }
+      ++buckets[bucket];
+    }
+  };
+
+  struct Snapshot {
+    std::map<std::string, double> counters;
+    std::map<std::string, Histogram> timings;
+
+    // Metrics recorded after `in_before` was taken.
+    // Note: min/max are those of the later snapshot (not recoverable per interval).
+    Snapshot since(const Snapshot &in_before) const {
+      Snapshot result;
+      for (const auto &[name, value] : counters) {
+        const auto iter = in_before.counters.find(name);
+        const double delta = value - (iter == in_before.counters.end() ? 0.0 : iter->second);
+        if (delta != 0.0) {
+          result.counters.emplace(name, delta);
+        }
+      }
+      for (const auto &[name, histogram] : timings) {
+        const auto iter = in_before.timings.find(name);
+        if (iter == in_before.timings.end()) {
+          result.timings.emplace(name, histogram);
+          continue;
+        }
+        if (histogram.count == iter->second.count) {
+          continue;
+        }
+        Histogram delta = histogram;
+        delta.count -= iter->second.count;
+        delta.total -= iter->second.total;
+        for (size_t i = 0; i < NB_BUCKETS; ++i) {
+          delta.buckets[i] -= iter->second.buckets[i];
+        }
+        result.timings.emplace(name, delta);
+      }
+      return result;
+    }
+  };
+
+  // Times a scope into the histogram of the given name.
+  class ScopedTimer {
+  public:
+    explicit ScopedTimer(std::string in_name)
+        : m_name(std::move(in_name)),
+          m_start(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() {
+      const std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - m_start;
+      MetricsRegistry::get_instance().addTiming(m_name, elapsed.count());
+    }
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+  private:
+    std::string m_name;
+    std::chrono::steady_clock::time_point m_start;
+  };
+
+  MetricsRegistry(const MetricsRegistry &) = delete;
+  MetricsRegistry &operator=(const MetricsRegistry &) = delete;
+
+  static MetricsRegistry &get_instance() {
+    static MetricsRegistry instance;
+    return instance;
+  }
+
+  void increment(const std::string &in_name, double in_value = 1.0) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_counters[in_name] += in_value;
+  }
+
+  void addTiming(const std::string &in_name, double in_seconds) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_timings[in_name].add(in_seconds);
+  }
+
+  template <typename TimePoint>
+  void addTiming(const std::string &in_name, TimePoint in_begin, TimePoint in_end) {
+    const std::chrono::duration<double> elapsed = in_end - in_begin;
+    addTiming(in_name, elapsed.count());
+  }
+
+  Snapshot snapshot() const {
+    Snapshot result;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    result.counters.insert(m_counters.begin(), m_counters.end());
+    result.timings.insert(m_timings.begin(), m_timings.end());
+    return result;
+  }
+
+  void reset() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_counters.clear();
+    m_timings.clear();
+  }
+
+private:
+  MetricsRegistry() = default;
+  mutable std::mutex m_mutex;
+  std::unordered_map<std::string, double> m_counters;
+  std::unordered_map<std::string, Histogram> m_timings;
+};
+} // namespace tnqvm
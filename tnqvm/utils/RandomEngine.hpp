@@ -23,6 +23,19 @@ struct randomEngine {
     m_engine.seed(seed);
   }
 
+  // Draws a batch of random numbers under a single lock,
+  // i.e. the sequence is independent of how the caller consumes it.
+  std::vector<double> randProbs(uint64_t num_samples) {
+    std::vector<double> rs;
+    rs.reserve(num_samples);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (uint64_t i = 0; i < num_samples; ++i) {
+      rs.emplace_back(
+          std::uniform_real_distribution<double>(0.0, 1.0)(m_engine));
+    }
+    return rs;
+  }
+
   std::vector<double> sortedRandProbs(uint64_t num_samples) {
     std::vector<double> rs;
     rs.reserve(num_samples + 1);
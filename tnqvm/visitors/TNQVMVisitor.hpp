@@ -34,7 +34,11 @@
 #include "Identifiable.hpp"
 #include "AllGateVisitor.hpp"
 #include "xacc.hpp"
+#include "utils/MetricsRegistry.hpp"
+#include <algorithm>
+#include <memory>
 #include <sstream>
+#include <thread>
 
 using namespace xacc;
 using namespace xacc::quantum;
@@ -51,10 +55,33 @@ std::string concat(Ts&&... args) {
 extern bool tnqvm_timing_log_enabled;
 // Macro to define a Telemetry zone whose execution time is tracked.
 // Using macros so that we can opt out if not need telemetry.
+// The time is always recorded in the metrics registry (utils/MetricsRegistry.hpp),
+// and also logged (xacc::ScopeTimer) if verbose.
 #define TNQVM_TELEMETRY_ZONE(NAME, FILE, LINE) \
-  xacc::ScopeTimer __telemetry__timer(concat("tnqvm::", NAME, " (", FILE, ":", LINE, ")"), xacc::verbose && tnqvm_timing_log_enabled);
+  tnqvm::TelemetryZone __telemetry__zone(NAME, FILE, LINE);
 
 namespace tnqvm {
+class TelemetryZone {
+public:
+  TelemetryZone(const std::string &in_name, const char *in_file, int in_line)
+      : m_timer(in_name),
+        m_logTimer((xacc::verbose && tnqvm_timing_log_enabled)
+                       ? std::make_unique<xacc::ScopeTimer>(
+                             concat("tnqvm::", in_name, " (", in_file, ":",
+                                    in_line, ")"),
+                             true)
+                       : nullptr) {}
+
+private:
+  MetricsRegistry::ScopedTimer m_timer;
+  std::unique_ptr<xacc::ScopeTimer> m_logTimer;
+};
+
+// Snapshot of a visitor's simulation state (see TNQVMVisitor::saveState).
+struct VisitorState {
+  virtual ~VisitorState() = default;
+};
+
 class TNQVMVisitor : public AllGateVisitor, public OptionsProvider,
                      public xacc::Cloneable<TNQVMVisitor> {
 public:
@@ -71,6 +98,63 @@ public:
   // Does this visitor implementation support VQE mode execution?
   // i.e. ability to cache the state vector after simulating the ansatz.
   virtual bool supportVqeMode() const { return false; }
+  // VQE mode: evaluate all observable sub-circuits (change of basis +
+  // measurements) against the cached ansatz state. Results are in input order.
+  // Visitors can override this to share work across terms, e.g. apply each
+  // distinct basis change only once.
+  virtual std::vector<double> getExpectationValueZBatch(
+      const std::vector<std::shared_ptr<CompositeInstruction>> &functions) {
+    std::vector<double> result;
+    result.reserve(functions.size());
+    for (const auto &function : functions) {
+      result.emplace_back(getExpectationValueZ(function));
+    }
+    return result;
+  }
+  // Does this visitor accept fused gates (see GateFusion.hpp)?
+  // If so, TNQVM fuses the circuit gates before visiting them and calls
+  // `applyFusedGate` for the fused ones, unless `gate-fusion` is false.
+  virtual bool supportGateFusion() const { return false; }
+  // Applies a fused 1- or 2-qubit unitary. For two-qubit ops, in_bits[0] is
+  // the most significant bit of the matrix index (as the control of CNOT).
+  virtual void
+  applyFusedGate(const std::vector<size_t> &in_bits,
+                 const std::vector<std::vector<std::complex<double>>> &in_matrix) {
+    xacc::error(name() + " doesn't support fused gates.");
+  }
+  // Can this visitor apply two-qubit gates on non-adjacent qubits directly?
+  // MPS visitors which can't are given a nearest-neighbor (SWAP-inserted)
+  // circuit instead.
+  virtual bool supportLongRangeGates() const { return false; }
+  // Can clones of this visitor simulate kernels concurrently (one per thread)?
+  // i.e. the visitor has no process-wide state, unlike the ExaTN-based ones
+  // which share the ExaTN runtime (and its tensor namespace).
+  virtual bool supportConcurrentKernels() const { return false; }
+  // Can the simulation state be saved (after visiting some instructions) and
+  // restored, possibly several times, once the visitor has been initialized
+  // for another buffer of the same size? Used to simulate the shared prefix of
+  // a batch of kernels only once (see PrefixSharing.hpp).
+  virtual bool supportStateSnapshot() const { return false; }
+  virtual std::shared_ptr<VisitorState> saveState() {
+    xacc::error(name() + " doesn't support state snapshots.");
+    return nullptr;
+  }
+  virtual void restoreState(const std::shared_ptr<VisitorState> &in_state) {
+    xacc::error(name() + " doesn't support state snapshots.");
+  }
+  // Maximum number of threads the visitor may use internally, e.g. to sample
+  // shots (0: all hardware threads). TNQVM splits the hardware threads between
+  // the visitors of concurrently simulated kernels.
+  void setThreadBudget(size_t in_nbThreads) { threadBudget = in_nbThreads; }
+  size_t getThreadBudget() const {
+    return threadBudget > 0
+               ? threadBudget
+               : std::max<size_t>(1, std::thread::hardware_concurrency());
+  }
+  // Starts any expensive one-time backend setup in the background (e.g. when
+  // the accelerator is initialized) so that the first execution doesn't pay
+  // for it. Visitors must still work if this has never been called.
+  virtual void prewarm(const HeterogeneousMap &in_options) {}
   // Execution information that visitor wants to persist.
   HeterogeneousMap getExecutionInfo() const { return executionInfo; }
 
@@ -79,6 +163,7 @@ protected:
   HeterogeneousMap options;
   // Visitor impl to set if need be.
   HeterogeneousMap executionInfo;
+  size_t threadBudget = 0;
 };
 
 } // namespace tnqvm
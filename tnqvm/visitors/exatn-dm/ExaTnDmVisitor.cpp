@@ -29,6 +29,7 @@
 */
 
 #include "ExaTnDmVisitor.hpp"
+#include "ExatnRuntime.hpp"
 #include "tensor_basic.hpp"
 #include "talshxx.hpp"
 #include "utils/GateMatrixAlgebra.hpp"
@@ -36,9 +37,6 @@
 #include "NoiseModel.hpp"
 #include "xacc_service.hpp"
 #include "xacc_plugin.hpp"
-#ifdef TNQVM_EXATN_USES_MKL_BLAS
-#include <dlfcn.h>
-#endif
 #include <bits/stdc++.h>
 
 #define QUBIT_DIM 2
@@ -58,6 +56,7 @@ void printDensityMatrix(const exatn::TensorNetwork &in_tensorNet,
   tempNetwork.rename("__TEMP__" + in_tensorNet.getName());
   const bool evaledOk = exatn::evaluateSync(tempNetwork);
   assert(evaledOk);
+  tnqvm::recordNetworkMetrics(tempNetwork);
   auto talsh_tensor =
       exatn::getLocalTensor(tempNetwork.getTensor(0)->getName());
   const auto expectedDensityMatrixVolume =
@@ -101,6 +100,7 @@ bool checkDmTensorNetwork(const exatn::TensorNetwork &in_tensorNet,
   tempNetwork.rename("__TEMP__" + in_tensorNet.getName());
   const bool evaledOk = exatn::evaluateSync(tempNetwork);
   assert(evaledOk);
+  tnqvm::recordNetworkMetrics(tempNetwork);
   auto talsh_tensor =
       exatn::getLocalTensor(tempNetwork.getTensor(0)->getName());
   const auto expectedDensityMatrixVolume =
@@ -224,6 +224,213 @@ getGateMatrix(const xacc::Instruction &in_gate, bool in_dagger = false) {
                    : flattenGateMatrix(gateMatrix);
 }
 
+tnqvm::LocalOperator
+toLocalOperator(const std::vector<std::complex<double>> &in_flattenedMat) {
+  assert(in_flattenedMat.size() == 4);
+  return {in_flattenedMat[0], in_flattenedMat[1], in_flattenedMat[2],
+          in_flattenedMat[3]};
+}
+
+// Bit of the qubit at position `in_pos` in a multi-index over `in_nbQubits`
+// qubits (the first qubit is the MSB).
+inline size_t qubitBit(size_t in_index, size_t in_pos, size_t in_nbQubits) {
+  return (in_index >> (in_nbQubits - 1 - in_pos)) & 1;
+}
+
+// rho -> U rho U^dagger: L[(oK, oB)][(iK, iB)] = U[oK][iK] * conj(U[oB][iB])
+tnqvm::SuperOperator
+gateSuperOperator(const std::vector<size_t> &in_bits,
+                  const std::vector<std::complex<double>> &in_gateMat) {
+  const size_t nbQubits = in_bits.size();
+  const size_t dim = 1ULL << nbQubits;
+  const size_t superDim = dim * dim;
+  assert(in_gateMat.size() == superDim);
+  tnqvm::SuperOperator result{
+      in_bits, std::vector<std::complex<double>>(superDim * superDim)};
+  for (size_t oK = 0; oK < dim; ++oK) {
+    for (size_t oB = 0; oB < dim; ++oB) {
+      for (size_t iK = 0; iK < dim; ++iK) {
+        for (size_t iB = 0; iB < dim; ++iB) {
+          result.mat[((oK << nbQubits) | oB) * superDim +
+                     ((iK << nbQubits) | iB)] =
+              in_gateMat[oK * dim + iK] * std::conj(in_gateMat[oB * dim + iB]);
+        }
+      }
+    }
+  }
+  return result;
+}
+
+// Superoperator of a noise channel from its Choi matrix,
+// using the same tensor leg assignment as applyNoise.
+tnqvm::SuperOperator choiSuperOperator(
+    const xacc::NoiseChannelKraus &in_channel,
+    const std::vector<std::vector<std::complex<double>>> &in_choiMat) {
+  // Role of each Choi tensor leg: qubit position, bra (or ket), output (or input)
+  struct LegRole {
+    size_t pos;
+    bool bra;
+    bool out;
+  };
+  std::vector<LegRole> legRoles;
+  std::vector<size_t> qubits;
+  if (in_channel.noise_qubits.size() == 1) {
+    // Pairing {1, 0} (ket), {3, 2} (bra)
+    legRoles = {{0, false, true}, {0, false, false}, {0, true, true}, {0, true, false}};
+    qubits = {in_channel.noise_qubits[0]};
+  } else {
+    assert(in_channel.noise_qubits.size() == 2);
+    // Pairing {5, 6} (ket), {1, 2} (bra) for the leading qubit
+    // and {4, 7} (ket), {0, 3} (bra) for the other one.
+    legRoles = {{1, true, false},  {0, true, false},  {0, true, true},
+                {1, true, true},   {1, false, false}, {0, false, false},
+                {0, false, true},  {1, false, true}};
+    qubits = (in_channel.bit_order == xacc::KrausMatBitOrder::MSB)
+                 ? std::vector<size_t>{in_channel.noise_qubits[0],
+                                       in_channel.noise_qubits[1]}
+                 : std::vector<size_t>{in_channel.noise_qubits[1],
+                                       in_channel.noise_qubits[0]};
+  }
+
+  const size_t nbQubits = qubits.size();
+  const size_t dim = 1ULL << nbQubits;
+  const size_t superDim = dim * dim;
+  assert(in_choiMat.size() == superDim);
+  tnqvm::SuperOperator result{
+      qubits, std::vector<std::complex<double>>(superDim * superDim)};
+  for (size_t oK = 0; oK < dim; ++oK) {
+    for (size_t oB = 0; oB < dim; ++oB) {
+      for (size_t iK = 0; iK < dim; ++iK) {
+        for (size_t iB = 0; iB < dim; ++iB) {
+          // Column-major address in the tensor of the (flattened) Choi matrix
+          size_t address = 0;
+          for (size_t leg = 0; leg < legRoles.size(); ++leg) {
+            const auto &role = legRoles[leg];
+            const size_t index =
+                role.bra ? (role.out ? oB : iB) : (role.out ? oK : iK);
+            address |= qubitBit(index, role.pos, nbQubits) << leg;
+          }
+          result.mat[((oK << nbQubits) | oB) * superDim +
+                     ((iK << nbQubits) | iB)] =
+              in_choiMat[address / superDim][address % superDim];
+        }
+      }
+    }
+  }
+  return result;
+}
+
+// Expands a superoperator to a superset of its qubits (identity on the others).
+tnqvm::SuperOperator embedSuperOperator(const tnqvm::SuperOperator &in_op,
+                                        const std::vector<size_t> &in_qubits) {
+  if (in_op.qubits == in_qubits) {
+    return in_op;
+  }
+  const size_t nbQubits = in_qubits.size();
+  const size_t nbOpQubits = in_op.qubits.size();
+  std::vector<size_t> opQubitPos;
+  std::vector<bool> isOpQubit(nbQubits, false);
+  for (const auto &qubit : in_op.qubits) {
+    const size_t pos =
+        std::find(in_qubits.begin(), in_qubits.end(), qubit) - in_qubits.begin();
+    assert(pos < nbQubits);
+    opQubitPos.emplace_back(pos);
+    isOpQubit[pos] = true;
+  }
+  const auto project = [&](size_t in_index) {
+    size_t result = 0;
+    for (const auto &pos : opQubitPos) {
+      result = (result << 1) | qubitBit(in_index, pos, nbQubits);
+    }
+    return result;
+  };
+
+  const size_t dim = 1ULL << nbQubits;
+  const size_t superDim = dim * dim;
+  const size_t opSuperDim = 1ULL << (2 * nbOpQubits);
+  tnqvm::SuperOperator result{
+      in_qubits, std::vector<std::complex<double>>(superDim * superDim)};
+  for (size_t row = 0; row < superDim; ++row) {
+    const size_t oK = row >> nbQubits;
+    const size_t oB = row & (dim - 1);
+    for (size_t col = 0; col < superDim; ++col) {
+      const size_t iK = col >> nbQubits;
+      const size_t iB = col & (dim - 1);
+      bool isIdentity = true;
+      for (size_t pos = 0; pos < nbQubits && isIdentity; ++pos) {
+        isIdentity = isOpQubit[pos] ||
+                     (qubitBit(oK, pos, nbQubits) == qubitBit(iK, pos, nbQubits) &&
+                      qubitBit(oB, pos, nbQubits) == qubitBit(iB, pos, nbQubits));
+      }
+      if (isIdentity) {
+        result.mat[row * superDim + col] =
+            in_op.mat[((project(oK) << nbOpQubits) | project(oB)) * opSuperDim +
+                      ((project(iK) << nbOpQubits) | project(iB))];
+      }
+    }
+  }
+  return result;
+}
+
+// Superoperator of `in_first` followed by `in_second`,
+// acting on `in_qubits` (superset of the qubits of both).
+tnqvm::SuperOperator
+composeSuperOperators(const tnqvm::SuperOperator &in_second,
+                      const tnqvm::SuperOperator &in_first,
+                      const std::vector<size_t> &in_qubits) {
+  const auto lhs = embedSuperOperator(in_second, in_qubits);
+  const auto rhs = embedSuperOperator(in_first, in_qubits);
+  const size_t superDim = 1ULL << (2 * in_qubits.size());
+  tnqvm::SuperOperator result{
+      in_qubits, std::vector<std::complex<double>>(superDim * superDim)};
+  for (size_t row = 0; row < superDim; ++row) {
+    for (size_t k = 0; k < superDim; ++k) {
+      const auto lhsVal = lhs.mat[row * superDim + k];
+      if (lhsVal == std::complex<double>(0.0, 0.0)) {
+        continue;
+      }
+      for (size_t col = 0; col < superDim; ++col) {
+        result.mat[row * superDim + col] += lhsVal * rhs.mat[k * superDim + col];
+      }
+    }
+  }
+  return result;
+}
+
+// Tensor body (column-major) of a superoperator,
+// legs: (ket out, ket in, bra out, bra in) for each qubit.
+std::vector<std::complex<double>>
+superOperatorTensorBody(const tnqvm::SuperOperator &in_op) {
+  const size_t nbQubits = in_op.qubits.size();
+  const size_t dim = 1ULL << nbQubits;
+  const size_t superDim = dim * dim;
+  std::vector<std::complex<double>> body(superDim * superDim);
+  for (size_t row = 0; row < superDim; ++row) {
+    const size_t oK = row >> nbQubits;
+    const size_t oB = row & (dim - 1);
+    for (size_t col = 0; col < superDim; ++col) {
+      const size_t iK = col >> nbQubits;
+      const size_t iB = col & (dim - 1);
+      size_t address = 0;
+      for (size_t pos = 0; pos < nbQubits; ++pos) {
+        address |= (qubitBit(oK, pos, nbQubits) << (4 * pos)) |
+                   (qubitBit(iK, pos, nbQubits) << (4 * pos + 1)) |
+                   (qubitBit(oB, pos, nbQubits) << (4 * pos + 2)) |
+                   (qubitBit(iB, pos, nbQubits) << (4 * pos + 3));
+      }
+      body[address] = in_op.mat[row * superDim + col];
+    }
+  }
+  return body;
+}
+
+bool isSubset(const std::vector<size_t> &in_subset,
+              const std::vector<size_t> &in_set) {
+  return std::all_of(in_subset.begin(), in_subset.end(), [&](size_t in_qubit) {
+    return std::find(in_set.begin(), in_set.end(), in_qubit) != in_set.end();
+  });
+}
+
 void recursiveFindAllCombinations(std::vector<std::vector<unsigned int>>& io_result,
 const std::vector<unsigned int> &arr,
                 std::vector<unsigned int> &data, int start, int end, int index,
@@ -338,46 +545,23 @@ void checkKrausTensorConfig(const exatn::TensorNetwork &in_tensorNet,
 } // namespace
 
 namespace tnqvm {
-ExaTnDmVisitor::ExaTnDmVisitor() {
-  // TODO
-}
+ExaTnDmVisitor::ExaTnDmVisitor() : m_superOpFusion(true) {}
 
 void ExaTnDmVisitor::initialize(std::shared_ptr<AcceleratorBuffer> buffer,
                                 int nbShots) {
   // Initialize ExaTN (if not already initialized)
-  if (!exatn::isInitialized()) {
-#ifdef TNQVM_EXATN_USES_MKL_BLAS
-    // Fix for TNQVM bug #30
-    void *core_handle =
-        dlopen("@EXATN_MKL_PATH@/libmkl_core@CMAKE_SHARED_LIBRARY_SUFFIX@",
-               RTLD_LAZY | RTLD_GLOBAL);
-    if (core_handle == nullptr) {
-      std::string err = std::string(dlerror());
-      xacc::error("Could not load mkl_core - " + err);
-    }
-
-    void *thread_handle = dlopen(
-        "@EXATN_MKL_PATH@/libmkl_gnu_thread@CMAKE_SHARED_LIBRARY_SUFFIX@",
-        RTLD_LAZY | RTLD_GLOBAL);
-    if (thread_handle == nullptr) {
-      std::string err = std::string(dlerror());
-      xacc::error("Could not load mkl_gnu_thread - " + err);
-    }
-#endif
-    // If exaTN has not been initialized, do it now.
-    exatn::initialize();
-    // ExaTN and XACC logging levels are always in-synced.
-    exatn::resetClientLoggingLevel(xacc::verbose ? xacc::getLoggingLevel() : 0);
-    exatn::resetRuntimeLoggingLevel(xacc::verbose ? xacc::getLoggingLevel(): 0);
-
-    xacc::subscribeLoggingLevel([](int level) {
-      exatn::resetClientLoggingLevel(xacc::verbose ? level : 0);
-      exatn::resetRuntimeLoggingLevel(xacc::verbose ? level : 0);
-    });
+  if (ExatnRuntime::get().initialize(options)) {
+    // ExaTN has been (re-)initialized: no tensors to reuse.
+    m_tensorRegistry.clear();
   }
   m_buffer = buffer;
   m_tensorNetwork = buildInitialNetwork(buffer->size());
   m_tensorIdCounter = m_tensorNetwork.getMaxTensorId();
+  m_pendingSuperOps.clear();
+  m_superOpFusion = true;
+  if (options.keyExists<bool>("superop-fusion")) {
+    m_superOpFusion = options.get<bool>("superop-fusion");
+  }
   if (options.pointerLikeExists<xacc::NoiseModel>("noise-model")) {
     m_noiseConfig = xacc::as_shared_ptr(
         options.getPointerLike<xacc::NoiseModel>("noise-model"));
@@ -391,9 +575,9 @@ ExaTnDmVisitor::buildInitialNetwork(size_t in_nbQubits) const {
     auto tensor = std::make_shared<exatn::Tensor>(
             tensorName, exatn::TensorShape{QUBIT_DIM, QUBIT_DIM});
     const bool created =
-        exatn::createTensorSync(tensor, exatn::TensorElementType::COMPLEX64);
+        exatn::createTensor(tensor, exatn::TensorElementType::COMPLEX64);
     assert(created);
-    const bool initialized = exatn::initTensorDataSync(
+    const bool initialized = exatn::initTensorData(
         tensorName, Q_ZERO_TENSOR_BODY(tensor->getVolume()));
     assert(initialized);
   }
@@ -414,6 +598,7 @@ ExaTnDmVisitor::buildInitialNetwork(size_t in_nbQubits) const {
 
 void ExaTnDmVisitor::finalize() {
   executionInfo.clear();
+  flushSuperOperators();
   // Max number of qubits that we allow for a full density matrix retrieval.
   // For more qubits, only expectation contraction is supported.
   constexpr size_t MAX_SIZE_TO_COLLAPSE_DM = 10;
@@ -426,6 +611,7 @@ void ExaTnDmVisitor::finalize() {
     tempNetwork.rename("__TEMP__" + m_tensorNetwork.getName());
     const bool evaledOk = exatn::evaluateSync(tempNetwork);
     assert(evaledOk);
+    tnqvm::recordNetworkMetrics(tempNetwork);
     auto talsh_tensor =
         exatn::getLocalTensor(tempNetwork.getTensor(0)->getName());
     const auto expectedDensityMatrixVolume = nbRows * nbRows;
@@ -527,6 +713,7 @@ void ExaTnDmVisitor::finalize() {
     // Evaluate the trace by contraction:
     const bool evaledOk = exatn::evaluateSync(expValTensorNet);
     assert(evaledOk);
+    tnqvm::recordNetworkMetrics(expValTensorNet);
     auto talsh_tensor =
         exatn::getLocalTensor(expValTensorNet.getTensor(0)->getName());
     if (talsh_tensor) {
@@ -561,10 +748,16 @@ void ExaTnDmVisitor::finalize() {
     }
   }
 
+  // Gate/noise tensors (incl. those only used by observable sub-circuits)
+  for (const auto &iter : m_tensorRegistry) {
+    tensorList.emplace(iter.second);
+  }
+
   for (const auto &tensorName : tensorList) {
     const bool destroyed = exatn::destroyTensor(tensorName);
     assert(destroyed);
   }
+  m_tensorRegistry.clear();
 
   m_buffer.reset();
   m_noiseConfig.reset();
@@ -572,34 +765,23 @@ void ExaTnDmVisitor::finalize() {
 
 void ExaTnDmVisitor::applySingleQubitGate(
     xacc::quantum::Gate &in_gateInstruction) {
+  assert(in_gateInstruction.bits().size() == 1);
+  if (m_superOpFusion && fuseSuperOperator(in_gateInstruction)) {
+    return;
+  }
   {
     m_tensorIdCounter++;
-    assert(in_gateInstruction.bits().size() == 1);
     const auto gateMatrix = getGateMatrix(in_gateInstruction);
-    // std::cout << "Gate mattrix:\n";
-    // for (const auto &el : gateMatrix) {
-    //   std::cout << el << "\n";
-    // }
     assert(gateMatrix.size() == 4);
-    const std::string uniqueGateName =
-        in_gateInstruction.name() + std::to_string(m_tensorIdCounter);
-    // Create the tensor
-    const bool created = exatn::createTensorSync(
-        uniqueGateName, exatn::TensorElementType::COMPLEX64,
-        exatn::TensorShape{2, 2});
-    assert(created);
-    // Init tensor body data
-    const bool initialized =
-        exatn::initTensorDataSync(uniqueGateName, gateMatrix);
-    assert(initialized);
-
+    const std::string gateTensorName = getTensorByBody(
+        in_gateInstruction.name(), exatn::TensorShape{2, 2}, gateMatrix);
     const std::vector<unsigned int> gatePairing{
         static_cast<unsigned int>(in_gateInstruction.bits()[0])};
     // Append the tensor for this gate to the network
     const bool appended = m_tensorNetwork.appendTensorGate(
         m_tensorIdCounter,
         // Get the gate tensor data which must have been initialized.
-        exatn::getTensor(uniqueGateName),
+        exatn::getTensor(gateTensorName),
         // which qubits that the gate is acting on
         gatePairing);
     assert(appended);
@@ -609,28 +791,16 @@ void ExaTnDmVisitor::applySingleQubitGate(
     // Append the dagger gate
     m_tensorIdCounter++;
     const auto gateMatrix = getGateMatrix(in_gateInstruction, true);
-    // std::cout << "Gate mattrix dagger:\n";
-    // for (const auto &el : gateMatrix) {
-    //   std::cout << el << "\n";
-    // }
     assert(gateMatrix.size() == 4);
-    const std::string uniqueGateName =
-        in_gateInstruction.name() + "_CONJ_" + std::to_string(m_tensorIdCounter);
-    // Create the tensor
-    const bool created = exatn::createTensorSync(
-        uniqueGateName, exatn::TensorElementType::COMPLEX64,
-        exatn::TensorShape{2, 2});
-    assert(created);
-    // Init tensor body data
-    const bool initialized =
-        exatn::initTensorDataSync(uniqueGateName, gateMatrix);
-    assert(initialized);
+    const std::string gateTensorName =
+        getTensorByBody(in_gateInstruction.name() + "_CONJ",
+                        exatn::TensorShape{2, 2}, gateMatrix);
     const std::vector<unsigned int> gatePairingConj{static_cast<unsigned int>(
         m_buffer->size() + in_gateInstruction.bits()[0])};
     const bool conjAppended = m_tensorNetwork.appendTensorGate(
         m_tensorIdCounter,
         // Get the gate tensor data which must have been initialized.
-        exatn::getTensor(uniqueGateName),
+        exatn::getTensor(gateTensorName),
         // which qubits that the gate is acting on
         gatePairingConj);
     assert(conjAppended);
@@ -646,23 +816,16 @@ void ExaTnDmVisitor::applySingleQubitGate(
 
 void ExaTnDmVisitor::applyTwoQubitGate(
     xacc::quantum::Gate &in_gateInstruction) {
+  assert(in_gateInstruction.bits().size() == 2);
+  if (m_superOpFusion && fuseSuperOperator(in_gateInstruction)) {
+    return;
+  }
   {
     m_tensorIdCounter++;
-    assert(in_gateInstruction.bits().size() == 2);
     const auto gateMatrix = getGateMatrix(in_gateInstruction);
     assert(gateMatrix.size() == 16);
-    const std::string uniqueGateName =
-        in_gateInstruction.name() + std::to_string(m_tensorIdCounter);
-    // Create the tensor
-    const bool created = exatn::createTensorSync(
-        uniqueGateName, exatn::TensorElementType::COMPLEX64,
-        exatn::TensorShape{2, 2, 2, 2});
-    assert(created);
-    // Init tensor body data
-    const bool initialized =
-        exatn::initTensorDataSync(uniqueGateName, gateMatrix);
-    assert(initialized);
-
+    const std::string gateTensorName = getTensorByBody(
+        in_gateInstruction.name(), exatn::TensorShape{2, 2, 2, 2}, gateMatrix);
     const std::vector<unsigned int> gatePairing{
         static_cast<unsigned int>(in_gateInstruction.bits()[1]),
         static_cast<unsigned int>(in_gateInstruction.bits()[0])};
@@ -670,7 +833,7 @@ void ExaTnDmVisitor::applyTwoQubitGate(
     const bool appended = m_tensorNetwork.appendTensorGate(
         m_tensorIdCounter,
         // Get the gate tensor data which must have been initialized.
-        exatn::getTensor(uniqueGateName),
+        exatn::getTensor(gateTensorName),
         // which qubits that the gate is acting on
         gatePairing);
     assert(appended);
@@ -679,17 +842,9 @@ void ExaTnDmVisitor::applyTwoQubitGate(
     m_tensorIdCounter++;
     const auto gateMatrix = getGateMatrix(in_gateInstruction, true);
     assert(gateMatrix.size() == 16);
-    const std::string uniqueGateName =
-        in_gateInstruction.name() + "_CONJ_" + std::to_string(m_tensorIdCounter);
-    // Create the tensor
-    const bool created = exatn::createTensorSync(
-        uniqueGateName, exatn::TensorElementType::COMPLEX64,
-        exatn::TensorShape{2, 2, 2, 2});
-    assert(created);
-    // Init tensor body data
-    const bool initialized =
-        exatn::initTensorDataSync(uniqueGateName, gateMatrix);
-    assert(initialized);
+    const std::string gateTensorName =
+        getTensorByBody(in_gateInstruction.name() + "_CONJ",
+                        exatn::TensorShape{2, 2, 2, 2}, gateMatrix);
     const std::vector<unsigned int> gatePairingConj{
         static_cast<unsigned int>(m_buffer->size() +
                                   in_gateInstruction.bits()[1]),
@@ -698,7 +853,7 @@ void ExaTnDmVisitor::applyTwoQubitGate(
     const bool conjAppended = m_tensorNetwork.appendTensorGate(
         m_tensorIdCounter,
         // Get the gate tensor data which must have been initialized.
-        exatn::getTensor(uniqueGateName),
+        exatn::getTensor(gateTensorName),
         // which qubits that the gate is acting on
         gatePairingConj);
     assert(conjAppended);
@@ -708,6 +863,30 @@ void ExaTnDmVisitor::applyTwoQubitGate(
   applyNoise(in_gateInstruction);
 }
 
+std::string ExaTnDmVisitor::getTensorByBody(
+    const std::string &in_namePrefix, const exatn::TensorShape &in_shape,
+    const std::vector<std::complex<double>> &in_body) {
+  // Key: tensor rank + raw bytes of the body (all legs have dimension 2).
+  std::string key = std::to_string(in_shape.getRank()) + ":";
+  key.append(reinterpret_cast<const char *>(in_body.data()),
+             in_body.size() * sizeof(std::complex<double>));
+  const auto iter = m_tensorRegistry.find(key);
+  if (iter != m_tensorRegistry.end()) {
+    return iter->second;
+  }
+
+  const std::string tensorName =
+      in_namePrefix + "_" + std::to_string(m_tensorRegistry.size());
+  // Asynchronous: the tensor is ready by the time the network is evaluated.
+  const bool created = exatn::createTensor(
+      tensorName, exatn::TensorElementType::COMPLEX64, in_shape);
+  assert(created);
+  const bool initialized = exatn::initTensorData(tensorName, in_body);
+  assert(initialized);
+  m_tensorRegistry.emplace(std::move(key), tensorName);
+  return tensorName;
+}
+
 void ExaTnDmVisitor::applyNoise(xacc::quantum::Gate &in_gateInstruction) {
   if (!m_noiseConfig) {
     return;
@@ -730,18 +909,11 @@ void ExaTnDmVisitor::applyNoise(xacc::quantum::Gate &in_gateInstruction) {
     // }
 
     m_tensorIdCounter++;
-    const std::string noiseTensorName = in_gateInstruction.name() + "_Noise_" +
-                                        std::to_string(m_tensorIdCounter);
+    const std::string noisePrefix = in_gateInstruction.name() + "_Noise";
     if (channel.noise_qubits.size() == 1) {
-      // Create the tensor
-      const bool created = exatn::createTensorSync(
-          noiseTensorName, exatn::TensorElementType::COMPLEX64,
-          exatn::TensorShape{2, 2, 2, 2});
-      assert(created);
-      // Init tensor body data
-      const bool initialized = exatn::initTensorDataSync(
-          noiseTensorName, flattenGateMatrix(noiseMat));
-      assert(initialized);
+      const std::string noiseTensorName =
+          getTensorByBody(noisePrefix, exatn::TensorShape{2, 2, 2, 2},
+                          flattenGateMatrix(noiseMat));
 
       const std::vector<
           std::pair<unsigned int, std::pair<unsigned int, unsigned int>>>
@@ -757,15 +929,9 @@ void ExaTnDmVisitor::applyNoise(xacc::quantum::Gate &in_gateInstruction) {
           noisePairing);
       assert(appended);
     } else if (channel.noise_qubits.size() == 2) {
-      // Create the tensor
-      const bool created = exatn::createTensorSync(
-          noiseTensorName, exatn::TensorElementType::COMPLEX64,
-          exatn::TensorShape{2, 2, 2, 2, 2, 2, 2, 2});
-      assert(created);
-      // Init tensor body data
-      const bool initialized = exatn::initTensorDataSync(
-          noiseTensorName, flattenGateMatrix(noiseMat));
-      assert(initialized);
+      const std::string noiseTensorName =
+          getTensorByBody(noisePrefix, exatn::TensorShape{2, 2, 2, 2, 2, 2, 2, 2},
+                          flattenGateMatrix(noiseMat));
 
       // DEBUG: Using this to check all possible permutations.
       // checkKrausTensorConfig(m_tensorNetwork, channel.noise_qubits[0],
@@ -815,6 +981,96 @@ void ExaTnDmVisitor::applyNoise(xacc::quantum::Gate &in_gateInstruction) {
   // printDensityMatrix(m_tensorNetwork, m_buffer->size());
 }
 
+bool ExaTnDmVisitor::fuseSuperOperator(xacc::quantum::Gate &in_gateInstruction) {
+  const auto &bits = in_gateInstruction.bits();
+  const std::vector<size_t> gateBits(bits.begin(), bits.end());
+  auto superOp =
+      gateSuperOperator(gateBits, getGateMatrix(in_gateInstruction));
+  if (m_noiseConfig) {
+    const auto noiseChannels =
+        m_noiseConfig->getNoiseChannels(in_gateInstruction);
+    auto noiseUtils = xacc::getService<NoiseModelUtils>("default");
+    for (auto &channel : noiseChannels) {
+      if (channel.noise_qubits.empty() || channel.noise_qubits.size() > 2) {
+        xacc::error("Unsupported noise data.");
+      }
+      if (!isSubset(channel.noise_qubits, gateBits)) {
+        // Noise on other qubits (e.g. crosstalk): use the unfused tensors.
+        flushSuperOperators();
+        return false;
+      }
+      superOp = composeSuperOperators(
+          choiSuperOperator(channel, noiseUtils->krausToChoi(channel.mats)),
+          superOp, gateBits);
+    }
+  }
+
+  // Merge with the pending superoperators on the same qubits.
+  std::vector<SuperOperator> pendingSuperOps;
+  for (const auto &pendingOp : m_pendingSuperOps) {
+    if (isSubset(gateBits, pendingOp.qubits)) {
+      // e.g. a single-qubit gate after a two-qubit gate
+      superOp = composeSuperOperators(superOp, pendingOp, pendingOp.qubits);
+    } else if (isSubset(pendingOp.qubits, gateBits)) {
+      superOp = composeSuperOperators(superOp, pendingOp, gateBits);
+    } else if (std::any_of(pendingOp.qubits.begin(), pendingOp.qubits.end(),
+                           [&](size_t in_qubit) {
+                             return std::find(gateBits.begin(), gateBits.end(),
+                                              in_qubit) != gateBits.end();
+                           })) {
+      // Partial overlap
+      appendSuperOperator(pendingOp);
+    } else {
+      pendingSuperOps.emplace_back(pendingOp);
+    }
+  }
+  pendingSuperOps.emplace_back(std::move(superOp));
+  m_pendingSuperOps = std::move(pendingSuperOps);
+  return true;
+}
+
+void ExaTnDmVisitor::flushSuperOperators(const std::vector<size_t> &in_qubits) {
+  std::vector<SuperOperator> pendingSuperOps;
+  for (const auto &pendingOp : m_pendingSuperOps) {
+    const bool overlap =
+        in_qubits.empty() ||
+        std::any_of(pendingOp.qubits.begin(), pendingOp.qubits.end(),
+                    [&](size_t in_qubit) {
+                      return std::find(in_qubits.begin(), in_qubits.end(),
+                                       in_qubit) != in_qubits.end();
+                    });
+    if (overlap) {
+      appendSuperOperator(pendingOp);
+    } else {
+      pendingSuperOps.emplace_back(pendingOp);
+    }
+  }
+  m_pendingSuperOps = std::move(pendingSuperOps);
+}
+
+void ExaTnDmVisitor::appendSuperOperator(const SuperOperator &in_superOp) {
+  const size_t nbQubits = in_superOp.qubits.size();
+  m_tensorIdCounter++;
+  const std::string superOpTensorName = getTensorByBody(
+      "SuperOp",
+      exatn::TensorShape(std::vector<exatn::DimExtent>(4 * nbQubits, 2)),
+      superOperatorTensorBody(in_superOp));
+  // Legs (ket out, ket in, bra out, bra in) for each qubit
+  std::vector<std::pair<unsigned int, std::pair<unsigned int, unsigned int>>>
+      superOpPairing;
+  for (size_t i = 0; i < nbQubits; ++i) {
+    const auto leg = static_cast<unsigned int>(4 * i);
+    superOpPairing.push_back(
+        {static_cast<unsigned int>(in_superOp.qubits[i]), {leg + 1, leg}});
+    superOpPairing.push_back(
+        {static_cast<unsigned int>(in_superOp.qubits[i] + m_buffer->size()),
+         {leg + 3, leg + 2}});
+  }
+  const bool appended = m_tensorNetwork.appendTensorGateGeneral(
+      m_tensorIdCounter, exatn::getTensor(superOpTensorName), superOpPairing);
+  assert(appended);
+}
+
 void ExaTnDmVisitor::visit(Identity &in_IdentityGate) {
   applySingleQubitGate(in_IdentityGate);
 }
@@ -900,9 +1156,123 @@ void ExaTnDmVisitor::visit(fSim &in_fsimGate) {
   applyTwoQubitGate(in_fsimGate);
 }
 
+bool ExaTnDmVisitor::getObservableOperators(
+    const std::shared_ptr<CompositeInstruction> &in_function,
+    std::vector<LocalOperator> &out_ops) {
+  std::vector<std::shared_ptr<xacc::quantum::Gate>> gates;
+  std::vector<size_t> measuredBits;
+  InstructionIterator it(in_function);
+  while (it.hasNext()) {
+    auto nextInst = it.next();
+    if (!nextInst->isEnabled() || nextInst->isComposite()) {
+      continue;
+    }
+    if (nextInst->name() == "Measure") {
+      measuredBits.emplace_back(nextInst->bits()[0]);
+      continue;
+    }
+    auto gate = std::dynamic_pointer_cast<xacc::quantum::Gate>(nextInst);
+    if (!gate || gate->bits().size() != 1) {
+      return false;
+    }
+    gates.emplace_back(gate);
+  }
+
+  // Z on the measured qubits, then walk the basis change backward
+  // (Heisenberg picture): O -> N^dagger(O) -> U^dagger * O * U
+  out_ops.assign(m_buffer->size(), LocalOperator{1.0, 0.0, 0.0, 1.0});
+  for (const auto &measBit : measuredBits) {
+    out_ops[measBit] = LocalOperator{1.0, 0.0, 0.0, -1.0};
+  }
+  for (auto gateIter = gates.rbegin(); gateIter != gates.rend(); ++gateIter) {
+    auto &gate = **gateIter;
+    if (m_noiseConfig) {
+      const auto noiseChannels = m_noiseConfig->getNoiseChannels(gate);
+      for (auto channelIter = noiseChannels.rbegin();
+           channelIter != noiseChannels.rend(); ++channelIter) {
+        // Multi-qubit noise would entangle the observable.
+        if (channelIter->noise_qubits.size() != 1) {
+          return false;
+        }
+        std::vector<LocalOperator> krausOps;
+        for (const auto &krausMat : channelIter->mats) {
+          krausOps.emplace_back(toLocalOperator(flattenGateMatrix(krausMat)));
+        }
+        auto &op = out_ops[channelIter->noise_qubits[0]];
+        op = applyAdjointChannel(op, krausOps);
+      }
+    }
+    auto &op = out_ops[gate.bits()[0]];
+    op = applyAdjointChannel(op, {toLocalOperator(getGateMatrix(gate))});
+  }
+  return true;
+}
+
 const double ExaTnDmVisitor::getExpectationValueZ(
     std::shared_ptr<CompositeInstruction> in_function) {
-  return 0.0;
+  flushSuperOperators();
+  std::vector<LocalOperator> ops;
+  if (getObservableOperators(in_function, ops)) {
+    return traceProductOperators(m_tensorNetwork, m_buffer->size(), {ops})[0]
+        .real();
+  }
+
+  // General sub-circuit: append it to the density matrix network,
+  // compute the trace, then restore the network.
+  const auto baseNetwork = m_tensorNetwork;
+  const auto baseTensorIdCounter = m_tensorIdCounter;
+  const auto baseMeasuredBits = m_measuredBits;
+  m_measuredBits.clear();
+  InstructionIterator it(in_function);
+  while (it.hasNext()) {
+    auto nextInst = it.next();
+    if (nextInst->isEnabled() && !nextInst->isComposite()) {
+      nextInst->accept(this);
+    }
+  }
+
+  flushSuperOperators();
+  ops.assign(m_buffer->size(), LocalOperator{1.0, 0.0, 0.0, 1.0});
+  for (const auto &measBit : m_measuredBits) {
+    ops[measBit] = LocalOperator{1.0, 0.0, 0.0, -1.0};
+  }
+  const double expValZ =
+      traceProductOperators(m_tensorNetwork, m_buffer->size(), {ops})[0]
+          .real();
+
+  // Note: the gate and noise tensors of the sub-circuit are kept in the
+  // registry (destroyed on finalize) for reuse by the next sub-circuits.
+  m_tensorNetwork = baseNetwork;
+  m_tensorIdCounter = baseTensorIdCounter;
+  m_measuredBits = baseMeasuredBits;
+  return expValZ;
+}
+
+std::vector<double> ExaTnDmVisitor::getExpectationValueZBatch(
+    const std::vector<std::shared_ptr<CompositeInstruction>> &in_functions) {
+  flushSuperOperators();
+  std::vector<double> result(in_functions.size(), 0.0);
+  // Observables of single-qubit basis changes are traced together
+  // (same network topology, hence a single contraction sequence).
+  std::vector<std::vector<LocalOperator>> products;
+  std::vector<size_t> productFunctionIdx;
+  for (size_t i = 0; i < in_functions.size(); ++i) {
+    std::vector<LocalOperator> ops;
+    if (getObservableOperators(in_functions[i], ops)) {
+      products.emplace_back(std::move(ops));
+      productFunctionIdx.emplace_back(i);
+    } else {
+      result[i] = getExpectationValueZ(in_functions[i]);
+    }
+  }
+
+  const auto traceVals =
+      traceProductOperators(m_tensorNetwork, m_buffer->size(), products);
+  assert(traceVals.size() == products.size());
+  for (size_t i = 0; i < traceVals.size(); ++i) {
+    result[productFunctionIdx[i]] = traceVals[i].real();
+  }
+  return result;
 }
 } // namespace tnqvm
 
@@ -38,6 +38,9 @@
  * +-----------------------------+------------------------------------------------------------------------+-------------+--------------------------+
  * | backend                     | Name of the IBMQ backend to query the backend configuration.           |    string   | None                     |
  * +-----------------------------+------------------------------------------------------------------------+-------------+--------------------------+
+ * | superop-fusion              | Fuse each gate, its conjugate and its noise channels into a single     |    bool     | true                     |
+ * |                             | superoperator tensor (merging consecutive ones on the same qubits).    |             |                          |
+ * +-----------------------------+------------------------------------------------------------------------+-------------+--------------------------+
  * If either `backend-json` or `backend` is provided, the `exatn-dm` simulator will simulate the backend noise associated with each quantum gate.
 */
 
@@ -46,6 +49,9 @@
 #include "TNQVMVisitor.hpp"
 #include "tensor_network.hpp"
 #include "exatn.hpp"
+#include "ExatnRuntime.hpp"
+#include "DensityOperatorTrace.hpp"
+#include <unordered_map>
 
 namespace xacc {
 // Forward declaration
@@ -60,6 +66,13 @@ struct KrausOp {
   std::vector<std::vector<std::complex<double>>> mats;
 };
 
+// Superoperator (Liouville form) on a set of qubits:
+// mat[(outKet, outBra)][(inKet, inBra)] (row-major), the first qubit is the MSB.
+struct SuperOperator {
+  std::vector<size_t> qubits;
+  std::vector<std::complex<double>> mat;
+};
+
 class ExaTnDmVisitor : public TNQVMVisitor
 {
 public:
@@ -69,6 +82,7 @@ public:
     // Virtual function impls:
     virtual void initialize(std::shared_ptr<AcceleratorBuffer> buffer, int nbShots) override;
     virtual void finalize() override;
+    virtual void prewarm(const HeterogeneousMap& in_options) override { ExatnRuntime::get().prewarm(in_options); }
 
     // Service name as defined in manifest.json
     virtual const std::string name() const override { return "exatn-dm"; }
@@ -98,6 +112,9 @@ public:
     virtual void visit(Measure& in_MeasureGate) override;
 
     virtual const double getExpectationValueZ(std::shared_ptr<CompositeInstruction> in_function) override;
+    // VQE mode: the noisy ansatz is simulated once, each observable sub-circuit is traced against the density matrix.
+    virtual bool supportVqeMode() const override { return true; }
+    virtual std::vector<double> getExpectationValueZBatch(const std::vector<std::shared_ptr<CompositeInstruction>>& in_functions) override;
     class ExaTnTensorFunctor : public talsh::TensorFunctor<exatn::Identifiable>
     {
     public:
@@ -118,6 +135,18 @@ public:
     void applySingleQubitGate(xacc::quantum::Gate& in_gateInstruction);
     void applyTwoQubitGate(xacc::quantum::Gate& in_gateInstruction);
     void applyNoise(xacc::quantum::Gate &in_gateInstruction);
+    // Fuses the gate and its noise channels into a pending superoperator,
+    // returns false if the noise is not local to the gate qubits.
+    bool fuseSuperOperator(xacc::quantum::Gate& in_gateInstruction);
+    // Appends the pending superoperators acting on any of the given qubits (all if empty) to the network.
+    void flushSuperOperators(const std::vector<size_t>& in_qubits = {});
+    void appendSuperOperator(const SuperOperator& in_superOp);
+    // Returns the name of a (shared) tensor with the given body, created (asynchronously) on first use.
+    // Gates, their conjugates and noise channels with identical bodies thus reference a single tensor.
+    std::string getTensorByBody(const std::string& in_namePrefix, const exatn::TensorShape& in_shape, const std::vector<std::complex<double>>& in_body);
+    // Z-string observable of a sub-circuit as a product of single-qubit operators (Heisenberg picture),
+    // returns false if the sub-circuit (or its noise) is not local, e.g. it has multi-qubit gates.
+    bool getObservableOperators(const std::shared_ptr<CompositeInstruction>& in_function, std::vector<LocalOperator>& out_ops);
 
   private:
     exatn::TensorNetwork m_tensorNetwork;
@@ -126,5 +155,10 @@ public:
     int m_nbShots;
     int m_tensorIdCounter;
     std::shared_ptr<xacc::NoiseModel> m_noiseConfig;
+    // Tensor registry: body key (rank + data bytes) -> tensor name
+    std::unordered_map<std::string, std::string> m_tensorRegistry;
+    bool m_superOpFusion;
+    // Fused superoperators (on disjoint sets of qubits) not yet appended to the network
+    std::vector<SuperOperator> m_pendingSuperOps;
 };
 } // namespace tnqvm
\ No newline at end of file
@@ -526,6 +526,94 @@ TEST(JsonNoiseModelTester, testDeuteronVqeH2) {
   EXPECT_NEAR((*buffer)["opt-val"].as<double>(), -1.74886, 0.5);
 }
 
+TEST(JsonNoiseModelTester, checkVqeMode) {
+  auto noiseModel = xacc::getService<xacc::NoiseModel>("json");
+  noiseModel->initialize({{"noise-model", noise_model_4q}});
+  xacc::qasm(R"(
+        .compiler xasm
+        .circuit dm_vqe_ansatz
+        .qbit q
+        H(q[0]);
+        X(q[1]);
+        CNOT(q[0], q[1]);
+        H(q[2]);
+        CNOT(q[1], q[2]);
+        X(q[3]);
+        CNOT(q[2], q[3]);
+    )");
+  auto ansatz = xacc::getCompiled("dm_vqe_ansatz");
+  auto observable = xacc::quantum::getObservable(
+      "pauli", std::string("X0 X1 + Z0 Z1 + Y0 Y1 X2 + Z3 + X0 Z1 Y2 Z3 + Y3"));
+  auto kernels = observable->observe(ansatz);
+
+  // The noisy ansatz is simulated once in VQE mode:
+  // must match the full simulation of each kernel.
+  auto vqeBuffer = xacc::qalloc(4);
+  auto vqeAcc = xacc::getAccelerator("tnqvm", {{"tnqvm-visitor", "exatn-dm"},
+                                               {"noise-model", noiseModel},
+                                               {"vqe-mode", true}});
+  vqeAcc->execute(vqeBuffer, kernels);
+
+  auto refBuffer = xacc::qalloc(4);
+  auto refAcc = xacc::getAccelerator("tnqvm", {{"tnqvm-visitor", "exatn-dm"},
+                                               {"noise-model", noiseModel},
+                                               {"vqe-mode", false}});
+  refAcc->execute(refBuffer, kernels);
+
+  const auto vqeChildren = vqeBuffer->getChildren();
+  const auto refChildren = refBuffer->getChildren();
+  ASSERT_EQ(vqeChildren.size(), kernels.size());
+  ASSERT_EQ(refChildren.size(), kernels.size());
+  for (size_t i = 0; i < kernels.size(); ++i) {
+    EXPECT_EQ(vqeChildren[i]->name(), kernels[i]->name());
+    EXPECT_NEAR(vqeChildren[i]->getExpectationValueZ(),
+                refChildren[i]->getExpectationValueZ(), 1e-6);
+  }
+}
+
+TEST(JsonNoiseModelTester, checkSuperOpFusion) {
+  auto noiseModel = xacc::getService<xacc::NoiseModel>("json");
+  noiseModel->initialize({{"noise-model", noise_model_4q}});
+  auto xasmCompiler = xacc::getCompiler("xasm");
+  auto program = xasmCompiler
+                     ->compile(R"(__qpu__ void testFusion(qbit q) {
+        H(q[0]);
+        Ry(q[1], 0.7);
+        X(q[1]);
+        CNOT(q[0], q[1]);
+        Rz(q[0], 1.2);
+        H(q[1]);
+        CNOT(q[1], q[0]);
+        X(q[2]);
+        CNOT(q[1], q[2]);
+        H(q[3]);
+        U(q[3], 0.3, 0.4, 0.5);
+        CNOT(q[3], q[2]);
+      })")
+                     ->getComposite("testFusion");
+  const auto getDensityMatrix = [&](bool in_fusion) {
+    auto accelerator = xacc::getAccelerator(
+        "tnqvm", {{"tnqvm-visitor", "exatn-dm"},
+                  {"noise-model", noiseModel},
+                  {"superop-fusion", in_fusion}});
+    auto buffer = xacc::qalloc(4);
+    accelerator->execute(buffer, program);
+    return *(accelerator->getExecutionInfo<
+             xacc::ExecutionInfo::DensityMatrixPtrType>(
+        xacc::ExecutionInfo::DmKey));
+  };
+
+  const auto fusedDm = getDensityMatrix(true);
+  const auto refDm = getDensityMatrix(false);
+  EXPECT_TRUE(validateDensityMatrix(fusedDm));
+  ASSERT_EQ(fusedDm.size(), refDm.size());
+  for (size_t row = 0; row < refDm.size(); ++row) {
+    for (size_t col = 0; col < refDm.size(); ++col) {
+      EXPECT_NEAR(std::abs(fusedDm[row][col] - refDm[row][col]), 0.0, 1e-9);
+    }
+  }
+}
+
 int main(int argc, char **argv) {
   xacc::Initialize(argc, argv);
   ::testing::InitGoogleTest(&argc, argv);
@@ -31,6 +31,7 @@
 #ifdef TNQVM_HAS_EXATN
 
 #include "ExatnGenVisitor.hpp"
+#include "ExatnRuntime.hpp"
 #include "exatn.hpp"
 #include "tensor_basic.hpp"
 #include "Instruction.hpp"
@@ -44,9 +45,6 @@
 #include "base/Gates.hpp"
 #include "utils/GateMatrixAlgebra.hpp"
 
-#ifdef TNQVM_EXATN_USES_MKL_BLAS
-#include <dlfcn.h>
-#endif
 
 namespace {
 // Helper to construct qubit tensor name:
@@ -54,9 +52,6 @@ std::string generateQubitTensorName(int qubitIndex) {
   return "Q" + std::to_string(qubitIndex);
 };
 
-// Max memory size: 8GB
-const int64_t MAX_TALSH_MEMORY_BUFFER_SIZE_BYTES = 8 * (1ULL << 30);
-
 template <typename TNQVM_COMPLEX_TYPE>
 std::vector<TNQVM_COMPLEX_TYPE> flattenGateMatrix(
     const std::vector<std::vector<TNQVM_COMPLEX_TYPE>> &in_gateMatrix) {
@@ -130,106 +125,7 @@ ExatnGenVisitor<TNQVM_COMPLEX_TYPE>::ExatnGenVisitor() {}
 template <typename TNQVM_COMPLEX_TYPE>
 void ExatnGenVisitor<TNQVM_COMPLEX_TYPE>::initialize(
     std::shared_ptr<AcceleratorBuffer> buffer, int nbShots) {
-  int64_t talshHostBufferSizeInBytes = MAX_TALSH_MEMORY_BUFFER_SIZE_BYTES;
-  if (!exatn::isInitialized()) {
-#ifdef TNQVM_EXATN_USES_MKL_BLAS
-    // Fix for TNQVM bug #30
-    void *core_handle =
-        dlopen("@EXATN_MKL_PATH@/libmkl_core@CMAKE_SHARED_LIBRARY_SUFFIX@",
-               RTLD_LAZY | RTLD_GLOBAL);
-    if (core_handle == nullptr) {
-      std::string err = std::string(dlerror());
-      xacc::error("Could not load mkl_core - " + err);
-    }
-
-    void *thread_handle = dlopen(
-        "@EXATN_MKL_PATH@/libmkl_gnu_thread@CMAKE_SHARED_LIBRARY_SUFFIX@",
-        RTLD_LAZY | RTLD_GLOBAL);
-    if (thread_handle == nullptr) {
-      std::string err = std::string(dlerror());
-      xacc::error("Could not load mkl_gnu_thread - " + err);
-    }
-#endif
-
-    // If exaTN has not been initialized, do it now.
-    exatn::ParamConf exatnParams;
-    if (options.keyExists<int>("exatn-buffer-size-gb")) {
-      int bufferSizeGb = options.get<int>("exatn-buffer-size-gb");
-      if (bufferSizeGb < 1) {
-        std::cout << "Minimum buffer size is 1 GB.\n";
-        bufferSizeGb = 1;
-      }
-      // Set the memory buffer size:
-      const int64_t memorySizeBytes = bufferSizeGb * (1ULL << 30);
-      std::cout << "Set ExaTN host memory buffer to " << memorySizeBytes
-                << " bytes.\n";
-      const bool success =
-          exatnParams.setParameter("host_memory_buffer_size", memorySizeBytes);
-      assert(success);
-      // Update buffer size.
-      talshHostBufferSizeInBytes = memorySizeBytes;
-    } else {
-      // Use default buffer size
-      const bool success = exatnParams.setParameter(
-          "host_memory_buffer_size", MAX_TALSH_MEMORY_BUFFER_SIZE_BYTES);
-      assert(success);
-    }
-// This is a flag from ExaTN indicating that ExaTN was compiled
-// w/ MPI enabled.
-#ifdef MPI_ENABLED
-    {
-      if (options.keyExists<void *>("mpi-communicator")) {
-        xacc::info("Setting ExaTN MPI_COMMUNICATOR...");
-        auto communicator = options.get<void *>("mpi-communicator");
-        exatn::MPICommProxy commProxy(communicator);
-        exatn::initialize(commProxy, exatnParams);
-      } else {
-        // No specific communicator is specified,
-        // exaTN will automatically use MPI_COMM_WORLD.
-        exatn::initialize(exatnParams);
-      }
-      exatn::activateContrSeqCaching();
-    }
-#else
-    {
-      exatn::initialize(exatnParams);
-      exatn::activateContrSeqCaching();
-    }
-#endif
-
-    if (exatn::getDefaultProcessGroup().getSize() > 1) {
-      // Multiple MPI processes:
-      // if verbose is set, we must redirect log to files
-      // with custom names for each process.
-      if (xacc::verbose) {
-        // Get the rank of this process.
-        const int processRank = exatn::getProcessRank();
-        const std::string fileNamePrefix =
-            "process" + std::to_string(processRank);
-        // Redirect log to files (one for each MPI process)
-        xacc::logToFile(true, fileNamePrefix);
-      }
-    }
-
-    if (options.stringExists("exatn-contract-seq-optimizer")) {
-      const std::string optimizerName =
-          options.getString("exatn-contract-seq-optimizer");
-      std::cout << "Using '" << optimizerName << "' optimizer.\n";
-      exatn::resetContrSeqOptimizer(optimizerName);
-    }
-
-    // ExaTN and XACC logging levels are always in-synced.
-    // Note: If xacc::verbose is not set, we always set ExaTN logging level to
-    // 0.
-    exatn::resetClientLoggingLevel(xacc::verbose ? xacc::getLoggingLevel() : 0);
-    exatn::resetRuntimeLoggingLevel(xacc::verbose ? xacc::getLoggingLevel()
-                                                  : 0);
-
-    xacc::subscribeLoggingLevel([](int level) {
-      exatn::resetClientLoggingLevel(xacc::verbose ? level : 0);
-      exatn::resetRuntimeLoggingLevel(xacc::verbose ? level : 0);
-    });
-  }
+  ExatnRuntime::get().initialize(options);
   m_buffer = buffer;
   m_shots = nbShots;
   // Create the qubit register tensor
@@ -438,6 +334,7 @@ void ExatnGenVisitor<TNQVM_COMPLEX_TYPE>::finalize() {
     assert(accumInitialized);
     auto accumulator = exatn::getTensor("ExpVal");
     if (exatn::evaluateSync(bratimesopertimesket, accumulator)) {
+      tnqvm::recordNetworkMetrics(bratimesopertimesket, sizeof(TNQVM_COMPLEX_TYPE));
       auto talsh_tensor = exatn::getLocalTensor("ExpVal");
       assert(talsh_tensor->getVolume() == 1);
       const TNQVM_COMPLEX_TYPE *body_ptr;
@@ -941,6 +838,7 @@ const double ExatnGenVisitor<TNQVM_COMPLEX_TYPE>::getExpectationValueZ(
     auto accumulator = exatn::getTensor("ExpVal");
     const bool evaluated = exatn::evaluateSync(bratimesopertimesket, accumulator);
     assert(evaluated);
+    tnqvm::recordNetworkMetrics(bratimesopertimesket, sizeof(TNQVM_COMPLEX_TYPE));
     m_evaluatedExpansion = std::make_shared<exatn::TensorExpansion>(bratimesopertimesket);
   }
   // std::cout << "There are: " << m_evaluatedExpansion->getNumComponents() << "
@@ -1045,6 +943,7 @@ ExatnGenVisitor<TNQVM_COMPLEX_TYPE>::computeWaveFuncSlice(
     // combinedTensorNetwork.printIt();
     if (exatn::evaluateSync(in_processGroup, combinedTensorNetwork)) {
       exatn::sync();
+      tnqvm::recordNetworkMetrics(combinedTensorNetwork, sizeof(TNQVM_COMPLEX_TYPE));
       auto talsh_tensor =
           exatn::getLocalTensor(combinedTensorNetwork.getTensor(0)->getName());
       const TNQVM_COMPLEX_TYPE *body_ptr;
@@ -1194,6 +1093,7 @@ std::vector<uint8_t> ExatnGenVisitor<TNQVM_COMPLEX_TYPE>::getMeasureSample(
     // Evaluate
     if (exatn::evaluateSync(combinedNetwork)) {
       exatn::sync();
+      tnqvm::recordNetworkMetrics(combinedNetwork, sizeof(TNQVM_COMPLEX_TYPE));
       auto talsh_tensor =
           exatn::getLocalTensor(combinedNetwork.getTensor(0)->getName());
       const auto tensorVolume = talsh_tensor->getVolume();
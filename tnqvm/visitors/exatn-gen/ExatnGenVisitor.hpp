@@ -45,6 +45,7 @@
 #ifdef TNQVM_HAS_EXATN
 #include "TNQVMVisitor.hpp"
 #include "exatn.hpp"
+#include "ExatnRuntime.hpp"
 
 namespace tnqvm {
 enum class ObsOpType { I, X, Y, Z, NA };
@@ -84,6 +85,7 @@ public:
   virtual void initialize(std::shared_ptr<AcceleratorBuffer> buffer,
                           int nbShots) override;
   virtual void finalize() override;
+  virtual void prewarm(const HeterogeneousMap& in_options) override { ExatnRuntime::get().prewarm(in_options); }
 
   // Service name as defined in manifest.json
   virtual const std::string name() const override { return "exatn-gen"; }
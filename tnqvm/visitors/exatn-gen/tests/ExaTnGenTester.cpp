@@ -42,6 +42,10 @@ TEST(ExaTnGenTester, checkExpVal) {
       std::cout << "Angle = " << angle << ": " << buffer->getExpectationValueZ()
                 << " vs. " << expResult << "\n";
       EXPECT_NEAR(buffer->getExpectationValueZ(), expResult, 1e-3);
+      // The expectation value network evaluation is recorded in the metrics.
+      const auto counters = accelerator->getExecutionInfo().get<std::map<std::string, double>>("metrics");
+      ASSERT_TRUE(counters.count("contractions"));
+      EXPECT_GE(counters.at("contractions"), 1.0);
     }
   }
   {
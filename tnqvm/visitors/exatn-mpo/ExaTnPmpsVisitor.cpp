@@ -30,15 +30,15 @@
 */
 
 #include "ExaTnPmpsVisitor.hpp"
+#include "ExatnRuntime.hpp"
 #include "tensor_basic.hpp"
 #include "talshxx.hpp"
 #include "utils/GateMatrixAlgebra.hpp"
 #include "base/Gates.hpp"
 #include "NoiseModel.hpp"
 #include "xacc_service.hpp"
-#ifdef TNQVM_EXATN_USES_MKL_BLAS
-#include <dlfcn.h>
-#endif
+#include "utils/RandomEngine.hpp"
+#include <limits>
 
 #define INITIAL_BOND_DIM 1
 #define INITIAL_KRAUS_DIM 1
@@ -61,6 +61,7 @@ void printDensityMatrix(const exatn::TensorNetwork& in_pmpsNet, size_t in_nbQubi
     tempNetwork.rename("__TEMP__" + in_pmpsNet.getName());
     const bool evaledOk = exatn::evaluateSync(tempNetwork);
     assert(evaledOk);
+    tnqvm::recordNetworkMetrics(tempNetwork);
     auto talsh_tensor = exatn::getLocalTensor(tempNetwork.getTensor(0)->getName());
     const auto expectedDensityMatrixVolume = (1ULL << in_nbQubit) * (1ULL << in_nbQubit);
     const auto nbRows = 1ULL << in_nbQubit;
@@ -127,47 +128,88 @@ std::vector<std::complex<double>> calculateDensityMatrix(const exatn::TensorNetw
     tempNetwork.rename("__TEMP__" + in_pmpsNet.getName());
     const bool evaledOk = exatn::evaluateSync(tempNetwork);
     assert(evaledOk);
+    tnqvm::recordNetworkMetrics(tempNetwork);
     return getTensorData(tempNetwork.getTensor(0)->getName());
 }
 
-std::string generateResultBitString(const std::vector<std::complex<double>>& in_dmDiagonalElems, const std::vector<size_t>& in_measureQubits, size_t in_nbQubits, xacc::NoiseModel* in_noiseModel = nullptr)
+// Samples in_nbShots result bit strings from the diagonal of the density matrix.
+// The random numbers are drawn (seedable) in bulk and sorted, hence a single merge pass over
+// the cumulative distribution selects the states of all shots: O(2^n + shots * log(shots)).
+// Readout errors (if a noise model is provided) are applied afterward, also in bulk.
+std::vector<std::string> generateResultBitStrings(const std::vector<std::complex<double>>& in_dmDiagonalElems, const std::vector<size_t>& in_measureQubits, size_t in_nbQubits, int in_nbShots, xacc::NoiseModel* in_noiseModel = nullptr)
 {
-    static auto randomProbFunc = std::bind(std::uniform_real_distribution<double>(0, 1), std::mt19937(std::chrono::high_resolution_clock::now().time_since_epoch().count()));
-    // Pick a random probability
-    const auto probPick = randomProbFunc();
+    std::vector<std::string> results;
+    if (in_nbShots <= 0 || in_dmDiagonalElems.empty())
+    {
+        return results;
+    }
+    results.reserve(in_nbShots);
     const size_t N = in_dmDiagonalElems.size();
-    // Random state selection
+    const auto toBitString = [&](size_t in_stateIdx) {
+        std::string bitString;
+        bitString.reserve(in_measureQubits.size());
+        for (const auto& qubit : in_measureQubits)
+        {
+            const auto qubitIdx = in_nbQubits - qubit - 1;
+            bitString.push_back(((in_stateIdx >> qubitIdx) & 1) ? '1' : '0');
+        }
+        return bitString;
+    };
+
+    // Cumulative distribution (clamping tiny negative round-off values)
+    std::vector<double> cumulativeProbs(N);
     double cumulativeProb = 0.0;
+    for (size_t i = 0; i < N; ++i)
+    {
+        cumulativeProb += std::max(in_dmDiagonalElems[i].real(), 0.0);
+        cumulativeProbs[i] = cumulativeProb;
+    }
+    // Scale the picks to the trace rather than renormalizing the distribution.
+    const double totalProb = cumulativeProb;
+    const auto probPicks = tnqvm::randomEngine::get_instance().sortedRandProbs(in_nbShots);
     size_t stateSelect = 0;
-    // select a state based on cumulative distribution (diagonal elements)
-    while (cumulativeProb < probPick && stateSelect < N)
+    std::string stateBitString = toBitString(stateSelect);
+    for (const auto& probPick : probPicks)
     {
-        cumulativeProb += in_dmDiagonalElems[stateSelect++].real();
+        const size_t prevState = stateSelect;
+        while (stateSelect + 1 < N && cumulativeProbs[stateSelect] <= probPick * totalProb)
+        {
+            ++stateSelect;
+        }
+        if (stateSelect != prevState)
+        {
+            stateBitString = toBitString(stateSelect);
+        }
+        results.emplace_back(stateBitString);
     }
 
-    // back one step
-    stateSelect--;
-    std::string result;
-    for (const auto& qubit : in_measureQubits)
+    if (in_noiseModel && !in_measureQubits.empty())
     {
-        const auto qubitIdx = in_nbQubits - qubit - 1;
-        const bool bit = ((stateSelect >> qubitIdx) & 1);
-        if (in_noiseModel)
+        // Apply Readout error:
+        std::vector<std::pair<double, double>> roErrorProbs;
+        roErrorProbs.reserve(in_measureQubits.size());
+        for (const auto& qubit : in_measureQubits)
         {
-            // Apply Readout error:
-            const auto roErrorProb = randomProbFunc();
-            const auto [meas0Prep1, meas1Prep0] = in_noiseModel->readoutError(qubit);
-            const double flipProb = bit ? meas0Prep1 : meas1Prep0;
-            const bool measBit = (roErrorProb < flipProb) ? !bit : bit;
-            result.push_back(measBit ? '1' : '0');
+            roErrorProbs.emplace_back(in_noiseModel->readoutError(qubit));
         }
-        else
+        const auto flipRandProbs = tnqvm::randomEngine::get_instance().randProbs(results.size() * in_measureQubits.size());
+        auto flipRandIter = flipRandProbs.begin();
+        for (auto& bitString : results)
         {
-            result.push_back(bit ? '1' : '0');
+            for (size_t i = 0; i < bitString.size(); ++i)
+            {
+                const auto [meas0Prep1, meas1Prep0] = roErrorProbs[i];
+                const bool bit = (bitString[i] == '1');
+                const double flipProb = bit ? meas0Prep1 : meas1Prep0;
+                if (*flipRandIter++ < flipProb)
+                {
+                    bitString[i] = bit ? '0' : '1';
+                }
+            }
         }
     }
 
-    return result;
+    return results;
 }
 
 std::vector<std::complex<double>> getGateMatrix(const xacc::Instruction& in_gate)
@@ -229,6 +271,12 @@ std::vector<std::complex<double>> getGateMatrix(const xacc::Instruction& in_gate
     return flattenGateMatrix(getMatrix());
 }
 
+tnqvm::LocalOperator toLocalOperator(const std::vector<std::complex<double>>& in_flattenedMat)
+{
+    assert(in_flattenedMat.size() == 4);
+    return { in_flattenedMat[0], in_flattenedMat[1], in_flattenedMat[2], in_flattenedMat[3] };
+}
+
 void contractSingleQubitGateTensor(const std::string& qubitTensorName, const std::string& in_gateTensorName)
 {
     auto qubitTensor =  exatn::getTensor(qubitTensorName);
@@ -285,6 +333,23 @@ void contractSingleQubitGateTensor(const std::string& qubitTensorName, const std
     assert(resultTensorDestroyed);
 }
 
+// Scales the body of a tensor in place.
+void scaleTensor(const std::string& in_tensorName, double in_factor)
+{
+    std::function<int(talsh::Tensor& in_tensor)> scaleFunc = [in_factor](talsh::Tensor& in_tensor){
+        std::complex<double> *elements;
+        if (in_tensor.getDataAccessHost(&elements))
+        {
+            for (int i = 0; i < in_tensor.getVolume(); ++i)
+            {
+                elements[i] *= in_factor;
+            }
+        }
+        return 0;
+    };
+    exatn::numericalServer->transformTensorSync(in_tensorName, std::make_shared<tnqvm::ExaTnPmpsVisitor::ExaTnTensorFunctor>(scaleFunc));
+}
+
 // Retrieve the leg Id of the connection b/w two tensors.
 std::pair<size_t, size_t> getBondLegId(const exatn::TensorNetwork& in_tensorNetwork, const std::string& in_leftTensorName, const std::string& in_rightTensorName)
 {
@@ -334,7 +399,11 @@ std::pair<size_t, size_t> getBondLegId(const exatn::TensorNetwork& in_tensorNetw
     return std::make_pair(lhsBondId, rhsBondId);
 }
 
-void contractTwoQubitGateTensor(const exatn::TensorNetwork& in_tensorNetwork, const std::vector<size_t>& in_bits, const std::string& in_gateTensorName)
+// Which factor(s) of the SVD split absorb the singular values.
+// L (R): the right (left) factor is an isometry, LR: both factors get the square root.
+enum class SvdAbsorbMode { L, R, LR };
+
+void contractTwoQubitGateTensor(const exatn::TensorNetwork& in_tensorNetwork, const std::vector<size_t>& in_bits, const std::string& in_gateTensorName, SvdAbsorbMode in_absorbMode = SvdAbsorbMode::LR)
 {
     exatn::TensorNetwork tempNetwork(in_tensorNetwork);
     const std::string q1TensorName = "Q" + std::to_string(in_bits[0]);
@@ -465,7 +534,14 @@ void contractTwoQubitGateTensor(const exatn::TensorNetwork& in_tensorNetwork, co
         exatn::sync(q1TensorName);
         exatn::sync(q2TensorName);
         // SVD decomposition using the same pattern that was used to merge two tensors
-        const bool svdOk = exatn::decomposeTensorSVDLRSync(svdPattern);
+        const bool svdOk = [&]() {
+            switch (in_absorbMode)
+            {
+                case SvdAbsorbMode::L: return exatn::decomposeTensorSVDLSync(svdPattern);
+                case SvdAbsorbMode::R: return exatn::decomposeTensorSVDRSync(svdPattern);
+                default: return exatn::decomposeTensorSVDLRSync(svdPattern);
+            }
+        }();
         assert(svdOk);
     }
 
@@ -482,37 +558,7 @@ ExaTnPmpsVisitor::ExaTnPmpsVisitor()
 void ExaTnPmpsVisitor::initialize(std::shared_ptr<AcceleratorBuffer> buffer, int nbShots)
 {
     // Initialize ExaTN (if not already initialized)
-    if (!exatn::isInitialized())
-    {
-#ifdef TNQVM_EXATN_USES_MKL_BLAS
-        // Fix for TNQVM bug #30
-        void *core_handle =
-            dlopen("@EXATN_MKL_PATH@/libmkl_core@CMAKE_SHARED_LIBRARY_SUFFIX@",
-                    RTLD_LAZY | RTLD_GLOBAL);
-        if (core_handle == nullptr) {
-            std::string err = std::string(dlerror());
-            xacc::error("Could not load mkl_core - " + err);
-        }
-
-        void *thread_handle = dlopen(
-            "@EXATN_MKL_PATH@/libmkl_gnu_thread@CMAKE_SHARED_LIBRARY_SUFFIX@",
-            RTLD_LAZY | RTLD_GLOBAL);
-        if (thread_handle == nullptr) {
-            std::string err = std::string(dlerror());
-            xacc::error("Could not load mkl_gnu_thread - " + err);
-        }
-#endif
-        // If exaTN has not been initialized, do it now.
-        exatn::initialize();
-        // ExaTN and XACC logging levels are always in-synced.
-        exatn::resetClientLoggingLevel(xacc::verbose ? xacc::getLoggingLevel() : 0);
-        exatn::resetRuntimeLoggingLevel(xacc::verbose ? xacc::getLoggingLevel() : 0);
-
-        xacc::subscribeLoggingLevel([](int level) {
-            exatn::resetClientLoggingLevel(xacc::verbose ? level : 0);
-            exatn::resetRuntimeLoggingLevel(xacc::verbose ? level : 0);
-        });
-    }
+    ExatnRuntime::get().initialize(options);
 
     m_buffer = buffer;
     m_pmpsTensorNetwork = buildInitialNetwork(buffer->size(), true);
@@ -539,6 +585,35 @@ void ExaTnPmpsVisitor::initialize(std::shared_ptr<AcceleratorBuffer> buffer, int
     // printDensityMatrix(m_pmpsTensorNetwork, m_buffer->size());
     // Since this is a noisy simulation, always run shots by default.
     m_nbShots = (nbShots < 1) ? 1024 : nbShots;
+
+    m_svdCutoff = 1e-9;
+    if (options.keyExists<double>("svd-cutoff"))
+    {
+        m_svdCutoff = options.get<double>("svd-cutoff");
+    }
+    // Max bond/Kraus dimensions: take precedent over svd-cutoff
+    m_maxBondDim = std::numeric_limits<int>::max();
+    if (options.keyExists<int>("max-bond-dim"))
+    {
+        m_maxBondDim = options.get<int>("max-bond-dim");
+        if (m_maxBondDim < 1)
+        {
+            xacc::error("Invalid max-bond-dim: " + std::to_string(m_maxBondDim));
+        }
+    }
+    m_maxKrausDim = std::numeric_limits<int>::max();
+    if (options.keyExists<int>("max-kraus-dim"))
+    {
+        m_maxKrausDim = options.get<int>("max-kraus-dim");
+        if (m_maxKrausDim < 1)
+        {
+            xacc::error("Invalid max-kraus-dim: " + std::to_string(m_maxKrausDim));
+        }
+    }
+    m_truncationFidelity = 1.0;
+    // The initial product state is in canonical form w.r.t. any site.
+    m_leftCanonicalSites = buffer->size();
+    m_rightCanonicalStart = 0;
 }
 
 exatn::TensorNetwork ExaTnPmpsVisitor::buildInitialNetwork(size_t in_nbQubits, bool in_createQubitTensors) const
@@ -658,6 +733,8 @@ exatn::TensorNetwork ExaTnPmpsVisitor::buildInitialNetwork(size_t in_nbQubits, b
 void ExaTnPmpsVisitor::finalize()
 {
     exatn::sync();
+    // Product of (1 - discarded weight) over all bond and Kraus truncations
+    m_buffer->addExtraInfo("truncation-fidelity", m_truncationFidelity);
     constexpr int MAX_QUBITS_FOR_MEASURE = 15;
     // If there are measurements:
     if (!m_measuredBits.empty()) {
@@ -691,10 +768,10 @@ void ExaTnPmpsVisitor::finalize()
             }(diagElems);
         // Validate trace = 1.0
         assert(std::abs(sumDiag - 1.0) < 1e-3);
-        for (int i = 0; i < m_nbShots; ++i) {
-          m_buffer->appendMeasurement(
-              generateResultBitString(diagElems, m_measuredBits,
-                                      m_buffer->size(), m_noiseConfig.get()));
+        for (const auto &bitString : generateResultBitStrings(
+                 diagElems, m_measuredBits, m_buffer->size(), m_nbShots,
+                 m_noiseConfig.get())) {
+          m_buffer->appendMeasurement(bitString);
         }
 
         m_measuredBits.clear();
@@ -772,10 +849,10 @@ void ExaTnPmpsVisitor::finalize()
             std::vector<size_t> shiftedMeasuredBits(m_measuredBits.size());
             std::iota(shiftedMeasuredBits.begin(), shiftedMeasuredBits.end(),
                       0);
-            for (int i = 0; i < m_nbShots; ++i) {
-              m_buffer->appendMeasurement(generateResultBitString(
-                  diagElems, shiftedMeasuredBits, m_measuredBits.size(),
-                  m_noiseConfig.get()));
+            for (const auto &bitString : generateResultBitStrings(
+                     diagElems, shiftedMeasuredBits, m_measuredBits.size(),
+                     m_nbShots, m_noiseConfig.get())) {
+              m_buffer->appendMeasurement(bitString);
             }
 
             m_measuredBits.clear();
@@ -853,6 +930,13 @@ void ExaTnPmpsVisitor::applyTwoQubitGate(xacc::quantum::Gate& in_gateInstruction
     assert(in_gateInstruction.bits().size() == 2);
     // Must be a nearest-neighbor gate
     assert(std::abs((int)in_gateInstruction.bits()[0] - (int)in_gateInstruction.bits()[1]) == 1);
+    const size_t leftSite = std::min(in_gateInstruction.bits()[0], in_gateInstruction.bits()[1]);
+    if (m_maxBondDim < std::numeric_limits<int>::max())
+    {
+        // Bond dimension may be truncated:
+        // the SVD is only optimal if the rest of the network is in canonical form.
+        moveOrthogonalityCenter(leftSite, leftSite + 1);
+    }
     const auto gateMatrix = getGateMatrix(in_gateInstruction);
     assert(gateMatrix.size() == 16);
 
@@ -867,10 +951,18 @@ void ExaTnPmpsVisitor::applyTwoQubitGate(xacc::quantum::Gate& in_gateInstruction
     const bool destroyed = exatn::destroyTensorSync(gateTensorName);
     assert(destroyed);
     m_pmpsTensorNetwork = buildInitialNetwork(m_buffer->size(), false);
+    m_leftCanonicalSites = std::min(m_leftCanonicalSites, leftSite);
+    m_rightCanonicalStart = std::max(m_rightCanonicalStart, leftSite + 2);
     // Truncate SVD:
     const std::string q1TensorName = "Q" + std::to_string(in_gateInstruction.bits()[0]);
     const std::string q2TensorName = "Q" + std::to_string(in_gateInstruction.bits()[1]);
-    truncateSvdTensors(q1TensorName, q2TensorName);
+    const double discardedWeight = truncateSvdTensors(q1TensorName, q2TensorName, m_svdCutoff, m_maxBondDim);
+    if (discardedWeight > 0.0)
+    {
+        m_truncationFidelity *= (1.0 - discardedWeight);
+        // Renormalize
+        scaleTensor(q1TensorName, 1.0 / std::sqrt(1.0 - discardedWeight));
+    }
     m_pmpsTensorNetwork = buildInitialNetwork(m_buffer->size(), false);
 
     // Apply noise (Kraus) Op
@@ -912,6 +1004,11 @@ void ExaTnPmpsVisitor::applyLocalKrausOp(size_t in_siteId, const std::string& in
    auto opTensor = exatn::getTensor(in_opTensorName);
     // Must be a 4-leg tensor
     assert(opTensor->getRank() == 4);
+    if (m_maxKrausDim < std::numeric_limits<int>::max())
+    {
+        // Kraus dimension may be truncated: bring the orthogonality center to this site.
+        moveOrthogonalityCenter(in_siteId, in_siteId);
+    }
     const auto qubitTensorName = "Q" + std::to_string(in_siteId);
     // Step 1: Merge Q - Q-dagger to form a 2-leg tensor
     std::string mergeContractionPattern;
@@ -1081,9 +1178,24 @@ void ExaTnPmpsVisitor::applyLocalKrausOp(size_t in_siteId, const std::string& in
         return krausBondNorm.size();
     };
 
-    const auto newBondDim = findCutoffDim(1e-9);
+    const auto newBondDim = std::min(findCutoffDim(m_svdCutoff), m_maxKrausDim);
     assert(newBondDim > 0);
     // std::cout << "New dim = " << newBondDim << "\n";
+    // Singular values (of the local density operator) are the squared norms of the Kraus bond slices.
+    const double discardedWeight = [&]() {
+        double totalWeight = 0.0;
+        double discarded = 0.0;
+        for (int i = 0; i < krausBondNorm.size(); ++i)
+        {
+            const double weight = krausBondNorm[i] * krausBondNorm[i];
+            totalWeight += weight;
+            if (i >= newBondDim)
+            {
+                discarded += weight;
+            }
+        }
+        return (totalWeight > 0.0) ? discarded / totalWeight : 0.0;
+    }();
     if (newBondDim < krausBondNorm.size())
     {
         auto oldShape = svdTensor1->getDimExtents();
@@ -1123,8 +1235,16 @@ void ExaTnPmpsVisitor::applyLocalKrausOp(size_t in_siteId, const std::string& in
         renameNumericTensor(newSliceTensorName, qubitTensorName);
         exatn::sync();
         //std::cout << "Change bond dim of " << qubitTensorName << " = " << newBondDim << "\n";
+        if (discardedWeight > 0.0)
+        {
+            m_truncationFidelity *= (1.0 - discardedWeight);
+            // Renormalize
+            scaleTensor(qubitTensorName, 1.0 / std::sqrt(1.0 - discardedWeight));
+        }
     }
 
+    m_leftCanonicalSites = std::min(m_leftCanonicalSites, in_siteId);
+    m_rightCanonicalStart = std::max(m_rightCanonicalStart, in_siteId + 1);
     m_pmpsTensorNetwork = buildInitialNetwork(m_buffer->size(), false);
     //m_pmpsTensorNetwork.printIt();
 }
@@ -1230,12 +1350,158 @@ void ExaTnPmpsVisitor::visit(fSim& in_fsimGate)
     applyTwoQubitGate(in_fsimGate);
 }
 
+bool ExaTnPmpsVisitor::getObservableOperators(const std::shared_ptr<CompositeInstruction>& in_function, std::vector<LocalOperator>& out_ops)
+{
+    std::vector<std::shared_ptr<xacc::quantum::Gate>> gates;
+    std::vector<size_t> measuredBits;
+    InstructionIterator it(in_function);
+    while (it.hasNext())
+    {
+        auto nextInst = it.next();
+        if (!nextInst->isEnabled() || nextInst->isComposite())
+        {
+            continue;
+        }
+        if (nextInst->name() == "Measure")
+        {
+            measuredBits.emplace_back(nextInst->bits()[0]);
+            continue;
+        }
+        auto gate = std::dynamic_pointer_cast<xacc::quantum::Gate>(nextInst);
+        if (!gate || gate->bits().size() != 1)
+        {
+            return false;
+        }
+        gates.emplace_back(gate);
+    }
+
+    // Z on the measured qubits, then walk the basis change backward
+    // (Heisenberg picture): O -> N^dagger(O) -> U^dagger * O * U
+    out_ops.assign(m_buffer->size(), LocalOperator{ 1.0, 0.0, 0.0, 1.0 });
+    for (const auto& measBit : measuredBits)
+    {
+        out_ops[measBit] = LocalOperator{ 1.0, 0.0, 0.0, -1.0 };
+    }
+    for (auto gateIter = gates.rbegin(); gateIter != gates.rend(); ++gateIter)
+    {
+        auto& gate = **gateIter;
+        if (m_noiseConfig)
+        {
+            const auto noiseChannels = m_noiseConfig->getNoiseChannels(gate);
+            for (auto channelIter = noiseChannels.rbegin(); channelIter != noiseChannels.rend(); ++channelIter)
+            {
+                // Multi-qubit channels are ignored by this simulator (see convertNoiseChannel).
+                if (channelIter->noise_qubits.size() != 1)
+                {
+                    continue;
+                }
+                std::vector<LocalOperator> krausOps;
+                for (const auto& krausMat : channelIter->mats)
+                {
+                    krausOps.emplace_back(LocalOperator{ krausMat[0][0], krausMat[0][1], krausMat[1][0], krausMat[1][1] });
+                }
+                auto& op = out_ops[channelIter->noise_qubits[0]];
+                op = applyAdjointChannel(op, krausOps);
+            }
+        }
+        auto& op = out_ops[gate.bits()[0]];
+        op = applyAdjointChannel(op, { toLocalOperator(getGateMatrix(gate)) });
+    }
+    return true;
+}
+
 const double ExaTnPmpsVisitor::getExpectationValueZ(std::shared_ptr<CompositeInstruction> in_function)
 {
-    return 0.0;
+    std::vector<LocalOperator> ops;
+    if (getObservableOperators(in_function, ops))
+    {
+        return traceProductOperators(m_pmpsTensorNetwork, m_buffer->size(), { ops })[0].real();
+    }
+
+    // General sub-circuit (e.g. with two-qubit gates): apply it to the site tensors,
+    // compute the trace, then restore the site tensors (and their canonical form / truncation tracking).
+    std::vector<std::pair<exatn::TensorShape, std::vector<std::complex<double>>>> siteTensors;
+    for (size_t i = 0; i < m_buffer->size(); ++i)
+    {
+        const std::string tensorName = "Q" + std::to_string(i);
+        siteTensors.emplace_back(exatn::getTensor(tensorName)->getShape(), getTensorData(tensorName));
+    }
+    const size_t baseLeftCanonicalSites = m_leftCanonicalSites;
+    const size_t baseRightCanonicalStart = m_rightCanonicalStart;
+    const double baseTruncationFidelity = m_truncationFidelity;
+    const auto baseMeasuredBits = m_measuredBits;
+    m_measuredBits.clear();
+    // The sub-circuit has not been transformed with the base circuit:
+    // two-qubit gates must be nearest-neighbor.
+    auto subCircuit = std::dynamic_pointer_cast<CompositeInstruction>(in_function->clone());
+    auto nnTransform = xacc::getService<xacc::IRTransformation>("nnizer");
+    nnTransform->apply(subCircuit, nullptr, { std::make_pair("max-distance", 1) });
+    InstructionIterator it(subCircuit);
+    while (it.hasNext())
+    {
+        auto nextInst = it.next();
+        if (nextInst->isEnabled() && !nextInst->isComposite())
+        {
+            nextInst->accept(this);
+        }
+    }
+
+    ops.assign(m_buffer->size(), LocalOperator{ 1.0, 0.0, 0.0, 1.0 });
+    for (const auto& measBit : m_measuredBits)
+    {
+        ops[measBit] = LocalOperator{ 1.0, 0.0, 0.0, -1.0 };
+    }
+    const double expValZ = traceProductOperators(m_pmpsTensorNetwork, m_buffer->size(), { ops })[0].real();
+
+    for (size_t i = 0; i < m_buffer->size(); ++i)
+    {
+        const std::string tensorName = "Q" + std::to_string(i);
+        const bool destroyed = exatn::destroyTensorSync(tensorName);
+        assert(destroyed);
+        const bool created = exatn::createTensorSync(tensorName, exatn::TensorElementType::COMPLEX64, siteTensors[i].first);
+        assert(created);
+        const bool initialized = exatn::initTensorDataSync(tensorName, siteTensors[i].second);
+        assert(initialized);
+    }
+    m_pmpsTensorNetwork = buildInitialNetwork(m_buffer->size(), false);
+    m_leftCanonicalSites = baseLeftCanonicalSites;
+    m_rightCanonicalStart = baseRightCanonicalStart;
+    m_truncationFidelity = baseTruncationFidelity;
+    m_measuredBits = baseMeasuredBits;
+    return expValZ;
+}
+
+std::vector<double> ExaTnPmpsVisitor::getExpectationValueZBatch(const std::vector<std::shared_ptr<CompositeInstruction>>& in_functions)
+{
+    std::vector<double> result(in_functions.size(), 0.0);
+    // Observables of single-qubit basis changes are traced together
+    // (same network topology, hence a single contraction sequence).
+    std::vector<std::vector<LocalOperator>> products;
+    std::vector<size_t> productFunctionIdx;
+    for (size_t i = 0; i < in_functions.size(); ++i)
+    {
+        std::vector<LocalOperator> ops;
+        if (getObservableOperators(in_functions[i], ops))
+        {
+            products.emplace_back(std::move(ops));
+            productFunctionIdx.emplace_back(i);
+        }
+        else
+        {
+            result[i] = getExpectationValueZ(in_functions[i]);
+        }
+    }
+
+    const auto traceVals = traceProductOperators(m_pmpsTensorNetwork, m_buffer->size(), products);
+    assert(traceVals.size() == products.size());
+    for (size_t i = 0; i < traceVals.size(); ++i)
+    {
+        result[productFunctionIdx[i]] = traceVals[i].real();
+    }
+    return result;
 }
 
-void ExaTnPmpsVisitor::truncateSvdTensors(const std::string& in_leftTensorName, const std::string& in_rightTensorName, double in_eps)
+double ExaTnPmpsVisitor::truncateSvdTensors(const std::string& in_leftTensorName, const std::string& in_rightTensorName, double in_eps, int in_maxBondDim)
 {
     int lhsTensorId = -1;
     int rhsTensorId = -1;
@@ -1292,7 +1558,8 @@ void ExaTnPmpsVisitor::truncateSvdTensors(const std::string& in_leftTensorName,
 
     // Algorithm:
     // Lnorm(k) = Sum_ab [L(a,b,k)^2] and Rnorm(k) = Sum_c [R(k,c)]
-    // Truncate k dimension by to k_opt where Lnorm(k_opt) < eps &&  Rnorm(k_opt) < eps
+    // Truncate k dimension by to k_opt where Lnorm(k_opt) < eps || Rnorm(k_opt) < eps
+    // (one of the factors is an isometry if the singular values were absorbed into the other one)
     std::vector<double> leftNorm;
     const bool leftNormOk = exatn::computePartialNormsSync(in_leftTensorName, lhsBondId, leftNorm);
     assert(leftNormOk);
@@ -1306,7 +1573,7 @@ void ExaTnPmpsVisitor::truncateSvdTensors(const std::string& in_leftTensorName,
     const auto findCutoffDim = [&]() -> int {
         for (int i = 0; i < bondDim; ++i)
         {
-            if (leftNorm[i] < in_eps && rightNorm[i] < in_eps)
+            if (leftNorm[i] < in_eps || rightNorm[i] < in_eps)
             {
                 return i + 1;
             }
@@ -1314,8 +1581,21 @@ void ExaTnPmpsVisitor::truncateSvdTensors(const std::string& in_leftTensorName,
         return bondDim;
     };
 
-    const auto newBondDim = findCutoffDim();
+    const auto newBondDim = std::min<int>(findCutoffDim(), in_maxBondDim);
     assert(newBondDim > 0);
+    // Singular value k is the product of the partial norms of the two SVD factors
+    // (regardless of which factor(s) absorbed the singular values).
+    double totalWeight = 0.0;
+    double discardedWeight = 0.0;
+    for (int i = 0; i < bondDim; ++i)
+    {
+        const double singularVal = leftNorm[i] * rightNorm[i];
+        totalWeight += singularVal * singularVal;
+        if (i >= newBondDim)
+        {
+            discardedWeight += singularVal * singularVal;
+        }
+    }
     if (newBondDim < bondDim)
     {
         auto leftShape = lhsTensor->getDimExtents();
@@ -1371,5 +1651,67 @@ void ExaTnPmpsVisitor::truncateSvdTensors(const std::string& in_leftTensorName,
         // Debug:
         // std::cout << "[DEBUG] Bond dim (" << in_leftTensorName << ", " << in_rightTensorName << "): " << bondDim << " -> " << newBondDim << "\n";
     }
+
+    return (totalWeight > 0.0) ? discardedWeight / totalWeight : 0.0;
+}
+
+void ExaTnPmpsVisitor::canonicalizeBond(size_t in_leftSiteId, bool in_leftIsometry)
+{
+    assert(in_leftSiteId + 1 < m_buffer->size());
+    // Re-split the two neighboring site tensors (identity gate), the singular values
+    // are absorbed into the right (left) tensor, leaving the other one an isometry.
+    const std::string idTensorName = "__CANON_ID__";
+    // Gate tensor legs are (c1, c0, u0, u2) in the contraction pattern of contractTwoQubitGateTensor,
+    // i.e. the identity is delta(u0, c0) * delta(u2, c1).
+    std::vector<std::complex<double>> idMatrix(16, {0.0, 0.0});
+    for (size_t c0 = 0; c0 < 2; ++c0)
+    {
+        for (size_t c1 = 0; c1 < 2; ++c1)
+        {
+            idMatrix[c1 + 2 * c0 + 4 * c0 + 8 * c1] = 1.0;
+        }
+    }
+    const bool created = exatn::createTensorSync(idTensorName, exatn::TensorElementType::COMPLEX64, exatn::TensorShape{ 2, 2, 2, 2 });
+    assert(created);
+    const bool initialized = exatn::initTensorDataSync(idTensorName, idMatrix);
+    assert(initialized);
+    contractTwoQubitGateTensor(m_pmpsTensorNetwork, { in_leftSiteId, in_leftSiteId + 1 }, idTensorName, in_leftIsometry ? SvdAbsorbMode::R : SvdAbsorbMode::L);
+    const bool destroyed = exatn::destroyTensorSync(idTensorName);
+    assert(destroyed);
+    m_pmpsTensorNetwork = buildInitialNetwork(m_buffer->size(), false);
+    // Drop the zero-padded part of the bond (exact up to the SVD cut-off).
+    truncateSvdTensors("Q" + std::to_string(in_leftSiteId), "Q" + std::to_string(in_leftSiteId + 1), m_svdCutoff, std::numeric_limits<int>::max());
+    m_pmpsTensorNetwork = buildInitialNetwork(m_buffer->size(), false);
+
+    if (in_leftIsometry)
+    {
+        if (m_leftCanonicalSites == in_leftSiteId)
+        {
+            m_leftCanonicalSites = in_leftSiteId + 1;
+        }
+        m_rightCanonicalStart = std::max(m_rightCanonicalStart, in_leftSiteId + 2);
+    }
+    else
+    {
+        if (m_rightCanonicalStart == in_leftSiteId + 2)
+        {
+            m_rightCanonicalStart = in_leftSiteId + 1;
+        }
+        m_leftCanonicalSites = std::min(m_leftCanonicalSites, in_leftSiteId);
+    }
+}
+
+void ExaTnPmpsVisitor::moveOrthogonalityCenter(size_t in_firstSiteId, size_t in_lastSiteId)
+{
+    // Left sweep: sites before the center become left isometries
+    while (m_leftCanonicalSites < in_firstSiteId)
+    {
+        canonicalizeBond(m_leftCanonicalSites, true);
+    }
+    // Right sweep: sites after the center become right isometries
+    while (m_rightCanonicalStart > in_lastSiteId + 1)
+    {
+        canonicalizeBond(m_rightCanonicalStart - 2, false);
+    }
 }
 }
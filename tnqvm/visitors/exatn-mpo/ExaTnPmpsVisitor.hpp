@@ -37,7 +37,15 @@
  * +-----------------------------+------------------------------------------------------------------------+-------------+--------------------------+
  * | backend                     | Name of the IBMQ backend to query the backend configuration.           |    string   | None                     |
  * +-----------------------------+------------------------------------------------------------------------+-------------+--------------------------+
+ * | svd-cutoff                  | SVD cut-off limit (bond and Kraus dimensions).                         |    double   | 1e-9                     |
+ * +-----------------------------+------------------------------------------------------------------------+-------------+--------------------------+
+ * | max-bond-dim                | Max bond dimension to keep.                                            |    int      | no limit                 |
+ * +-----------------------------+------------------------------------------------------------------------+-------------+--------------------------+
+ * | max-kraus-dim               | Max Kraus (purification) dimension to keep.                            |    int      | no limit                 |
+ * +-----------------------------+------------------------------------------------------------------------+-------------+--------------------------+
  * If either `backend-json` or `backend` is provided, the `exatn-pmps` simulator will simulate the backend noise associated with each quantum gate.
+ * If `max-bond-dim` or `max-kraus-dim` is set, the purified MPS is kept in (mixed) canonical form around the truncated bond/site
+ * and the accumulated truncation fidelity is reported as `truncation-fidelity` in the buffer.
 */
 
 #pragma once
@@ -45,6 +53,8 @@
 #include "TNQVMVisitor.hpp"
 #include "tensor_network.hpp"
 #include "exatn.hpp"
+#include "ExatnRuntime.hpp"
+#include "DensityOperatorTrace.hpp"
 
 namespace xacc {
 // Forward declaration
@@ -68,6 +78,7 @@ public:
     // Virtual function impls:
     virtual void initialize(std::shared_ptr<AcceleratorBuffer> buffer, int nbShots) override;
     virtual void finalize() override;
+    virtual void prewarm(const HeterogeneousMap& in_options) override { ExatnRuntime::get().prewarm(in_options); }
 
     // Service name as defined in manifest.json
     virtual const std::string name() const override { return "exatn-pmps"; }
@@ -97,6 +108,9 @@ public:
     virtual void visit(Measure& in_MeasureGate) override;
 
     virtual const double getExpectationValueZ(std::shared_ptr<CompositeInstruction> in_function) override;
+    // VQE mode: the noisy ansatz is simulated once, each observable sub-circuit is traced against the purified MPS.
+    virtual bool supportVqeMode() const override { return true; }
+    virtual std::vector<double> getExpectationValueZBatch(const std::vector<std::shared_ptr<CompositeInstruction>>& in_functions) override;
     class ExaTnTensorFunctor : public talsh::TensorFunctor<exatn::Identifiable>
     {
     public:
@@ -119,13 +133,29 @@ public:
     void applyKrausOp(const KrausOp& in_op);
     // Apply a local (single-site) Kraus operator
     void applyLocalKrausOp(size_t in_siteId, const std::string& in_opTensorName);
-    void truncateSvdTensors(const std::string& in_leftTensorName, const std::string& in_rightTensorName, double in_eps = 1e-9);
+    // Truncates the bond b/w two neighboring qubit tensors, returns the discarded weight (fraction of the squared singular values).
+    double truncateSvdTensors(const std::string& in_leftTensorName, const std::string& in_rightTensorName, double in_eps, int in_maxBondDim);
+    // Re-splits the bond b/w sites (in_leftSiteId, in_leftSiteId + 1) making the left (or right) site an isometry.
+    void canonicalizeBond(size_t in_leftSiteId, bool in_leftIsometry);
+    // Sweeps so that all sites before in_firstSiteId are left isometries and all sites after in_lastSiteId are right isometries.
+    void moveOrthogonalityCenter(size_t in_firstSiteId, size_t in_lastSiteId);
     std::vector<KrausOp> convertNoiseChannel(const std::vector<NoiseChannelKraus>& in_channels) const;
+    // Z-string observable of a sub-circuit as a product of single-qubit operators (Heisenberg picture),
+    // returns false if the sub-circuit is not local, e.g. it has multi-qubit gates.
+    bool getObservableOperators(const std::shared_ptr<CompositeInstruction>& in_function, std::vector<LocalOperator>& out_ops);
 private:
     exatn::TensorNetwork m_pmpsTensorNetwork;
     std::shared_ptr<AcceleratorBuffer> m_buffer;
     std::shared_ptr<xacc::NoiseModel> m_noiseConfig;
     std::vector<size_t> m_measuredBits;
     int m_nbShots;
+    double m_svdCutoff;
+    int m_maxBondDim;
+    int m_maxKrausDim;
+    double m_truncationFidelity;
+    // Canonical form tracking: sites [0, m_leftCanonicalSites) are left isometries,
+    // sites [m_rightCanonicalStart, N) are right isometries.
+    size_t m_leftCanonicalSites;
+    size_t m_rightCanonicalStart;
 };
 } // namespace tnqvm
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include <gtest/gtest.h>
 #include "xacc.hpp"
 #include "xacc_service.hpp"
+#include "xacc_observable.hpp"
 #include <fstream>
 
 namespace {
@@ -109,6 +110,105 @@ TEST(ExaTnPmpsTester, checkManyQubits) {
   EXPECT_NEAR(qreg->computeMeasurementProbability("000000"), 0.5, 0.1);
 }
 
+TEST(ExaTnPmpsTester, checkTruncation) {
+  auto xasmCompiler = xacc::getCompiler("xasm");
+  auto ir = xasmCompiler->compile(R"(__qpu__ void testTruncate(qbit q) {
+    H(q[0]);
+    CX(q[0], q[1]);
+    CX(q[1], q[2]);
+    Ry(q[1], 0.7);
+    CX(q[2], q[3]);
+    Rx(q[2], 1.3);
+    CX(q[1], q[2]);
+    Measure(q[0]);
+    Measure(q[1]);
+    Measure(q[2]);
+    Measure(q[3]);
+  })");
+  auto program = ir->getComposites()[0];
+  // Zero: no limit
+  const auto runWithLimits = [&](int in_maxBondDim, int in_maxKrausDim) {
+    xacc::HeterogeneousMap options{{"tnqvm-visitor", "exatn-pmps"},
+                                   {"backend-json", getBackendJson()}};
+    if (in_maxBondDim > 0) {
+      options.insert("max-bond-dim", in_maxBondDim);
+    }
+    if (in_maxKrausDim > 0) {
+      options.insert("max-kraus-dim", in_maxKrausDim);
+    }
+    auto accelerator = xacc::getAccelerator("tnqvm", options);
+    auto qreg = xacc::qalloc(4);
+    accelerator->execute(qreg, program);
+    return qreg;
+  };
+
+  auto refBuffer = runWithLimits(0, 0);
+  // Bounds that are never reached: same density matrix
+  // (the network is re-gauged by the canonicalization sweeps).
+  auto boundedBuffer =
+      runWithLimits(64, 64);
+  const auto refDm =
+      (*refBuffer)["density_matrix"].as<std::vector<std::pair<double, double>>>();
+  const auto boundedDm =
+      (*boundedBuffer)["density_matrix"].as<std::vector<std::pair<double, double>>>();
+  ASSERT_EQ(refDm.size(), boundedDm.size());
+  for (size_t i = 0; i < refDm.size(); ++i) {
+    EXPECT_NEAR(refDm[i].first, boundedDm[i].first, 1e-6);
+    EXPECT_NEAR(refDm[i].second, boundedDm[i].second, 1e-6);
+  }
+  EXPECT_NEAR((*boundedBuffer)["truncation-fidelity"].as<double>(), 1.0, 1e-6);
+
+  // Product-state approximation: lossy, but still a valid (normalized) state.
+  auto truncatedBuffer =
+      runWithLimits(1, 1);
+  const double fidelity =
+      (*truncatedBuffer)["truncation-fidelity"].as<double>();
+  EXPECT_LT(fidelity, 0.9);
+  EXPECT_GT(fidelity, 0.0);
+  const auto truncatedDm =
+      (*truncatedBuffer)["density_matrix"].as<std::vector<std::pair<double, double>>>();
+  double trace = 0.0;
+  for (size_t i = 0; i < 16; ++i) {
+    trace += truncatedDm[i * 16 + i].first;
+  }
+  EXPECT_NEAR(trace, 1.0, 1e-6);
+}
+
+TEST(ExaTnPmpsTester, checkVqeMode) {
+  xacc::qasm(R"(
+        .compiler xasm
+        .circuit pmps_vqe_ansatz
+        .qbit q
+        H(q[0]);
+        CNOT(q[0], q[1]);
+        Ry(q[2], 0.6);
+        CNOT(q[1], q[2]);
+    )");
+  auto ansatz = xacc::getCompiled("pmps_vqe_ansatz");
+  auto observable = xacc::quantum::getObservable(
+      "pauli", std::string("X0 X1 + Z0 Z1 + Y0 Y1 + Z0 + Z2 + X2 + X0 Y1 Z2"));
+  auto kernels = observable->observe(ansatz);
+
+  // Noiseless: the purified MPS traces must match the exact expectation values.
+  auto qreg = xacc::qalloc(3);
+  auto accelerator = xacc::getAccelerator(
+      "tnqvm", {{"tnqvm-visitor", "exatn-pmps"}, {"vqe-mode", true}});
+  accelerator->execute(qreg, kernels);
+
+  auto refBuffer = xacc::qalloc(3);
+  auto refAcc = xacc::getAccelerator("tnqvm", {{"tnqvm-visitor", "exatn"}});
+  refAcc->execute(refBuffer, kernels);
+
+  const auto children = qreg->getChildren();
+  const auto refChildren = refBuffer->getChildren();
+  ASSERT_EQ(children.size(), kernels.size());
+  ASSERT_EQ(refChildren.size(), kernels.size());
+  for (size_t i = 0; i < kernels.size(); ++i) {
+    EXPECT_NEAR(children[i]->getExpectationValueZ(),
+                refChildren[i]->getExpectationValueZ(), 1e-6);
+  }
+}
+
 int main(int argc, char **argv) {
   xacc::Initialize();
   ::testing::InitGoogleTest(&argc, argv);
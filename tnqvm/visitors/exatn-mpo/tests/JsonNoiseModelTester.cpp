@@ -122,6 +122,43 @@ TEST(JsonNoiseModelTester, checkRoError) {
   }
 }
 
+TEST(JsonNoiseModelTester, checkSeededSampling) {
+  auto xasmCompiler = xacc::getCompiler("xasm");
+  auto noiseModel = xacc::getService<xacc::NoiseModel>("json");
+  noiseModel->initialize({{"noise-model", ro_error_noise_model}});
+  auto program = xasmCompiler
+                     ->compile(R"(__qpu__ void testSeeded(qbit q) {
+        H(q[0]);
+        CNOT(q[0], q[1]);
+        Measure(q[0]);
+        Measure(q[1]);
+      })",
+                               nullptr)
+                     ->getComposites()[0];
+  // Shots (and readout errors) are sampled from the seedable random engine.
+  const auto runSeeded = [&]() {
+    auto accelerator = xacc::getAccelerator("tnqvm", {{"tnqvm-visitor", "exatn-pmps"},
+                                                      {"noise-model", noiseModel},
+                                                      {"shots", 8192},
+                                                      {"seed", 123}});
+    auto buffer = xacc::qalloc(2);
+    accelerator->execute(buffer, program);
+    return buffer->getMeasurementCounts();
+  };
+  const auto counts = runSeeded();
+  EXPECT_EQ(counts, runSeeded());
+  int totalCount = 0;
+  for (const auto &[bitString, count] : counts) {
+    totalCount += count;
+  }
+  EXPECT_EQ(totalCount, 8192);
+  // Bell state with readout errors on q[0] only:
+  // P(0|1) = 0.2 and P(1|0) = 0.1, i.e. 15% of the shots are anti-correlated.
+  const int antiCorrelated = (counts.count("01") ? counts.at("01") : 0) +
+                             (counts.count("10") ? counts.at("10") : 0);
+  EXPECT_NEAR(antiCorrelated / 8192.0, 0.15, 0.03);
+}
+
 int main(int argc, char **argv) {
   xacc::Initialize(argc, argv);
   ::testing::InitGoogleTest(&argc, argv);
@@ -2,6 +2,7 @@
 #include "cppmicroservices/BundleContext.h"
 #include "cppmicroservices/ServiceProperties.h"
 #include "ExaTnMpsVisitor.hpp"
+#include "ExaTnMpsTrajectoryVisitor.hpp"
 #include "NearestNeighborTransform.hpp"
 #include "RandomCircuitGen.hpp"
 
@@ -14,6 +15,10 @@ public:
   void Start(BundleContext context)
   {
     context.RegisterService<tnqvm::TNQVMVisitor>(std::make_shared<tnqvm::ExatnMpsVisitor>());
+#ifndef TNQVM_MPI_ENABLED
+    // Trajectories need the whole MPS on each process.
+    context.RegisterService<tnqvm::TNQVMVisitor>(std::make_shared<tnqvm::ExatnMpsTrajectoryVisitor>());
+#endif
     context.RegisterService<xacc::IRTransformation>(std::make_shared<xacc::quantum::NearestNeighborTransform>());
     context.RegisterService<xacc::Instruction>(std::make_shared<xacc::circuits::RCS>());
   }
@@ -0,0 +1,323 @@
+/***********************************************************************************
+ * Copyright (c) 2017, UT-Battelle
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the xacc nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Contributors:
+ *   Implementation - Thien Nguyen
+ *
+*/
+
+#include "ExaTnMpsTrajectoryVisitor.hpp"
+#include "exatn.hpp"
+#include "xacc.hpp"
+#include "NoiseModel.hpp"
+#include "utils/RandomEngine.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Number of trajectories when no shots are requested (exp-val-z)
+const int DEFAULT_NB_TRAJECTORIES = 100;
+
+// Checks if the (row-major) matrix is c * Identity, returns c.
+bool isProportionalToIdentity(const std::vector<std::complex<double>>& in_mat, size_t in_dim, std::complex<double>& out_factor)
+{
+    constexpr double TOLERANCE = 1e-12;
+    out_factor = in_mat[0];
+    for (size_t row = 0; row < in_dim; ++row)
+    {
+        for (size_t col = 0; col < in_dim; ++col)
+        {
+            const std::complex<double> expected = (row == col) ? out_factor : 0.0;
+            if (std::abs(in_mat[row * in_dim + col] - expected) > TOLERANCE)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+} // namespace
+
+namespace tnqvm {
+void ExatnMpsTrajectoryVisitor::initialize(std::shared_ptr<AcceleratorBuffer> buffer, int nbShots)
+{
+    ExatnMpsVisitor::initialize(std::move(buffer), nbShots);
+    m_noiseConfig.reset();
+    if (options.pointerLikeExists<xacc::NoiseModel>("noise-model"))
+    {
+        m_noiseConfig = xacc::as_shared_ptr(options.getPointerLike<xacc::NoiseModel>("noise-model"));
+    }
+
+    m_nbTrajectories = (nbShots > 0) ? nbShots : DEFAULT_NB_TRAJECTORIES;
+    if (options.keyExists<int>("trajectories"))
+    {
+        m_nbTrajectories = options.get<int>("trajectories");
+        if (m_nbTrajectories < 1)
+        {
+            xacc::error("Invalid 'trajectories' parameter.");
+        }
+    }
+    // At least one shot per trajectory.
+    if (nbShots > 0)
+    {
+        m_nbTrajectories = std::min(m_nbTrajectories, nbShots);
+    }
+    // Noiseless: all trajectories are identical.
+    if (!m_noiseConfig)
+    {
+        m_nbTrajectories = 1;
+    }
+    m_gates.clear();
+    m_replaying = false;
+}
+
+void ExatnMpsTrajectoryVisitor::finalize()
+{
+    const auto measureQubits = m_measureQubits;
+    double expValZSum = 0.0;
+    for (int trajectoryId = 0; trajectoryId < m_nbTrajectories && !measureQubits.empty(); ++trajectoryId)
+    {
+        // The first trajectory has been simulated while visiting the circuit.
+        if (trajectoryId > 0)
+        {
+            resetState();
+            m_replaying = true;
+            for (auto& gate : m_gates)
+            {
+                if (gate->name() == "I")
+                {
+                    applyNoise(*gate);
+                }
+                else
+                {
+                    applyGate(*gate);
+                }
+            }
+            m_replaying = false;
+        }
+
+        if (m_shotCount > 0)
+        {
+            const int nbShots = m_shotCount / m_nbTrajectories + ((trajectoryId < m_shotCount % m_nbTrajectories) ? 1 : 0);
+            for (const auto& bitString : getMeasureSamples(measureQubits, nbShots))
+            {
+                m_buffer->appendMeasurement(bitString);
+            }
+        }
+        else
+        {
+            expValZSum += computeExpectationValueZ(measureQubits);
+        }
+    }
+
+    if (!measureQubits.empty() && m_shotCount < 1)
+    {
+        m_buffer->addExtraInfo("exp-val-z", expValZSum / m_nbTrajectories);
+    }
+
+    // Always reset the logging level back to 0 when finished.
+    exatn::resetClientLoggingLevel(0);
+    exatn::resetRuntimeLoggingLevel(0);
+    for (int i = 0; i < m_buffer->size(); ++i)
+    {
+        const bool qTensorDestroyed = exatn::destroyTensor("Q" + std::to_string(i));
+        assert(qTensorDestroyed);
+    }
+    m_gates.clear();
+}
+
+void ExatnMpsTrajectoryVisitor::visit(Identity& in_IdentityGate)
+{
+    // No gate tensor to apply, only its noise.
+    recordGate(in_IdentityGate);
+    applyNoise(in_IdentityGate);
+}
+
+void ExatnMpsTrajectoryVisitor::applyGate(xacc::Instruction& in_gateInstruction)
+{
+    recordGate(in_gateInstruction);
+    ExatnMpsVisitor::applyGate(in_gateInstruction);
+    applyNoise(in_gateInstruction);
+}
+
+void ExatnMpsTrajectoryVisitor::recordGate(xacc::Instruction& in_gateInstruction)
+{
+    if (!m_replaying && m_nbTrajectories > 1)
+    {
+        m_gates.emplace_back(in_gateInstruction.clone());
+    }
+}
+
+void ExatnMpsTrajectoryVisitor::applyNoise(xacc::Instruction& in_gateInstruction)
+{
+    auto gate = dynamic_cast<xacc::quantum::Gate*>(&in_gateInstruction);
+    if (!m_noiseConfig || !gate)
+    {
+        return;
+    }
+
+    for (const auto& channel : m_noiseConfig->getNoiseChannels(*gate))
+    {
+        const size_t nbChannelQubits = channel.noise_qubits.size();
+        if (nbChannelQubits != 1 && nbChannelQubits != 2)
+        {
+            xacc::error("Unsupported noise data.");
+        }
+        // Qubits of the Kraus matrices, the first one being the most significant bit.
+        std::vector<size_t> opQubits(channel.noise_qubits.begin(), channel.noise_qubits.end());
+        if (nbChannelQubits == 2 && channel.bit_order == KrausMatBitOrder::LSB)
+        {
+            std::swap(opQubits[0], opQubits[1]);
+        }
+        const size_t dim = 1ULL << nbChannelQubits;
+
+        // Row-major Kraus operators and K^dagger * K
+        std::vector<std::vector<std::complex<double>>> krausOps;
+        std::vector<std::vector<std::complex<double>>> krausNorms;
+        bool stateIndependent = true;
+        for (const auto& mat : channel.mats)
+        {
+            assert(mat.size() == dim);
+            std::vector<std::complex<double>> krausOp;
+            krausOp.reserve(dim * dim);
+            for (const auto& row : mat)
+            {
+                krausOp.insert(krausOp.end(), row.begin(), row.end());
+            }
+            std::vector<std::complex<double>> krausNorm(dim * dim, 0.0);
+            for (size_t row = 0; row < dim; ++row)
+            {
+                for (size_t col = 0; col < dim; ++col)
+                {
+                    for (size_t k = 0; k < dim; ++k)
+                    {
+                        krausNorm[row * dim + col] += std::conj(krausOp[k * dim + row]) * krausOp[k * dim + col];
+                    }
+                }
+            }
+            std::complex<double> factor;
+            stateIndependent = stateIndependent && isProportionalToIdentity(krausNorm, dim, factor);
+            krausOps.emplace_back(std::move(krausOp));
+            krausNorms.emplace_back(std::move(krausNorm));
+        }
+
+        // Branch probabilities: p_k = Tr(K_k^dagger * K_k * rho).
+        // These don't depend on the state if all K_k^dagger * K_k are proportional to the identity (e.g. Pauli channels),
+        // otherwise, the reduced density matrix of the channel qubits is needed.
+        std::vector<std::complex<double>> rdm;
+        if (!stateIndependent)
+        {
+            auto sortedQubits = opQubits;
+            std::sort(sortedQubits.begin(), sortedQubits.end());
+            rdm = getReducedDensityMatrix(sortedQubits);
+            if (sortedQubits != opQubits)
+            {
+                // Swap the bit order of the two-qubit RDM
+                const auto swapBits = [](size_t in_idx) { return ((in_idx & 1) << 1) | (in_idx >> 1); };
+                auto swappedRdm = rdm;
+                for (size_t row = 0; row < dim; ++row)
+                {
+                    for (size_t col = 0; col < dim; ++col)
+                    {
+                        swappedRdm[row * dim + col] = rdm[swapBits(row) * dim + swapBits(col)];
+                    }
+                }
+                rdm = std::move(swappedRdm);
+            }
+        }
+        std::vector<double> probs;
+        double totalProb = 0.0;
+        for (const auto& krausNorm : krausNorms)
+        {
+            double prob = 0.0;
+            if (stateIndependent)
+            {
+                prob = krausNorm[0].real();
+            }
+            else
+            {
+                for (size_t row = 0; row < dim; ++row)
+                {
+                    for (size_t col = 0; col < dim; ++col)
+                    {
+                        prob += (krausNorm[row * dim + col] * rdm[col * dim + row]).real();
+                    }
+                }
+            }
+            probs.emplace_back(std::max(prob, 0.0));
+            totalProb += probs.back();
+        }
+
+        // Sample the branch
+        const double randProb = randomEngine::get_instance().randProb() * totalProb;
+        size_t branchIdx = 0;
+        double cumulativeProb = probs[0];
+        while (cumulativeProb <= randProb && branchIdx + 1 < probs.size())
+        {
+            ++branchIdx;
+            cumulativeProb += probs[branchIdx];
+        }
+        while (probs[branchIdx] <= 0.0 && branchIdx > 0)
+        {
+            --branchIdx;
+        }
+
+        // Apply the normalized Kraus operator (nothing to do if it is proportional to the identity).
+        auto krausOp = krausOps[branchIdx];
+        std::complex<double> factor;
+        if (isProportionalToIdentity(krausOp, dim, factor))
+        {
+            continue;
+        }
+        const double normalization = 1.0 / std::sqrt(probs[branchIdx] / totalProb);
+        for (auto& val : krausOp)
+        {
+            val *= normalization;
+        }
+        if (nbChannelQubits == 1)
+        {
+            applySingleQubitOperator(opQubits[0], krausOp);
+        }
+        else
+        {
+            applyTwoQubitOperator(opQubits[0], opQubits[1], krausOp);
+        }
+    }
+}
+
+void ExatnMpsTrajectoryVisitor::resetState()
+{
+    for (int i = 0; i < m_buffer->size(); ++i)
+    {
+        const bool qTensorDestroyed = exatn::destroyTensorSync("Q" + std::to_string(i));
+        assert(qTensorDestroyed);
+    }
+    // Re-create the MPS tensors in the |0...0> state, keeping the measured qubits.
+    const auto measureQubits = m_measureQubits;
+    ExatnMpsVisitor::initialize(m_buffer, m_shotCount);
+    m_measureQubits = measureQubits;
+}
+} // namespace tnqvm
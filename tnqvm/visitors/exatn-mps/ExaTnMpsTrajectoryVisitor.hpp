@@ -0,0 +1,91 @@
+/***********************************************************************************
+ * Copyright (c) 2017, UT-Battelle
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the xacc nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Contributors:
+ *   Implementation - Thien Nguyen
+ *
+ * Noisy MPS visitor (stochastic trajectories):
+ * Name: "exatn-mps-traj"
+ * Each trajectory evolves a pure-state MPS (as "exatn-mps" does). After each gate, one Kraus operator of every noise channel
+ * of that gate is sampled (with its Born probability) and applied, then the state is renormalized.
+ * Averaging over trajectories reproduces the statistics of the noisy (density matrix) simulation
+ * at the memory cost of a pure-state MPS.
+ * Supported initialization keys (in addition to those of "exatn-mps"):
+ * +-----------------------------+------------------------------------------------------------------------+-------------+--------------------------+
+ * |  Initialization Parameter   |                  Parameter Description                                 |    type     |         default          |
+ * +=============================+========================================================================+=============+==========================+
+ * | noise-model                 | The noise model (Kraus channels of each gate) to simulate.             | NoiseModel* | None (noiseless)         |
+ * +-----------------------------+------------------------------------------------------------------------+-------------+--------------------------+
+ * | trajectories                | Number of trajectories. The shots are distributed evenly among them;   |    int      | shots (100 w/o shots)    |
+ * |                             | without shots, exp-val-z is the average over the trajectories.         |             |                          |
+ * +-----------------------------+------------------------------------------------------------------------+-------------+--------------------------+
+ * Note: the trajectories are simulated one after the other, each of them using the ExaTN runtime as "exatn-mps" does.
+*/
+
+#pragma once
+
+#include "ExaTnMpsVisitor.hpp"
+
+namespace xacc {
+// Forward declaration
+class NoiseModel;
+} // namespace xacc
+
+namespace tnqvm {
+class ExatnMpsTrajectoryVisitor : public ExatnMpsVisitor
+{
+public:
+    // Virtual function impls:
+    virtual void initialize(std::shared_ptr<AcceleratorBuffer> buffer, int nbShots) override;
+    virtual void finalize() override;
+
+    // Service name as defined in manifest.json
+    virtual const std::string name() const override { return "exatn-mps-traj"; }
+    virtual const std::string description() const override { return "ExaTN MPS Noisy Trajectory Visitor"; }
+    virtual std::shared_ptr<TNQVMVisitor> clone() override { return std::make_shared<ExatnMpsTrajectoryVisitor>(); }
+    using ExatnMpsVisitor::visit;
+    // Identity gates don't change the state but may carry noise channels (e.g. idle/thermal relaxation).
+    virtual void visit(Identity& in_IdentityGate) override;
+
+protected:
+    virtual void applyGate(xacc::Instruction& in_gateInstruction) override;
+
+private:
+    // Records the gate for the next trajectories (if any).
+    void recordGate(xacc::Instruction& in_gateInstruction);
+    // Samples one Kraus operator of each noise channel of the gate and applies it (normalized).
+    void applyNoise(xacc::Instruction& in_gateInstruction);
+    // Resets the MPS to |0...0> for the next trajectory.
+    void resetState();
+
+private:
+    std::shared_ptr<xacc::NoiseModel> m_noiseConfig;
+    int m_nbTrajectories;
+    // Gates of the circuit, replayed (with newly sampled noise) by the trajectories after the first one.
+    std::vector<std::shared_ptr<xacc::Instruction>> m_gates;
+    bool m_replaying;
+};
+} // namespace tnqvm
@@ -34,13 +34,14 @@
 #include "tensor_basic.hpp"
 #include "talshxx.hpp"
 #include "ExatnUtils.hpp"
+#include "ExatnRuntime.hpp"
 #include "utils/GateMatrixAlgebra.hpp"
+#include <algorithm>
+#include <array>
 #include <map>
+#include <thread>
 #include <unistd.h>
 
-#ifdef TNQVM_EXATN_USES_MKL_BLAS
-#include <dlfcn.h>
-#endif
 
 namespace {
 const std::vector<std::complex<double>> Q_ZERO_TENSOR_BODY{{1.0, 0.0}, {0.0, 0.0}};
@@ -53,6 +54,8 @@ const std::string ROOT_TENSOR_NAME = "Root";
 // for small circuits, where the full state-vector can be stored in the memory,
 // it's faster to just run bit-string simulation on the state vector.
 const int MAX_NUMBER_QUBITS_FOR_STATE_VEC = 20;
+// Default number of gate tensors to keep alive in the ExaTN runtime.
+const int DEFAULT_GATE_TENSOR_CACHE_SIZE = 64;
 
 void printTensorData(const std::string& in_tensorName)
 {
@@ -99,38 +102,142 @@ std::vector<std::complex<double>> getTensorData(const std::string& in_tensorName
     return result;
 }
 
-std::unordered_map<std::string, tnqvm::Stat::FunctionCallStat>& getStatRegistry()
+// Per-stage timings are recorded in the process-wide metrics registry.
+template<typename TimePoint>
+void addStatSample(const std::string& in_name, TimePoint in_begin, TimePoint in_end)
 {
-    static std::unordered_map<std::string, tnqvm::Stat::FunctionCallStat> statMap;
-    return statMap;
+    tnqvm::MetricsRegistry::get_instance().addTiming("exatn-mps::" + in_name, in_begin, in_end);
 }
 
-tnqvm::Stat::FunctionCallStat& getStatInstance(const std::string& in_name)
+// Gate tensors are shared across visitor instances and runs (initialize/finalize).
+tnqvm::GateTensorCache& getGateTensorCache()
 {
-    auto& statMap = getStatRegistry();
-    auto iter = statMap.find(in_name);
-    if (iter != statMap.end())
-    {
-        return iter->second;
-    }
-    // Create new stat
-    tnqvm::Stat::FunctionCallStat newStat(in_name);
-    auto result = statMap.emplace(in_name, newStat);
-    return result.first->second;
+    static tnqvm::GateTensorCache gateTensorCache(DEFAULT_GATE_TENSOR_CACHE_SIZE);
+    return gateTensorCache;
+}
+
+size_t getNumberOfThreads()
+{
+    static const size_t NB_THREADS = std::thread::hardware_concurrency();
+    return NB_THREADS;
 }
 
-void printAllStats()
+// Contracts a site tensor and its conjugate into the environment on its right:
+// out(l, l') = sum_{p, r, r'} A(l, p, r) * env(r, r') * conj(A(l', p, r'))
+// Environments are row-major square matrices, normalized to unit trace
+// since only relative probabilities are needed for sampling.
+std::vector<std::complex<double>> contractRightEnvironment(const MpsSiteTensor& in_site, const std::vector<std::complex<double>>& in_env)
 {
-    for (auto& stat: getStatRegistry())
+    const size_t leftDim = in_site.leftDim;
+    const size_t rightDim = in_site.rightDim;
+    assert(in_env.size() == rightDim * rightDim);
+    // temp(l, p, r') = sum_r A(l, p, r) * env(r, r'), stored as [(l + leftDim * p) * rightDim + r']
+    std::vector<std::complex<double>> temp(2 * leftDim * rightDim, 0.0);
+    for (size_t r = 0; r < rightDim; ++r)
+    {
+        for (size_t lp = 0; lp < 2 * leftDim; ++lp)
+        {
+            const std::complex<double> a = in_site.data[lp + 2 * leftDim * r];
+            if (a == 0.0)
+            {
+                continue;
+            }
+            for (size_t rr = 0; rr < rightDim; ++rr)
+            {
+                temp[lp * rightDim + rr] += a * in_env[r * rightDim + rr];
+            }
+        }
+    }
+
+    std::vector<std::complex<double>> result(leftDim * leftDim, 0.0);
+    for (size_t l = 0; l < leftDim; ++l)
+    {
+        for (size_t ll = 0; ll < leftDim; ++ll)
+        {
+            std::complex<double> sum = 0.0;
+            for (size_t p = 0; p < 2; ++p)
+            {
+                const std::complex<double>* tempRow = temp.data() + (l + leftDim * p) * rightDim;
+                for (size_t rr = 0; rr < rightDim; ++rr)
+                {
+                    sum += tempRow[rr] * std::conj(in_site.data[ll + leftDim * (p + 2 * rr)]);
+                }
+            }
+            result[l * leftDim + ll] = sum;
+        }
+    }
+
+    double trace = 0.0;
+    for (size_t l = 0; l < leftDim; ++l)
     {
-        std::cout << stat.second.toString(true) << "\n";
+        trace += result[l * leftDim + l].real();
+    }
+    if (trace > 0.0)
+    {
+        for (auto& val : result)
+        {
+            val /= trace;
+        }
     }
+    return result;
 }
 
-size_t getNumberOfThreads()
+// Contracts a site tensor and its conjugate into the environment on its left,
+// with a single-qubit operator (row-major, op[p'][p] = <p'|O|p>) in between:
+// out(r, r') = sum_{l, l', p, p'} env(l, l') * A(l, p, r) * op[p'][p] * conj(A(l', p', r'))
+// Environments are row-major square matrices (not normalized).
+std::vector<std::complex<double>> contractLeftEnvironment(const MpsSiteTensor& in_site, const std::vector<std::complex<double>>& in_env, const std::array<std::complex<double>, 4>& in_op)
 {
-    static const size_t NB_THREADS = std::thread::hardware_concurrency();
-    return NB_THREADS;
+    const size_t leftDim = in_site.leftDim;
+    const size_t rightDim = in_site.rightDim;
+    assert(in_env.size() == leftDim * leftDim);
+    // temp(l', p', r) = sum_{l, p} env(l, l') * op[p'][p] * A(l, p, r), stored as [(l' + leftDim * p') * rightDim + r]
+    std::vector<std::complex<double>> temp(2 * leftDim * rightDim, 0.0);
+    for (size_t r = 0; r < rightDim; ++r)
+    {
+        for (size_t p = 0; p < 2; ++p)
+        {
+            for (size_t l = 0; l < leftDim; ++l)
+            {
+                const std::complex<double> a = in_site.data[l + leftDim * (p + 2 * r)];
+                if (a == 0.0)
+                {
+                    continue;
+                }
+                for (size_t pp = 0; pp < 2; ++pp)
+                {
+                    const std::complex<double> opA = in_op[2 * pp + p] * a;
+                    if (opA == 0.0)
+                    {
+                        continue;
+                    }
+                    for (size_t ll = 0; ll < leftDim; ++ll)
+                    {
+                        temp[(ll + leftDim * pp) * rightDim + r] += in_env[l * leftDim + ll] * opA;
+                    }
+                }
+            }
+        }
+    }
+
+    std::vector<std::complex<double>> result(rightDim * rightDim, 0.0);
+    for (size_t rr = 0; rr < rightDim; ++rr)
+    {
+        for (size_t llpp = 0; llpp < 2 * leftDim; ++llpp)
+        {
+            const std::complex<double> conjA = std::conj(in_site.data[llpp + 2 * leftDim * rr]);
+            if (conjA == 0.0)
+            {
+                continue;
+            }
+            const std::complex<double>* tempRow = temp.data() + llpp * rightDim;
+            for (size_t r = 0; r < rightDim; ++r)
+            {
+                result[r * rightDim + rr] += tempRow[r] * conjA;
+            }
+        }
+    }
+    return result;
 }
 
 inline bool indexInRange(size_t in_idx, const std::pair<size_t, size_t>& in_range)
@@ -173,6 +280,7 @@ ExatnMpsVisitor::ExatnMpsVisitor():
 void ExatnMpsVisitor::initialize(std::shared_ptr<AcceleratorBuffer> buffer, int nbShots)
 {
     const auto initializeStart = std::chrono::system_clock::now();
+    m_hostSites.clear();
 
     // Check if we have any specific config for the gate aggregator
     if (m_aggregateEnabled && options.keyExists<int>("agg-width"))
@@ -183,76 +291,16 @@ void ExatnMpsVisitor::initialize(std::shared_ptr<AcceleratorBuffer> buffer, int
         m_aggregator = newAggr;
     }
 
-    // Initialize ExaTN
-    if (!exatn::isInitialized()) {
-#ifdef TNQVM_EXATN_USES_MKL_BLAS
-        // Fix for TNQVM bug #30
-        void *core_handle =
-            dlopen("@EXATN_MKL_PATH@/libmkl_core@CMAKE_SHARED_LIBRARY_SUFFIX@",
-                    RTLD_LAZY | RTLD_GLOBAL);
-        if (core_handle == nullptr) {
-            std::string err = std::string(dlerror());
-            xacc::error("Could not load mkl_core - " + err);
-        }
-
-        void *thread_handle = dlopen(
-            "@EXATN_MKL_PATH@/libmkl_gnu_thread@CMAKE_SHARED_LIBRARY_SUFFIX@",
-            RTLD_LAZY | RTLD_GLOBAL);
-        if (thread_handle == nullptr) {
-            std::string err = std::string(dlerror());
-            xacc::error("Could not load mkl_gnu_thread - " + err);
-        }
-#endif
-
-// This is a flag from ExaTN indicating that ExaTN was compiled
-// w/ MPI enabled.
-    #ifdef MPI_ENABLED
-    {
-      exatn::ParamConf exatnParams;
-      if (options.keyExists<int>("exatn-buffer-size-gb")) {
-        int bufferSizeGb = options.get<int>("exatn-buffer-size-gb");
-        if (bufferSizeGb < 1) {
-          std::cout << "Minimum buffer size is 1 GB.\n";
-          bufferSizeGb = 1;
-        }
-        // Set the memory buffer size:
-        const int64_t memorySizeBytes = bufferSizeGb * (1ULL << 30);
-        const bool success = exatnParams.setParameter("host_memory_buffer_size",
-                                                      memorySizeBytes);
-      } else {
-        // Use default buffer size
-        const int64_t memorySizeBytes = 8 * (1ULL << 30);
-
-        const bool success = exatnParams.setParameter("host_memory_buffer_size",
-                                                      memorySizeBytes);
-        assert(success);
-      }
-      if (options.keyExists<void *>("mpi-communicator")) {
-        xacc::info("Setting ExaTN MPI_COMMUNICATOR...");
-        auto communicator = options.get<void *>("mpi-communicator");
-        exatn::MPICommProxy commProxy(communicator);
-        exatn::initialize(commProxy, exatnParams);
-      } else {
-        // No specific communicator is specified,
-        // exaTN will automatically use MPI_COMM_WORLD.
-        exatn::initialize(exatnParams);
-      }
-    }
-#else
+    // Initialize (or reconfigure) the ExaTN runtime shared by all visitors.
+    if (ExatnRuntime::get().initialize(options))
     {
-        exatn::initialize();
-        exatn::activateContrSeqCaching();
+        // Fresh ExaTN runtime: any cached gate tensors are gone.
+        getGateTensorCache().clear();
     }
-    #endif
-        // ExaTN and XACC logging levels are always in-synced.
-        exatn::resetClientLoggingLevel(xacc::verbose ? xacc::getLoggingLevel() : 0);
-        exatn::resetRuntimeLoggingLevel(xacc::verbose ? xacc::getLoggingLevel() : 0);
 
-        xacc::subscribeLoggingLevel([](int level) {
-            exatn::resetClientLoggingLevel(xacc::verbose ? level : 0);
-            exatn::resetRuntimeLoggingLevel(xacc::verbose ? level : 0);
-        });
-    }
+    getGateTensorCache().setCapacity(options.keyExists<int>("gate-tensor-cache-size") ?
+                                     options.get<int>("gate-tensor-cache-size") :
+                                     DEFAULT_GATE_TENSOR_CACHE_SIZE);
 
     // Default SVD cut-off is the numerical limit, i.e. technically, no cut-off.
     m_svdCutoff = std::numeric_limits<double>::min();
@@ -342,7 +390,7 @@ void ExatnMpsVisitor::initialize(std::shared_ptr<AcceleratorBuffer> buffer, int
     }
 
     const auto initializeEnd = std::chrono::system_clock::now();
-    getStatInstance("Initialize").addSample(initializeStart, initializeEnd);
+    addStatSample("Initialize", initializeStart, initializeEnd);
 #else
     // MPI
     auto& process_group = exatn::getDefaultProcessGroup();
@@ -543,9 +591,11 @@ void ExatnMpsVisitor::printStateVec()
 #ifndef TNQVM_MPI_ENABLED
     const bool evaledOk = exatn::evaluateSync(ket);
     assert(evaledOk);
+    tnqvm::recordNetworkMetrics(ket);
 #else
     const bool evaledOk = exatn::evaluateSync(*m_selfProcessGroup, ket);
     assert(evaledOk);
+    tnqvm::recordNetworkMetrics(ket);
 #endif
 
     auto talsh_tensor = exatn::getLocalTensor(ket.getTensor(0)->getName());
@@ -575,6 +625,7 @@ void ExatnMpsVisitor::printStateVec()
 
 void ExatnMpsVisitor::finalize()
 {
+    m_hostSites.clear();
 #ifndef TNQVM_MPI_ENABLED
     const auto finalizeStart = std::chrono::system_clock::now();
 
@@ -594,6 +645,7 @@ void ExatnMpsVisitor::finalize()
         ket.rename("MPSket");
         const bool evaledOk = exatn::evaluateSync(ket);
         assert(evaledOk);
+        tnqvm::recordNetworkMetrics(ket);
         const auto tensorData = getTensorData(ket.getTensor(0)->getName());
         // Simulate measurement by full tensor contraction (to get the state vector)
         // we can also implement repetitive bit count sampling
@@ -613,33 +665,10 @@ void ExatnMpsVisitor::finalize()
 
         if (!m_measureQubits.empty())
         {
-            const auto calcExpValueZ = [](const std::vector<size_t>& in_bits, const std::vector<std::complex<double>>& in_stateVec) {
-                const auto hasEvenParity = [](size_t x, const std::vector<size_t>& in_qubitIndices) -> bool {
-                    size_t count = 0;
-                    for (const auto& bitIdx : in_qubitIndices)
-                    {
-                        if (x & (1ULL << bitIdx))
-                        {
-                            count++;
-                        }
-                    }
-                    return (count % 2) == 0;
-                };
-
-
-                double result = 0.0;
-                for(uint64_t i = 0; i < in_stateVec.size(); ++i)
-                {
-                    result += (hasEvenParity(i, in_bits) ? 1.0 : -1.0) * std::norm(in_stateVec[i]);
-                }
-
-                return result;
-            };
-
             // No shots, just add exp-val-z
             if (m_shotCount < 1)
             {
-                const double exp_val_z = calcExpValueZ(m_measureQubits, tensorData);
+                const double exp_val_z = CalcExpValueZ(tensorData, m_measureQubits);
                 m_buffer->addExtraInfo("exp-val-z", exp_val_z);
             }
             else
@@ -653,18 +682,9 @@ void ExatnMpsVisitor::finalize()
         if (!m_measureQubits.empty())
         {
             xacc::info("Simulating bit string by MPS tensor contraction");
-            for (int i = 0; i < m_shotCount; ++i)
+            for (const auto& bitString : getMeasureSamples(m_measureQubits, m_shotCount))
             {
-                const auto convertToBitString = [](const std::vector<uint8_t>& in_bitVec){
-                    std::string result;
-                    for (const auto& bit : in_bitVec)
-                    {
-                        result.append(std::to_string(bit));
-                    }
-                    return result;
-                };
-
-                m_buffer->appendMeasurement(convertToBitString(getMeasureSample(m_measureQubits)));
+                m_buffer->appendMeasurement(bitString);
             }
         }
     }
@@ -677,10 +697,7 @@ void ExatnMpsVisitor::finalize()
     }
 
     const auto finalizeEnd = std::chrono::system_clock::now();
-    getStatInstance("Finalize").addSample(finalizeStart, finalizeEnd);
-
-    // Debug:
-    // printAllStats();
+    addStatSample("Finalize", finalizeStart, finalizeEnd);
 #else
     for (const auto& [qubitIdx, rank] : m_qubitIdxToRank)
     {
@@ -712,6 +729,7 @@ void ExatnMpsVisitor::finalize()
             ket.rename("MPSket");
             const bool evaledOk = exatn::evaluateSync(*m_selfProcessGroup, ket);
             assert(evaledOk);
+            tnqvm::recordNetworkMetrics(ket);
             const auto tensorData = getTensorData(ket.getTensor(0)->getName());
             // Simulate measurement by full tensor contraction (to get the state vector)
             // we can also implement repetitive bit count sampling
@@ -731,33 +749,10 @@ void ExatnMpsVisitor::finalize()
 
             if (!m_measureQubits.empty())
             {
-                const auto calcExpValueZ = [](const std::vector<size_t>& in_bits, const std::vector<std::complex<double>>& in_stateVec) {
-                    const auto hasEvenParity = [](size_t x, const std::vector<size_t>& in_qubitIndices) -> bool {
-                        size_t count = 0;
-                        for (const auto& bitIdx : in_qubitIndices)
-                        {
-                            if (x & (1ULL << bitIdx))
-                            {
-                                count++;
-                            }
-                        }
-                        return (count % 2) == 0;
-                    };
-
-
-                    double result = 0.0;
-                    for(uint64_t i = 0; i < in_stateVec.size(); ++i)
-                    {
-                        result += (hasEvenParity(i, in_bits) ? 1.0 : -1.0) * std::norm(in_stateVec[i]);
-                    }
-
-                    return result;
-                };
-
                 // No shots, just add exp-val-z
                 if (m_shotCount < 1)
                 {
-                    const double exp_val_z = calcExpValueZ(m_measureQubits, tensorData);
+                    const double exp_val_z = CalcExpValueZ(tensorData, m_measureQubits);
                     m_buffer->addExtraInfo("exp-val-z", exp_val_z);
                 }
                 else
@@ -824,18 +819,10 @@ void ExatnMpsVisitor::finalize()
             {
                 xacc::info("Simulating bit string by MPS tensor contraction");
                 m_shotCount = (m_shotCount < 1) ? 1 : m_shotCount;
-                for (int i = 0; i < m_shotCount; ++i)
+                // All MPS tensors have been replicated to this process.
+                for (const auto& bitString : getMeasureSamples(m_measureQubits, m_shotCount))
                 {
-                    const auto convertToBitString = [](const std::vector<uint8_t>& in_bitVec){
-                        std::string result;
-                        for (const auto& bit : in_bitVec)
-                        {
-                            result.append(std::to_string(bit));
-                        }
-                        return result;
-                    };
-
-                    m_buffer->appendMeasurement(convertToBitString(getMeasureSample(m_measureQubits, m_selfProcessGroup.get())));
+                    m_buffer->appendMeasurement(bitString);
                 }
                 xacc::info("Finished simulating bit string by MPS tensor contraction");
             }
@@ -1101,6 +1088,7 @@ const double ExatnMpsVisitor::getExpectationValueZ(std::shared_ptr<CompositeInst
     ket.rename("MPSket");
     const bool evaledOk = exatn::evaluateSync(ket);
     assert(evaledOk);
+    tnqvm::recordNetworkMetrics(ket);
     const auto tensorData = getTensorData(ket.getTensor(0)->getName());
 
     if (!m_measureQubits.empty())
@@ -1185,22 +1173,24 @@ void ExatnMpsVisitor::onFlush(const AggregatedGroup& in_group)
 void ExatnMpsVisitor::applyGate(xacc::Instruction& in_gateInstruction)
 {
     const auto gateStart = std::chrono::system_clock::now();
+    const auto& gateBits = in_gateInstruction.bits();
+    invalidateHostSites(*std::min_element(gateBits.begin(), gateBits.end()), *std::max_element(gateBits.begin(), gateBits.end()));
     if (in_gateInstruction.bits().size() == 2)
     {
+#ifndef TNQVM_MPI_ENABLED
+        if (std::abs((int)in_gateInstruction.bits()[0] - (int)in_gateInstruction.bits()[1]) > 1)
+        {
+            return applyLongRangeGate(in_gateInstruction);
+        }
+#endif
         return applyTwoQubitGate(in_gateInstruction);
     }
 
 #ifndef TNQVM_MPI_ENABLED
     // Single qubit only in this path
     assert(in_gateInstruction.bits().size() == 1);
-    const auto gateTensor = GateTensorConstructor::getGateTensor(in_gateInstruction);
-    const std::string& uniqueGateTensorName = in_gateInstruction.name();
-    // Create the tensor
-    const bool created = exatn::createTensorSync(uniqueGateTensorName, exatn::TensorElementType::COMPLEX64, gateTensor.tensorShape);
-    assert(created);
-    // Init tensor body data
-    const bool initialized = exatn::initTensorDataSync(uniqueGateTensorName, gateTensor.tensorData);
-    assert(initialized);
+    // Get the (cached) gate tensor
+    const std::string uniqueGateTensorName = getGateTensorCache().getGateTensor(in_gateInstruction);
     // m_tensorNetwork->printIt();
     // Contract gate tensor to the qubit tensor
     const auto contractGateTensor = [](int in_qIdx, const std::string& in_gateTensorName){
@@ -1253,7 +1243,7 @@ void ExatnMpsVisitor::applyGate(xacc::Instruction& in_gateInstruction)
         const bool contractOk = exatn::contractTensorsSync(patternStr, 1.0);
         assert(contractOk);
         auto end = std::chrono::system_clock::now();
-        getStatInstance("Contract Single-Qubit Gate Tensor").addSample(start, end);
+        addStatSample("Contract Single-Qubit Gate Tensor", start, end);
 
         std::vector<std::complex<double>> resultTensorData =  getTensorData(RESULT_TENSOR_NAME);
         std::function<int(talsh::Tensor& in_tensor)> updateFunc = [&resultTensorData](talsh::Tensor& in_tensor){
@@ -1283,13 +1273,10 @@ void ExatnMpsVisitor::applyGate(xacc::Instruction& in_gateInstruction)
 
     // DEBUG:
     // printStateVec();
-
-    const bool destroyed = exatn::destroyTensor(uniqueGateTensorName);
-    assert(destroyed);
     exatn::sync();
 
     const auto gateEnd = std::chrono::system_clock::now();
-    getStatInstance("One-qubit Gate Total").addSample(gateStart, gateEnd);
+    addStatSample("One-qubit Gate Total", gateStart, gateEnd);
 #else
     // MPI path:
     const size_t bitIdx = in_gateInstruction.bits()[0];
@@ -1439,16 +1426,8 @@ void ExatnMpsVisitor::applyTwoQubitGate(xacc::Instruction& in_gateInstruction)
     const bool mergedContractionOk = exatn::contractTensorsSync(mergeContractionPattern, 1.0);
     assert(mergedContractionOk);
 
-    // Step 2: contract the merged tensor with the gate
-    const auto gateTensor = GateTensorConstructor::getGateTensor(in_gateInstruction);
-    const std::string uniqueGateTensorName = in_gateInstruction.name();
-
-    // Create the tensor
-    const bool created = exatn::createTensorSync(uniqueGateTensorName, exatn::TensorElementType::COMPLEX64, gateTensor.tensorShape);
-    assert(created);
-    // Init tensor body data
-    const bool initialized = exatn::initTensorDataSync(uniqueGateTensorName, gateTensor.tensorData);
-    assert(initialized);
+    // Step 2: contract the merged tensor with the (cached) gate tensor
+    const std::string uniqueGateTensorName = getGateTensorCache().getGateTensor(in_gateInstruction);
 
     assert(mergedTensor->getRank() >=2 && mergedTensor->getRank() <= 4);
     const std::string RESULT_TENSOR_NAME = "Result";
@@ -1520,7 +1499,7 @@ void ExatnMpsVisitor::applyTwoQubitGate(xacc::Instruction& in_gateInstruction)
         const bool gateContractionOk = exatn::contractTensorsSync(patternStr, 1.0);
         assert(gateContractionOk);
         auto end = std::chrono::system_clock::now();
-        getStatInstance("Contract Two-Qubit Gate Tensor").addSample(start, end);
+        addStatSample("Contract Two-Qubit Gate Tensor", start, end);
     }
 
     const std::vector<std::complex<double>> resultTensorData =  getTensorData(RESULT_TENSOR_NAME);
@@ -1544,13 +1523,8 @@ void ExatnMpsVisitor::applyTwoQubitGate(xacc::Instruction& in_gateInstruction)
     const bool resultTensorDestroyed = exatn::destroyTensor(RESULT_TENSOR_NAME);
     assert(resultTensorDestroyed);
 
-    // Destroy gate tensor
-    const bool destroyed = exatn::destroyTensor(uniqueGateTensorName);
-    assert(destroyed);
-
-
     const auto beforeSvd = std::chrono::system_clock::now();
-    getStatInstance("Two-qubit Gate: Before SVD").addSample(gateStart, beforeSvd);
+    addStatSample("Two-qubit Gate: Before SVD", gateStart, beforeSvd);
 
     // Step 3: SVD the merged tensor back into two MPS qubit tensor
     // Delete the two original qubit tensors
@@ -1623,7 +1597,7 @@ void ExatnMpsVisitor::applyTwoQubitGate(xacc::Instruction& in_gateInstruction)
         const bool svdOk = exatn::decomposeTensorSVDLRSync(mergeContractionPattern);
         assert(svdOk);
         auto end = std::chrono::system_clock::now();
-        getStatInstance("Decompose Tensor SVD").addSample(start, end);
+        addStatSample("Decompose Tensor SVD", start, end);
     }
 
     exatn::sync(q1TensorName);
@@ -1708,14 +1682,14 @@ void ExatnMpsVisitor::applyTwoQubitGate(xacc::Instruction& in_gateInstruction)
     m_tensorNetwork = std::make_shared<exatn::TensorNetwork>(m_tensorNetwork->getName(), mpsString, buildTensorMap());
 
     const auto afterSvd = std::chrono::system_clock::now();
-    getStatInstance("Two-qubit Gate: After SVD").addSample(gateStart, afterSvd);
+    addStatSample("Two-qubit Gate: After SVD", gateStart, afterSvd);
 
     {
         auto start = std::chrono::system_clock::now();
         // Truncate SVD tensors:
         truncateSvdTensors(q1TensorName, q2TensorName, m_svdCutoff);
         auto end = std::chrono::system_clock::now();
-        getStatInstance("Truncate SVD Tensor").addSample(start, end);
+        addStatSample("Truncate SVD Tensor", start, end);
     }
 
     // Rebuild the tensor network since the qubit tensors have been changed after SVD truncation
@@ -1726,7 +1700,7 @@ void ExatnMpsVisitor::applyTwoQubitGate(xacc::Instruction& in_gateInstruction)
     assert(mergedTensorDestroyed);
 
     const auto gateEnd = std::chrono::system_clock::now();
-    getStatInstance("Two-qubit Gate Total").addSample(gateStart, gateEnd);
+    addStatSample("Two-qubit Gate Total", gateStart, gateEnd);
     exatn::sync();
 #else
     // MPI
@@ -2171,11 +2145,387 @@ void ExatnMpsVisitor::applyTwoQubitGate(xacc::Instruction& in_gateInstruction)
 #endif
 }
 
+void ExatnMpsVisitor::applyLongRangeGate(xacc::Instruction& in_gateInstruction)
+{
+    assert(std::abs((int)in_gateInstruction.bits()[0] - (int)in_gateInstruction.bits()[1]) > 1);
+    // Row-major gate matrix G(out, in) with bits()[0] being the most significant bit.
+    const auto gateTensor = GateTensorConstructor::getGateTensor(in_gateInstruction);
+    applyTwoQubitOperator(in_gateInstruction.bits()[0], in_gateInstruction.bits()[1], gateTensor.tensorData);
+}
+
+void ExatnMpsVisitor::applyTwoQubitOperator(size_t in_q1, size_t in_q2, const std::vector<std::complex<double>>& in_matrix)
+{
+    exatn::sync();
+    const auto gateStart = std::chrono::system_clock::now();
+
+    const size_t nbQubits = m_buffer->size();
+    const size_t q1 = in_q1;
+    const size_t q2 = in_q2;
+    const size_t loIdx = std::min(q1, q2);
+    const size_t hiIdx = std::max(q1, q2);
+    assert(hiIdx > loIdx && hiIdx < nbQubits);
+
+    assert(in_matrix.size() == 16);
+    const auto gateElement = [&](int in_outLo, int in_outHi, int in_inLo, int in_inHi) {
+        const int outIdx = (q1 == loIdx) ? (2 * in_outLo + in_outHi) : (2 * in_outHi + in_outLo);
+        const int inIdx = (q1 == loIdx) ? (2 * in_inLo + in_inHi) : (2 * in_inHi + in_inLo);
+        return in_matrix[4 * outIdx + inIdx];
+    };
+
+    // MPO decomposition: G = Sum_{a, b} |a><b| (basis qubit) x O_ab (other qubit),
+    // where, e.g. with the basis on the lo qubit, O_ab(o, i) = G(a, o; b, i).
+    // Vanishing terms are dropped. Pick the side needing fewer terms,
+    // e.g. the control qubit for controlled gates (K = 2).
+    struct MpoTerm
+    {
+        int outBasis;
+        int inBasis;
+        std::complex<double> op[2][2];
+    };
+    const auto decomposeGate = [&](bool in_basisOnLo) {
+        std::vector<MpoTerm> terms;
+        for (int a = 0; a < 2; ++a)
+        {
+            for (int b = 0; b < 2; ++b)
+            {
+                MpoTerm term;
+                term.outBasis = a;
+                term.inBasis = b;
+                double termNorm = 0.0;
+                for (int o = 0; o < 2; ++o)
+                {
+                    for (int i = 0; i < 2; ++i)
+                    {
+                        term.op[o][i] = in_basisOnLo ? gateElement(a, o, b, i) : gateElement(o, a, i, b);
+                        termNorm += std::norm(term.op[o][i]);
+                    }
+                }
+                if (termNorm > 1e-24)
+                {
+                    terms.emplace_back(term);
+                }
+            }
+        }
+        return terms;
+    };
+    const auto loBasisTerms = decomposeGate(true);
+    const auto hiBasisTerms = decomposeGate(false);
+    const bool basisOnLo = loBasisTerms.size() <= hiBasisTerms.size();
+    const auto& mpoTerms = basisOnLo ? loBasisTerms : hiBasisTerms;
+    const size_t basisIdx = basisOnLo ? loIdx : hiIdx;
+    const size_t mpoBondDim = mpoTerms.size();
+    assert(mpoBondDim > 0);
+
+    // Contract the MPO into the qubit tensors in [loIdx, hiIdx] (host side).
+    // The MPO bond index is the slowest-varying part of the combined bonds, i.e. (r, k) -> r + rightDim * k.
+    for (size_t siteIdx = loIdx; siteIdx <= hiIdx; ++siteIdx)
+    {
+        const std::string tensorName = "Q" + std::to_string(siteIdx);
+        const auto oldShape = exatn::getTensor(tensorName)->getDimExtents();
+        const MpsSiteTensor& site = getHostSite(siteIdx);
+
+        const size_t newLeftDim = (siteIdx == loIdx) ? site.leftDim : site.leftDim * mpoBondDim;
+        const size_t newRightDim = (siteIdx == hiIdx) ? site.rightDim : site.rightDim * mpoBondDim;
+        std::vector<std::complex<double>> newData(2 * newLeftDim * newRightDim, 0.0);
+        const auto siteElement = [&site](size_t l, size_t p, size_t r) {
+            return site.data[l + site.leftDim * (p + 2 * r)];
+        };
+
+        for (size_t k = 0; k < mpoBondDim; ++k)
+        {
+            const auto& term = mpoTerms[k];
+            for (size_t r = 0; r < site.rightDim; ++r)
+            {
+                const size_t newRight = (siteIdx == hiIdx) ? r : r + site.rightDim * k;
+                for (size_t p = 0; p < 2; ++p)
+                {
+                    for (size_t l = 0; l < site.leftDim; ++l)
+                    {
+                        const size_t newLeft = (siteIdx == loIdx) ? l : l + site.leftDim * k;
+                        std::complex<double> value;
+                        if (siteIdx == basisIdx)
+                        {
+                            // |a><b| operator
+                            value = (p == term.outBasis) ? siteElement(l, term.inBasis, r) : 0.0;
+                        }
+                        else if (siteIdx == loIdx || siteIdx == hiIdx)
+                        {
+                            value = term.op[p][0] * siteElement(l, 0, r) + term.op[p][1] * siteElement(l, 1, r);
+                        }
+                        else
+                        {
+                            // Identity, the MPO bond is just passed through.
+                            value = siteElement(l, p, r);
+                        }
+                        newData[newLeft + newLeftDim * (p + 2 * newRight)] = value;
+                    }
+                }
+            }
+        }
+
+        auto newShape = oldShape;
+        if (siteIdx != 0)
+        {
+            newShape.front() = newLeftDim;
+        }
+        if (siteIdx != nbQubits - 1)
+        {
+            newShape.back() = newRightDim;
+        }
+
+        const bool destroyed = exatn::destroyTensorSync(tensorName);
+        assert(destroyed);
+        const bool created = exatn::createTensorSync(tensorName, exatn::TensorElementType::COMPLEX64, newShape);
+        assert(created);
+        const bool initialized = exatn::initTensorDataSync(tensorName, newData);
+        assert(initialized);
+    }
+
+    invalidateHostSites(loIdx, hiIdx);
+    rebuildTensorNetwork();
+    const auto mpoEnd = std::chrono::system_clock::now();
+    addStatSample("Long-range Gate: Apply MPO", gateStart, mpoEnd);
+
+    // Single sweep to bring the bonds back to (truncated) SVD form.
+    for (size_t siteIdx = loIdx; siteIdx < hiIdx; ++siteIdx)
+    {
+        svdTruncateBond(siteIdx);
+    }
+
+    const auto gateEnd = std::chrono::system_clock::now();
+    addStatSample("Long-range Gate Total", gateStart, gateEnd);
+    exatn::sync();
+}
+
+void ExatnMpsVisitor::applySingleQubitOperator(size_t in_qIdx, const std::vector<std::complex<double>>& in_matrix)
+{
+    assert(in_matrix.size() == 4);
+    const std::string tensorName = "Q" + std::to_string(in_qIdx);
+    const auto dims = exatn::getTensor(tensorName)->getDimExtents();
+    const size_t leftDim = (in_qIdx == 0) ? 1 : dims.front();
+    // In place: A'(l, p', r) = sum_p M[p'][p] * A(l, p, r)
+    std::function<int(talsh::Tensor& in_tensor)> updateFunc = [&in_matrix, leftDim](talsh::Tensor& in_tensor) {
+        std::complex<double>* elements;
+        if (in_tensor.getDataAccessHost(&elements))
+        {
+            const size_t volume = in_tensor.getVolume();
+            for (size_t offset = 0; offset < volume; offset += 2 * leftDim)
+            {
+                for (size_t l = 0; l < leftDim; ++l)
+                {
+                    const std::complex<double> a0 = elements[offset + l];
+                    const std::complex<double> a1 = elements[offset + leftDim + l];
+                    elements[offset + l] = in_matrix[0] * a0 + in_matrix[1] * a1;
+                    elements[offset + leftDim + l] = in_matrix[2] * a0 + in_matrix[3] * a1;
+                }
+            }
+        }
+        return 0;
+    };
+
+    exatn::numericalServer->transformTensorSync(tensorName, std::make_shared<ExatnMpsVisitor::ExaTnTensorFunctor>(updateFunc));
+    exatn::sync();
+    invalidateHostSites(in_qIdx, in_qIdx);
+}
+
+const MpsSiteTensor& ExatnMpsVisitor::getHostSite(size_t in_siteIdx)
+{
+    auto iter = m_hostSites.find(in_siteIdx);
+    if (iter == m_hostSites.end())
+    {
+        const size_t nbQubits = m_buffer->size();
+        const std::string tensorName = "Q" + std::to_string(in_siteIdx);
+        const auto dims = exatn::getTensor(tensorName)->getDimExtents();
+        MpsSiteTensor site;
+        site.leftDim = (in_siteIdx == 0) ? 1 : dims.front();
+        site.rightDim = (in_siteIdx == nbQubits - 1) ? 1 : dims.back();
+        site.data = getTensorData(tensorName);
+        assert(site.data.size() == 2 * site.leftDim * site.rightDim);
+        iter = m_hostSites.emplace(in_siteIdx, std::move(site)).first;
+    }
+    return iter->second;
+}
+
+void ExatnMpsVisitor::invalidateHostSites(size_t in_firstSite, size_t in_lastSite)
+{
+    for (size_t siteIdx = in_firstSite; siteIdx <= in_lastSite; ++siteIdx)
+    {
+        m_hostSites.erase(siteIdx);
+    }
+}
+
+std::vector<std::complex<double>> ExatnMpsVisitor::getReducedDensityMatrix(const std::vector<size_t>& in_qubitIdx)
+{
+    assert(!in_qubitIdx.empty() && std::is_sorted(in_qubitIdx.begin(), in_qubitIdx.end()));
+    const size_t nbQubits = m_buffer->size();
+
+    // Right environment of the last open qubit.
+    std::vector<std::complex<double>> rightEnv{1.0};
+    for (size_t siteIdx = nbQubits - 1; siteIdx > in_qubitIdx.back(); --siteIdx)
+    {
+        rightEnv = contractRightEnvironment(getHostSite(siteIdx), rightEnv);
+    }
+
+    // Left environments, one per (row, column) element of the RDM of the open qubits so far.
+    const std::array<std::complex<double>, 4> identityOp{1.0, 0.0, 0.0, 1.0};
+    std::vector<std::vector<std::complex<double>>> envs{{1.0}};
+    size_t nbOpen = 0;
+    for (size_t siteIdx = 0; siteIdx <= in_qubitIdx.back(); ++siteIdx)
+    {
+        const MpsSiteTensor& site = getHostSite(siteIdx);
+        if (std::find(in_qubitIdx.begin(), in_qubitIdx.end(), siteIdx) == in_qubitIdx.end())
+        {
+            for (auto& env : envs)
+            {
+                env = contractLeftEnvironment(site, env, identityOp);
+            }
+            continue;
+        }
+
+        // Open qubit: element (o, o') -> ((o, p), (o', p'))
+        const size_t dim = 1ULL << nbOpen;
+        std::vector<std::vector<std::complex<double>>> newEnvs(4 * dim * dim);
+        for (size_t row = 0; row < dim; ++row)
+        {
+            for (size_t col = 0; col < dim; ++col)
+            {
+                for (size_t p = 0; p < 2; ++p)
+                {
+                    for (size_t pp = 0; pp < 2; ++pp)
+                    {
+                        std::array<std::complex<double>, 4> op{0.0, 0.0, 0.0, 0.0};
+                        op[2 * pp + p] = 1.0;
+                        newEnvs[(2 * row + p) * 2 * dim + (2 * col + pp)] = contractLeftEnvironment(site, envs[row * dim + col], op);
+                    }
+                }
+            }
+        }
+        envs = std::move(newEnvs);
+        ++nbOpen;
+    }
+
+    std::vector<std::complex<double>> rdm(envs.size(), 0.0);
+    std::complex<double> trace = 0.0;
+    const size_t dim = 1ULL << nbOpen;
+    for (size_t i = 0; i < envs.size(); ++i)
+    {
+        assert(envs[i].size() == rightEnv.size());
+        for (size_t j = 0; j < rightEnv.size(); ++j)
+        {
+            rdm[i] += envs[i][j] * rightEnv[j];
+        }
+        if (i / dim == i % dim)
+        {
+            trace += rdm[i];
+        }
+    }
+    for (auto& val : rdm)
+    {
+        val /= trace.real();
+    }
+    return rdm;
+}
+
+double ExatnMpsVisitor::computeExpectationValueZ(const std::vector<size_t>& in_qubitIdx)
+{
+    const size_t nbQubits = m_buffer->size();
+    const std::array<std::complex<double>, 4> identityOp{1.0, 0.0, 0.0, 1.0};
+    const std::array<std::complex<double>, 4> zOp{1.0, 0.0, 0.0, -1.0};
+    // <psi|Z...Z|psi> and <psi|psi> in a single sweep.
+    std::vector<std::complex<double>> zEnv{1.0};
+    std::vector<std::complex<double>> normEnv{1.0};
+    for (size_t siteIdx = 0; siteIdx < nbQubits; ++siteIdx)
+    {
+        const MpsSiteTensor& site = getHostSite(siteIdx);
+        const bool isMeasured = std::find(in_qubitIdx.begin(), in_qubitIdx.end(), siteIdx) != in_qubitIdx.end();
+        zEnv = contractLeftEnvironment(site, zEnv, isMeasured ? zOp : identityOp);
+        normEnv = contractLeftEnvironment(site, normEnv, identityOp);
+    }
+    assert(zEnv.size() == 1 && normEnv.size() == 1);
+    return zEnv[0].real() / normEnv[0].real();
+}
+
+void ExatnMpsVisitor::svdTruncateBond(size_t in_leftIdx)
+{
+    const std::string lhsTensorName = "Q" + std::to_string(in_leftIdx);
+    const std::string rhsTensorName = "Q" + std::to_string(in_leftIdx + 1);
+    const auto getQubitTensorId = [&](const std::string& in_tensorName) {
+        const auto idsVec = m_tensorNetwork->getTensorIdsInNetwork(in_tensorName);
+        assert(idsVec.size() == 1);
+        return idsVec.front();
+    };
+
+    // Merge the two tensors (same as the two-qubit gate path, without the gate)
+    const auto mergedTensorId = m_tensorNetwork->getMaxTensorId() + 1;
+    std::string mergeContractionPattern;
+    m_tensorNetwork->mergeTensors(getQubitTensorId(lhsTensorName), getQubitTensorId(rhsTensorName), mergedTensorId, &mergeContractionPattern);
+    mergeContractionPattern.replace(mergeContractionPattern.find("L"), 1, lhsTensorName);
+    mergeContractionPattern.replace(mergeContractionPattern.find("R"), 1, rhsTensorName);
+    auto mergedTensor = m_tensorNetwork->getTensor(mergedTensorId);
+    mergedTensor->rename("D");
+    const bool mergedTensorCreated = exatn::createTensorSync(mergedTensor, exatn::TensorElementType::COMPLEX64);
+    assert(mergedTensorCreated);
+    const bool mergedTensorInitialized = exatn::initTensorSync(mergedTensor->getName(), 0.0);
+    assert(mergedTensorInitialized);
+    const bool mergedContractionOk = exatn::contractTensorsSync(mergeContractionPattern, 1.0);
+    assert(mergedContractionOk);
+
+    // The bond is the last leg of the left tensor and the first leg of the right one.
+    auto lhsShape = exatn::getTensor(lhsTensorName)->getDimExtents();
+    auto rhsShape = exatn::getTensor(rhsTensorName)->getDimExtents();
+    assert(lhsShape.back() == rhsShape.front());
+    int volLhs = 1;
+    for (size_t i = 0; i + 1 < lhsShape.size(); ++i)
+    {
+        volLhs *= lhsShape[i];
+    }
+    int volRhs = 1;
+    for (size_t i = 1; i < rhsShape.size(); ++i)
+    {
+        volRhs *= rhsShape[i];
+    }
+    const int newBondDim = std::min(volLhs, volRhs);
+    lhsShape.back() = newBondDim;
+    rhsShape.front() = newBondDim;
+
+    const bool lhsDestroyed = exatn::destroyTensorSync(lhsTensorName);
+    assert(lhsDestroyed);
+    const bool rhsDestroyed = exatn::destroyTensorSync(rhsTensorName);
+    assert(rhsDestroyed);
+    const bool lhsCreated = exatn::createTensorSync(lhsTensorName, exatn::TensorElementType::COMPLEX64, lhsShape);
+    assert(lhsCreated);
+    const bool rhsCreated = exatn::createTensorSync(rhsTensorName, exatn::TensorElementType::COMPLEX64, rhsShape);
+    assert(rhsCreated);
+
+    {
+        auto start = std::chrono::system_clock::now();
+        stabilizeTensorBody(mergedTensor->getName());
+        const bool svdOk = exatn::decomposeTensorSVDLRSync(mergeContractionPattern);
+        assert(svdOk);
+        auto end = std::chrono::system_clock::now();
+        addStatSample("Decompose Tensor SVD", start, end);
+    }
+
+    const bool mergedTensorDestroyed = exatn::destroyTensorSync(mergedTensor->getName());
+    assert(mergedTensorDestroyed);
+
+    rebuildTensorNetwork();
+    {
+        auto start = std::chrono::system_clock::now();
+        truncateSvdTensors(lhsTensorName, rhsTensorName, m_svdCutoff);
+        auto end = std::chrono::system_clock::now();
+        addStatSample("Truncate SVD Tensor", start, end);
+    }
+    rebuildTensorNetwork();
+    invalidateHostSites(in_leftIdx, in_leftIdx + 1);
+}
+
 void ExatnMpsVisitor::evaluateTensorNetwork(exatn::numerics::TensorNetwork& io_tensorNetwork, std::vector<std::complex<double>>& out_stateVec)
 {
     out_stateVec.clear();
     const bool evaluated = exatn::evaluateSync(io_tensorNetwork);
     assert(evaluated);
+    tnqvm::recordNetworkMetrics(io_tensorNetwork);
     // Synchronize:
     exatn::sync();
 
@@ -2297,6 +2647,7 @@ std::vector<uint8_t> ExatnMpsVisitor::getMeasureSample(const std::vector<size_t>
         // Evaluate
         const bool evaluated = in_processGroup ? exatn::evaluateSync(*in_processGroup, combinedNetwork) : exatn::evaluateSync(combinedNetwork);
         assert(evaluated);
+        tnqvm::recordNetworkMetrics(combinedNetwork);
         {
             exatn::sync();
             auto talsh_tensor = exatn::getLocalTensor(combinedNetwork.getTensor(0)->getName());
@@ -2363,6 +2714,142 @@ std::vector<uint8_t> ExatnMpsVisitor::getMeasureSample(const std::vector<size_t>
     return resultBitString;
 }
 
+std::vector<std::string> ExatnMpsVisitor::getMeasureSamples(const std::vector<size_t>& in_qubitIdx, int in_nbShots)
+{
+    std::vector<std::string> resultBitStrings;
+    if (in_qubitIdx.empty() || in_nbShots < 1)
+    {
+        return resultBitStrings;
+    }
+
+    const auto samplingStart = std::chrono::system_clock::now();
+    // Host copy of the MPS tensors
+    const size_t nbQubits = m_buffer->size();
+    std::vector<const MpsSiteTensor*> sites(nbQubits);
+    for (size_t i = 0; i < nbQubits; ++i)
+    {
+        sites[i] = &getHostSite(i);
+    }
+
+    // Qubits to the right of the last measured one are only needed in the environment,
+    // i.e. the sampling sweep stops at the last measured qubit.
+    const size_t lastSite = *std::max_element(in_qubitIdx.begin(), in_qubitIdx.end());
+    // rightEnvs[k] = MPS[k:] contracted with its conjugate (left bond of site k open).
+    std::vector<std::vector<std::complex<double>>> rightEnvs(nbQubits + 1);
+    rightEnvs[nbQubits] = { 1.0 };
+    for (size_t i = nbQubits - 1; i > 0; --i)
+    {
+        rightEnvs[i] = contractRightEnvironment(*sites[i], rightEnvs[i + 1]);
+    }
+
+    // Position of each measured qubit in the result bit string
+    std::vector<std::vector<size_t>> bitPositions(lastSite + 1);
+    for (size_t i = 0; i < in_qubitIdx.size(); ++i)
+    {
+        bitPositions[in_qubitIdx[i]].emplace_back(i);
+    }
+
+    // Sample a single shot given a random number for each site:
+    // carry the (normalized) left boundary vector of the collapsed MPS through the chain.
+    const auto sampleShot = [&](const double* in_randProbs) {
+        std::string bitString(in_qubitIdx.size(), '0');
+        std::vector<std::complex<double>> leftVec { 1.0 };
+        std::vector<std::complex<double>> projVecs[2];
+        for (size_t site = 0; site <= lastSite; ++site)
+        {
+            const auto& tensor = *sites[site];
+            const auto& env = rightEnvs[site + 1];
+            double probs[2];
+            for (int bit = 0; bit < 2; ++bit)
+            {
+                auto& projVec = projVecs[bit];
+                projVec.assign(tensor.rightDim, 0.0);
+                for (size_t r = 0; r < tensor.rightDim; ++r)
+                {
+                    const std::complex<double>* block = tensor.data.data() + tensor.leftDim * (bit + 2 * r);
+                    std::complex<double> sum = 0.0;
+                    for (size_t l = 0; l < tensor.leftDim; ++l)
+                    {
+                        sum += leftVec[l] * block[l];
+                    }
+                    projVec[r] = sum;
+                }
+                // prob(bit) ~ <projVec| env |projVec>
+                double prob = 0.0;
+                for (size_t r = 0; r < tensor.rightDim; ++r)
+                {
+                    std::complex<double> sum = 0.0;
+                    const std::complex<double>* envRow = env.data() + r * tensor.rightDim;
+                    for (size_t rr = 0; rr < tensor.rightDim; ++rr)
+                    {
+                        sum += envRow[rr] * std::conj(projVec[rr]);
+                    }
+                    prob += (projVec[r] * sum).real();
+                }
+                // Due to numerical stability, zero value may become an extremely-small negative number.
+                probs[bit] = std::max(prob, 0.0);
+            }
+
+            const double totalProb = probs[0] + probs[1];
+            const int pickedBit = (totalProb > 0.0 && in_randProbs[site] * totalProb >= probs[0]) ? 1 : 0;
+            for (const auto& pos : bitPositions[site])
+            {
+                bitString[pos] = pickedBit ? '1' : '0';
+            }
+
+            // Renormalize the collapsed boundary vector to keep it well-conditioned.
+            leftVec = std::move(projVecs[pickedBit]);
+            const double normFactor = std::sqrt(probs[pickedBit]);
+            if (normFactor > 0.0)
+            {
+                for (auto& val : leftVec)
+                {
+                    val /= normFactor;
+                }
+            }
+        }
+        return bitString;
+    };
+
+    const size_t nbShots = in_nbShots;
+    resultBitStrings.resize(nbShots);
+    const size_t nbSites = lastSite + 1;
+    // Draw all random numbers upfront (in shot order) so that the result is
+    // independent of the number of worker threads for a given seed.
+    // Process the shots in batches to bound the memory of the random number pool.
+    constexpr size_t SHOT_BATCH_SIZE = 1024;
+    const size_t nbThreads = std::max<size_t>(1, getNumberOfThreads());
+    for (size_t batchStart = 0; batchStart < nbShots; batchStart += SHOT_BATCH_SIZE)
+    {
+        const size_t batchSize = std::min(SHOT_BATCH_SIZE, nbShots - batchStart);
+        const auto randProbs = randomEngine::get_instance().randProbs(batchSize * nbSites);
+        const auto sampleRange = [&](size_t in_begin, size_t in_end) {
+            for (size_t i = in_begin; i < in_end; ++i)
+            {
+                resultBitStrings[batchStart + i] = sampleShot(randProbs.data() + i * nbSites);
+            }
+        };
+
+        const size_t nbWorkers = std::min(nbThreads, batchSize);
+        std::vector<std::thread> workers;
+        const size_t chunkSize = (batchSize + nbWorkers - 1) / nbWorkers;
+        for (size_t begin = chunkSize; begin < batchSize; begin += chunkSize)
+        {
+            workers.emplace_back(sampleRange, begin, std::min(begin + chunkSize, batchSize));
+        }
+        // Process the first chunk on this thread.
+        sampleRange(0, std::min(chunkSize, batchSize));
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    const auto samplingEnd = std::chrono::system_clock::now();
+    addStatSample("Batched MPS Sampling", samplingStart, samplingEnd);
+    return resultBitStrings;
+}
+
 void ExatnMpsVisitor::truncateSvdTensors(const std::string& in_leftTensorName, const std::string& in_rightTensorName, double in_eps, exatn::ProcessGroup *in_processGroup)
 {
     int lhsTensorId = -1;
@@ -2535,7 +3022,6 @@ void ExatnMpsVisitor::truncateSvdTensors(const std::string& in_leftTensorName, c
     }
 }
 
-#ifdef TNQVM_MPI_ENABLED
 void ExatnMpsVisitor::rebuildTensorNetwork()
 {
     const auto buildTensorMap = [&](){
@@ -2583,7 +3069,6 @@ void ExatnMpsVisitor::rebuildTensorNetwork()
     }();
     m_tensorNetwork = std::make_shared<exatn::TensorNetwork>(m_tensorNetwork->getName(), mpsString, buildTensorMap());
 }
-#endif
 
 std::vector<std::complex<double>> ExatnMpsVisitor::computeWaveFuncSlice(
     const exatn::TensorNetwork& in_tensorNetwork, const std::vector<int>& bitString,
@@ -2657,6 +3142,7 @@ std::vector<std::complex<double>> ExatnMpsVisitor::computeWaveFuncSlice(
     // combinedTensorNetwork.printIt();
     if (exatn::evaluateSync(in_processGroup, combinedTensorNetwork)) {
       exatn::sync();
+      tnqvm::recordNetworkMetrics(combinedTensorNetwork);
       auto talsh_tensor =
           exatn::getLocalTensor(combinedTensorNetwork.getTensor(0)->getName());
       const std::complex<double> *body_ptr;
@@ -2689,6 +3175,7 @@ double ExatnMpsVisitor::computeStateVectorNorm(const exatn::numerics::TensorNetw
     std::complex<double> norm;
     if (exatn::evaluateSync(in_processGroup, combinedTensorNetwork)) {
       exatn::sync();
+      tnqvm::recordNetworkMetrics(combinedTensorNetwork);
       auto talsh_tensor =
           exatn::getLocalTensor(combinedTensorNetwork.getTensor(0)->getName());
       assert(talsh_tensor->getVolume() ==  1);
@@ -41,6 +41,12 @@
  * | mpi-communicator            | The MPI communicator to initialize ExaTN runtime with.                 |    void*    | <unused>                 |
  * |                             | If not provided, by default, ExaTN will use `MPI_COMM_WORLD`.          |             |                          |
  * +-----------------------------+------------------------------------------------------------------------+-------------+--------------------------+
+ * | gate-tensor-cache-size      | Max number of gate tensors (e.g. H, Rx(theta)) kept alive in the ExaTN |    int      | 64                       |
+ * |                             | runtime and reused across gates and runs (least recently used evicted).|             |                          |
+ * +-----------------------------+------------------------------------------------------------------------+-------------+--------------------------+
+ * | long-range-gates            | Apply two-qubit gates on non-adjacent qubits directly (as an MPO)      |    bool     | true                     |
+ * |                             | rather than transforming the circuit to nearest-neighbor with SWAPs.   |             |                          |
+ * +-----------------------------+------------------------------------------------------------------------+-------------+--------------------------+
 */
 
 #pragma once
@@ -48,8 +54,19 @@
 #include "TNQVMVisitor.hpp"
 #include "GateTensorAggregator.hpp"
 #include "tensor_network.hpp"
+#include "ExatnRuntime.hpp"
 
 namespace tnqvm {
+// Host copy of an MPS tensor viewed as a (left bond, physical, right bond) block in column-major order,
+// i.e. element (l, p, r) is at l + leftDim * (p + 2 * r).
+// This covers all the tensor shapes in the chain: Q0 = [2, D], Qi = [D, 2, D], Qn-1 = [D, 2].
+struct MpsSiteTensor
+{
+    size_t leftDim;
+    size_t rightDim;
+    std::vector<std::complex<double>> data;
+};
+
 class ExatnMpsVisitor : public TNQVMVisitor, public IAggregatorListener
 {
 public:
@@ -59,6 +76,12 @@ public:
     // Virtual function impls:
     virtual void initialize(std::shared_ptr<AcceleratorBuffer> buffer, int nbShots) override;
     virtual void finalize() override;
+    virtual void prewarm(const HeterogeneousMap& in_options) override { ExatnRuntime::get().prewarm(in_options); }
+#ifndef TNQVM_MPI_ENABLED
+    // Non-adjacent two-qubit gates are applied as an MPO (see applyLongRangeGate).
+    // Note: the MPI path distributes the qubit tensors, hence is nearest-neighbor only.
+    virtual bool supportLongRangeGates() const override { return true; }
+#endif
 
     // Service name as defined in manifest.json
     virtual const std::string name() const override { return "exatn-mps"; }
@@ -106,18 +129,46 @@ public:
         std::function<int(talsh::Tensor& in_tensor)> m_func;
     };
     
-private:
+protected:
     // Evaluates the whole tensor network and returns state vector
     void evaluateTensorNetwork(exatn::numerics::TensorNetwork& io_tensorNetwork, std::vector<std::complex<double>>& out_stateVec);
     void addMeasureBitStringProbability(const std::vector<size_t>& in_bits, const std::vector<std::complex<double>>& in_stateVec, int in_shotCount);
-    void applyGate(xacc::Instruction& in_gateInstruction);
+    virtual void applyGate(xacc::Instruction& in_gateInstruction);
     void applyTwoQubitGate(xacc::Instruction& in_gateInstruction);
+    // Apply a two-qubit gate on non-adjacent qubits without SWAPs:
+    // the gate is written as a sum of K (<= 4) products of single-qubit operators, i.e. a bond dimension K MPO,
+    // which is contracted into the MPS tensors between (and including) the two qubits.
+    // The affected bonds (K times larger) are then re-compressed by a single SVD truncation sweep.
+    void applyLongRangeGate(xacc::Instruction& in_gateInstruction);
+    // Apply a two-qubit operator (row-major matrix, in_q1 being the most significant bit) on any pair of qubits,
+    // using the same MPO path as long-range gates. The operator needs not be unitary (e.g. Kraus operators).
+    void applyTwoQubitOperator(size_t in_q1, size_t in_q2, const std::vector<std::complex<double>>& in_matrix);
+    // Apply a single-qubit operator (row-major matrix, not necessarily unitary) in place.
+    void applySingleQubitOperator(size_t in_qIdx, const std::vector<std::complex<double>>& in_matrix);
+    // Reduced density matrix (row-major, unit trace) of a few qubits (ascending order, the first one being the most significant bit),
+    // computed host side from the left/right environments of the MPS.
+    std::vector<std::complex<double>> getReducedDensityMatrix(const std::vector<size_t>& in_qubitIdx);
+    // Host copy of an MPS tensor, cached until the tensor is modified (see invalidateHostSites),
+    // i.e. host-side computations (RDM, sampling, long-range gates) only copy the tensors changed since the last one.
+    const MpsSiteTensor& getHostSite(size_t in_siteIdx);
+    // Drops the host copies of the MPS tensors in [in_firstSite, in_lastSite].
+    void invalidateHostSites(size_t in_firstSite, size_t in_lastSite);
+    // Exact <Z...Z> on the given qubits, computed host side in a single sweep.
+    double computeExpectationValueZ(const std::vector<size_t>& in_qubitIdx);
+    // Re-decompose (SVD) the bond between qubit tensors in_leftIdx and in_leftIdx + 1 and truncate it.
+    void svdTruncateBond(size_t in_leftIdx);
     // Get a sample measurement bit string:
     // In this function, we get RDM by opening one qubit line at a time (same order as the provided list).
     // Then, we contract the whole tensor network to get the RDM for that qubit.
     // Randomly select a binary (1/0) result based on the RDM, then close that tensor leg by projecting it onto the selected result.
     // Continue with the next qubit line (conditioned on the previous measurement result).
     std::vector<uint8_t> getMeasureSample(const std::vector<size_t>& in_qubitIdx, exatn::ProcessGroup *in_processGroup = nullptr);
+    // Get multiple measurement bit strings in a single sweep:
+    // The right environments (MPS contracted with its conjugate from the right) are computed once
+    // and shared by all shots. Each shot then only carries a left boundary vector through the chain,
+    // i.e. the cost is ~ shots x qubits x bond-dim^2 rather than one full network contraction per qubit per shot.
+    // Note: requires all MPS tensors to be available locally.
+    std::vector<std::string> getMeasureSamples(const std::vector<size_t>& in_qubitIdx, int in_nbShots);
     void printStateVec();
     // Truncate the bond dimension between two tensors that are decomposed by SVD
     void truncateSvdTensors(const std::string &in_leftTensorName,
@@ -127,7 +178,7 @@ private:
     std::vector<std::complex<double>> computeWaveFuncSlice(const exatn::numerics::TensorNetwork& in_tensorNetwork, const std::vector<int>& bitString, const exatn::ProcessGroup& in_processGroup) const;
     double computeStateVectorNorm(const exatn::numerics::TensorNetwork& in_tensorNetwork, const exatn::ProcessGroup& in_processGroup) const;
 
-private:
+protected:
     TensorAggregator m_aggregator;
     std::shared_ptr<AcceleratorBuffer> m_buffer;
     std::vector<std::string> m_qubitTensorNames;
@@ -142,10 +193,12 @@ private:
     bool m_aggregateEnabled;
     double m_svdCutoff;
     int m_maxBondDim;
-#ifdef TNQVM_MPI_ENABLED
+    // Host copies of the MPS tensors (by qubit index), see getHostSite.
+    std::unordered_map<size_t, MpsSiteTensor> m_hostSites;
     // Rebuild the tensor network (m_tensorNetwork) from individual MPS tensors:
     // e.g. after bond dimension changes.
     void rebuildTensorNetwork();
+#ifdef TNQVM_MPI_ENABLED
     // Min-max qubit range (inclusive) that this process handles
     std::pair<size_t, size_t> m_qubitRange;
     // The self process group that the current process belongs to.
@@ -31,6 +31,39 @@
 
 #include "ExatnUtils.hpp"
 #include "base/Gates.hpp"
+#include "exatn.hpp"
+#include <algorithm>
+#include <cassert>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+namespace {
+// Name of a concrete quantum gate instance (same scheme as the ExaTN visitor's GateInstanceIdentifier),
+// i.e. parametric gates, e.g. Rx(theta), will have an instance for each value of theta.
+// Note: gate parameters are formatted at full precision, hence distinct angles never share an instance.
+std::string getGateInstanceName(xacc::Instruction& in_gate)
+{
+    if (in_gate.getParameters().empty())
+    {
+        return in_gate.name();
+    }
+
+    std::string result = in_gate.name() + "__";
+    for (const auto& param: in_gate.getParameters())
+    {
+        std::stringstream paramSs;
+        paramSs << std::setprecision(std::numeric_limits<double>::max_digits10) << param.as<double>();
+        std::string paramStr = paramSs.str();
+        // ExaTN doesn't allow special characters (only underscore is allowed).
+        std::replace(paramStr.begin(), paramStr.end(), '-', '_');
+        std::replace(paramStr.begin(), paramStr.end(), '.', '_');
+        paramStr.erase(std::remove(paramStr.begin(), paramStr.end(), '+'), paramStr.end());
+        result.append(paramStr + "__");
+    }
+    return result;
+}
+}
 
 namespace tnqvm {
 GateTensor GateTensorConstructor::getGateTensor(xacc::Instruction& in_gate)
@@ -131,4 +164,59 @@ GateTensor GateTensorConstructor::getGateTensor(xacc::Instruction& in_gate)
 
     return resultTensor;
 }
+
+GateTensorCache::GateTensorCache(size_t in_capacity):
+    m_capacity(std::max<size_t>(1, in_capacity))
+{}
+
+std::string GateTensorCache::getGateTensor(xacc::Instruction& in_gate)
+{
+    // Prefix to prevent name collision with tensors created by other visitors.
+    const std::string tensorName = "GATE_" + getGateInstanceName(in_gate);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto iter = m_entries.find(tensorName);
+    if (iter != m_entries.end())
+    {
+        // Hit: move to the front
+        m_lruList.splice(m_lruList.begin(), m_lruList, iter->second);
+        return tensorName;
+    }
+
+    // Make room for the new entry
+    evict(m_capacity - 1);
+    const auto gateTensor = GateTensorConstructor::getGateTensor(in_gate);
+    const bool created = exatn::createTensorSync(tensorName, exatn::TensorElementType::COMPLEX64, gateTensor.tensorShape);
+    assert(created);
+    const bool initialized = exatn::initTensorDataSync(tensorName, gateTensor.tensorData);
+    assert(initialized);
+    m_lruList.emplace_front(tensorName);
+    m_entries.emplace(tensorName, m_lruList.begin());
+    return tensorName;
+}
+
+void GateTensorCache::setCapacity(size_t in_capacity)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_capacity = std::max<size_t>(1, in_capacity);
+    evict(m_capacity);
+}
+
+void GateTensorCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_lruList.clear();
+    m_entries.clear();
+}
+
+void GateTensorCache::evict(size_t in_targetSize)
+{
+    while (m_lruList.size() > in_targetSize)
+    {
+        const std::string& tensorName = m_lruList.back();
+        const bool destroyed = exatn::destroyTensorSync(tensorName);
+        assert(destroyed);
+        m_entries.erase(tensorName);
+        m_lruList.pop_back();
+    }
+}
 }
@@ -34,6 +34,9 @@
 #include "xacc.hpp"
 #include "Identifiable.hpp"
 #include <chrono>
+#include <list>
+#include <mutex>
+#include <unordered_map>
 
 namespace tnqvm {
 struct GateTensor
@@ -53,75 +56,29 @@ public:
     static GateTensor getGateTensor(xacc::Instruction& in_gate);
 };
 
-// Stat utilities
-namespace Stat
+// Process-wide LRU cache of gate tensors which have been created (and initialized) in the ExaTN runtime.
+// Gate tensors are looked up by their gate instance (name and parameters), so repeated gates (e.g. H, CNOT)
+// don't need to be re-allocated and re-initialized every time they are applied.
+class GateTensorCache
 {
-struct FunctionCallStat
-{
-    std::string name;
-    std::chrono::duration<double>  totalDuration;
-    int numberCalls;
-    std::chrono::duration<double>  maxDuration;
-    std::chrono::duration<double>  minDuration;
-
-    FunctionCallStat(const std::string& in_name):
-        name(in_name),
-        totalDuration(std::chrono::duration<double>::zero()),
-        numberCalls(0),
-        maxDuration(std::chrono::duration<double>::zero()),
-        minDuration(std::chrono::duration<double>::zero())
-    {};
-
-    void addSample(std::chrono::system_clock::time_point in_begin, std::chrono::system_clock::time_point in_end)
-    {
-        const std::chrono::duration<double> callDuration = in_end - in_begin;
-        if (numberCalls == 0)
-        {
-            maxDuration = callDuration;
-            minDuration = callDuration;
-        }
-
-        numberCalls++;
-        totalDuration += callDuration;
-        if (callDuration > maxDuration)
-        {
-            maxDuration = callDuration;
-        }
-
-        if (callDuration < minDuration)
-        {
-            minDuration = callDuration;
-        }
-    };
-
-    std::string toString(bool in_shouldClear = false)
-    {
-        std::string resultStr;
-        const std::string preFix = "<<" + name + ">>: ";
-        if (numberCalls == 0)
-        {
-            resultStr = preFix + "NO DATA.";
-        }
-        else
-        {
-            const auto avg = totalDuration/numberCalls;
+public:
+    GateTensorCache(size_t in_capacity);
+    // Returns the name of the ExaTN tensor of this gate instance:
+    // create it on a miss, evicting (destroying) the least recently used gate tensor if the cache is full.
+    std::string getGateTensor(xacc::Instruction& in_gate);
+    void setCapacity(size_t in_capacity);
+    // Drop all entries *without* destroying the tensors,
+    // e.g. when the ExaTN runtime has been (re)initialized.
+    void clear();
 
-            resultStr = preFix + "Number of calls = " + std::to_string(numberCalls) +
-                            "; Total time = " + std::to_string(totalDuration.count()) + " [secs]; " +
-                            "\nAvg = " + std::to_string(avg.count()) + " [secs]; " +
-                            "\nMin = " + std::to_string(minDuration.count()) + " [secs]; " +
-                            "\nMax = " + std::to_string(maxDuration.count()) + " [secs]; ";
-        }
+private:
+    void evict(size_t in_targetSize);
 
-        if (in_shouldClear)
-        {
-            totalDuration = std::chrono::duration<double>::zero();
-            numberCalls = 0;
-            maxDuration = std::chrono::duration<double>::zero();
-            minDuration = std::chrono::duration<double>::zero();
-        }
-        return resultStr;
-    };
+private:
+    size_t m_capacity;
+    // Most recently used at the front
+    std::list<std::string> m_lruList;
+    std::unordered_map<std::string, std::list<std::string>::iterator> m_entries;
+    std::mutex m_mutex;
 };
 }
-}
@@ -33,6 +33,9 @@
 
 #include "xacc.hpp"
 #include "IRTransformation.hpp"
+#include <algorithm>
+#include <limits>
+#include <numeric>
 
 namespace xacc {
 namespace quantum {
@@ -56,6 +59,16 @@ public:
         {
             maxDistance = in_options.get<int>("max-distance");
         }
+        // Lazy permutation mode (`lazy-permutation` = true): the swaps are never undone, instead we track
+        // the logical-to-physical qubit layout and route the following gates against the current layout.
+        // Note: the output program acts on *physical* qubits, measurements are remapped accordingly
+        // (hence measured bit strings are unchanged) but the final state is in the permuted layout.
+        const bool lazyPermutation = in_options.keyExists<bool>("lazy-permutation") && in_options.get<bool>("lazy-permutation");
+        int lookaheadDepth = 10;
+        if (in_options.keyExists<int>("lookahead-depth"))
+        {
+            lookaheadDepth = std::max(0, in_options.get<int>("lookahead-depth"));
+        }
 
         auto provider = xacc::getIRProvider("quantum");
         auto flattenedProgram = provider->createComposite(in_program->name() + "_Flattened");
@@ -69,6 +82,14 @@ public:
             }
         }
 
+        if (lazyPermutation)
+        {
+            auto transformedProgram = routeWithPermutation(flattenedProgram, maxDistance, lookaheadDepth);
+            in_program->clear();
+            in_program->addInstructions(transformedProgram->getInstructions());
+            return;
+        }
+
         auto transformedProgram = provider->createComposite(in_program->name() + "_Transformed");
         for (int i = 0; i < flattenedProgram->nInstructions(); ++i)
         {
@@ -137,6 +158,120 @@ public:
     const IRTransformationType type() const override { return IRTransformationType::Placement; }
     const std::string name() const override { return "lnn-transform"; }
     const std::string description() const override { return ""; }
+
+private:
+    // Lazy permutation routing: a long-range gate moves its (physical) qubits towards each other with
+    // adjacent swaps which are never undone. The number of swaps is fixed (distance - maxDistance),
+    // the split between the two sides is chosen to minimize the remaining distance of the next
+    // two-qubit gates (lookahead, weighted by 1/(k+1) for the k-th next one), ties go to meeting in the middle.
+    // Swap gates of the input program are absorbed into the layout (no gate at all).
+    std::shared_ptr<CompositeInstruction> routeWithPermutation(std::shared_ptr<CompositeInstruction> in_program, int in_maxDistance, int in_lookaheadDepth) const
+    {
+        auto provider = xacc::getIRProvider("quantum");
+        auto transformedProgram = provider->createComposite(in_program->name() + "_Transformed");
+        size_t nbQubits = 0;
+        for (const auto& inst : in_program->getInstructions())
+        {
+            for (const auto& bit : inst->bits())
+            {
+                nbQubits = std::max(nbQubits, bit + 1);
+            }
+        }
+        // Layout: logical qubit -> physical qubit, and the reverse.
+        std::vector<size_t> logicalToPhysical(nbQubits);
+        std::iota(logicalToPhysical.begin(), logicalToPhysical.end(), 0);
+        std::vector<size_t> physicalToLogical = logicalToPhysical;
+
+        const auto exceedMaxDistance = [&in_maxDistance](int q1, int q2)->bool {
+            return std::abs(q1 - q2) > in_maxDistance;
+        };
+        const auto swapPhysical = [&](size_t in_phys1, size_t in_phys2) {
+            std::swap(physicalToLogical[in_phys1], physicalToLogical[in_phys2]);
+            logicalToPhysical[physicalToLogical[in_phys1]] = in_phys1;
+            logicalToPhysical[physicalToLogical[in_phys2]] = in_phys2;
+        };
+
+        const auto instructions = in_program->getInstructions();
+        for (size_t i = 0; i < instructions.size(); ++i)
+        {
+            auto inst = instructions[i];
+            if (inst->name() == "Swap" && inst->bits().size() == 2)
+            {
+                swapPhysical(logicalToPhysical[inst->bits()[0]], logicalToPhysical[inst->bits()[1]]);
+                continue;
+            }
+
+            if (inst->bits().size() == 2)
+            {
+                const size_t phys0 = logicalToPhysical[inst->bits()[0]];
+                const size_t phys1 = logicalToPhysical[inst->bits()[1]];
+                if (exceedMaxDistance(phys0, phys1))
+                {
+                    const size_t lowerIdx = std::min(phys0, phys1);
+                    const size_t upperIdx = std::max(phys0, phys1);
+                    const size_t nbSwaps = upperIdx - lowerIdx - in_maxDistance;
+                    // Physical position of a qubit after moving the lower one up by `lowerMoves`
+                    // and the upper one down by (nbSwaps - lowerMoves).
+                    const auto movedPosition = [&](size_t in_phys, size_t lowerMoves)->size_t {
+                        const size_t upperMoves = nbSwaps - lowerMoves;
+                        if (in_phys == lowerIdx) return lowerIdx + lowerMoves;
+                        if (in_phys == upperIdx) return upperIdx - upperMoves;
+                        if (in_phys > lowerIdx && in_phys <= lowerIdx + lowerMoves) return in_phys - 1;
+                        if (in_phys < upperIdx && in_phys >= upperIdx - upperMoves) return in_phys + 1;
+                        return in_phys;
+                    };
+                    // Lookahead cost of each split
+                    size_t bestLowerMoves = (nbSwaps + 1) / 2;
+                    double bestCost = std::numeric_limits<double>::max();
+                    for (size_t lowerMoves = 0; lowerMoves <= nbSwaps; ++lowerMoves)
+                    {
+                        double cost = 0.0;
+                        int nbLookahead = 0;
+                        for (size_t j = i + 1; j < instructions.size() && nbLookahead < in_lookaheadDepth; ++j)
+                        {
+                            if (instructions[j]->bits().size() != 2 || instructions[j]->name() == "Swap")
+                            {
+                                continue;
+                            }
+                            const int nextPhys0 = movedPosition(logicalToPhysical[instructions[j]->bits()[0]], lowerMoves);
+                            const int nextPhys1 = movedPosition(logicalToPhysical[instructions[j]->bits()[1]], lowerMoves);
+                            cost += std::max(0, std::abs(nextPhys0 - nextPhys1) - in_maxDistance) / (nbLookahead + 1.0);
+                            ++nbLookahead;
+                        }
+                        const auto distanceToMiddle = [&](size_t in_lowerMoves) {
+                            return std::abs(2 * static_cast<int>(in_lowerMoves) - static_cast<int>(nbSwaps));
+                        };
+                        if (cost < bestCost || (cost == bestCost && distanceToMiddle(lowerMoves) < distanceToMiddle(bestLowerMoves)))
+                        {
+                            bestCost = cost;
+                            bestLowerMoves = lowerMoves;
+                        }
+                    }
+
+                    for (size_t k = 0; k < bestLowerMoves; ++k)
+                    {
+                        transformedProgram->addInstruction(provider->createInstruction("Swap", {lowerIdx + k, lowerIdx + k + 1}));
+                        swapPhysical(lowerIdx + k, lowerIdx + k + 1);
+                    }
+                    for (size_t k = 0; k < nbSwaps - bestLowerMoves; ++k)
+                    {
+                        transformedProgram->addInstruction(provider->createInstruction("Swap", {upperIdx - k, upperIdx - k - 1}));
+                        swapPhysical(upperIdx - k, upperIdx - k - 1);
+                    }
+                }
+            }
+
+            // Remap the gate (or measurement) onto the current physical qubits.
+            std::vector<size_t> physicalBits;
+            for (const auto& bit : inst->bits())
+            {
+                physicalBits.emplace_back(logicalToPhysical[bit]);
+            }
+            inst->setBits(physicalBits);
+            transformedProgram->addInstruction(inst);
+        }
+        return transformedProgram;
+    }
 };
 } // namespace quantum
 } // namespace xacc
\ No newline at end of file
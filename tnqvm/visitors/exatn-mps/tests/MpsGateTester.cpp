@@ -239,6 +239,53 @@ TEST(MpsGateTester, checkDistanceQubitGate)
     }
 } 
 
+TEST(MpsGateTester, checkLongRangeGates)
+{
+    // Non-adjacent gates (both qubit orders): applied directly (MPO) vs. nearest-neighbor transform (SWAPs).
+    auto xasmCompiler = xacc::getCompiler("xasm");
+    auto ir = xasmCompiler->compile(R"(__qpu__ void testLongRange(qbit q) {
+        H(q[0]);
+        Ry(q[2], 0.7);
+        CNOT(q[0], q[4]);
+        Rx(q[3], 0.4);
+        CNOT(q[4], q[1]);
+        CZ(q[3], q[0]);
+        Swap(q[0], q[2]);
+        H(q[4]);
+    })");
+
+    auto program = ir->getComposite("testLongRange");
+    auto provider = xacc::getIRProvider("quantum");
+    const size_t nbQubits = 5;
+    // <Z...Z> on every (non-empty) subset of qubits, i.e. the full bit string distribution (Walsh transform),
+    // so that a gate applied on the wrong qubits or with transposed legs is detected.
+    std::vector<std::vector<double>> expVals;
+    for (const bool longRange : { true, false })
+    {
+        auto accelerator = xacc::getAccelerator("tnqvm", {{"tnqvm-visitor", "exatn-mps"}, {"long-range-gates", longRange}});
+        expVals.emplace_back();
+        for (size_t mask = 1; mask < (1ULL << nbQubits); ++mask)
+        {
+            // Note: the nearest-neighbor transform modifies the kernel, hence always use a fresh copy.
+            auto kernel = std::dynamic_pointer_cast<xacc::CompositeInstruction>(program->clone());
+            for (size_t i = 0; i < nbQubits; ++i)
+            {
+                if ((mask >> i) & 1)
+                {
+                    kernel->addInstruction(provider->createInstruction("Measure", { i }));
+                }
+            }
+            auto qreg = xacc::qalloc(nbQubits);
+            accelerator->execute(qreg, kernel);
+            expVals.back().emplace_back(qreg->getExpectationValueZ());
+        }
+    }
+    for (size_t i = 0; i < expVals[0].size(); ++i)
+    {
+        EXPECT_NEAR(expVals[0][i], expVals[1][i], 1e-6);
+    }
+}
+
 TEST(MpsGateTester, checkTwoQubits)
 {
     {
@@ -406,6 +453,35 @@ TEST(MpsGateTester, testDeuteron)
     EXPECT_NEAR(buffer->getExpectationValueZ(), expectedResults[indexToTest], 0.05);
 }
 
+TEST(MpsGateTester, checkGateTensorCache)
+{
+    auto xasmCompiler = xacc::getCompiler("xasm");
+    auto ir = xasmCompiler->compile(R"(__qpu__ void testGateCache(qbit q) {
+        Rx(q[0], 0.3);
+        H(q[1]);
+        Rx(q[0], 0.3);
+        CNOT(q[1], q[2]);
+        Rx(q[0], 0.30000001);
+        H(q[1]);
+        CNOT(q[1], q[2]);
+        Measure(q[0]);
+    })");
+
+    auto program = ir->getComposite("testGateCache");
+    // Run with the default cache then with a single-entry cache (evict on every gate):
+    // the cache must not affect the result; angles only differing in the 8th digit are different gates.
+    for (const int cacheSize : { 64, 1 })
+    {
+        auto accelerator = xacc::getAccelerator("tnqvm", {{"tnqvm-visitor", "exatn-mps"}, {"gate-tensor-cache-size", cacheSize}});
+        for (int run = 0; run < 2; ++run)
+        {
+            auto qreg = xacc::qalloc(3);
+            accelerator->execute(qreg, program);
+            EXPECT_NEAR(qreg->getExpectationValueZ(), std::cos(0.90000001), 1e-9);
+        }
+    }
+}
+
 TEST(MpsGateTester, testGrover) 
 {
     // Test Grover's algorithm
@@ -34,7 +34,36 @@ TEST(MpsMeasurementTester, checkSimple)
     }
 }
 
-TEST(MpsMeasurementTester, checkRandomSeed) 
+TEST(MpsMeasurementTester, checkMultiShotLargeCircuit)
+{
+    auto xasmCompiler = xacc::getCompiler("xasm");
+    auto ir = xasmCompiler->compile(R"(__qpu__ void test2(qbit q) {
+        H(q[0]);
+        for (int i = 0; i < 29; i++) {
+            CNOT(q[i], q[i + 1]);
+        }
+        X(q[10]);
+        Measure(q[2]);
+        Measure(q[10]);
+        Measure(q[25]);
+    })");
+
+    auto program = ir->getComposite("test2");
+    // Above the state-vector limit: bit strings are sampled from the MPS directly.
+    auto accelerator = xacc::getAccelerator("tnqvm", {{"tnqvm-visitor", "exatn-mps"}, {"shots", 4096}});
+    auto qreg = xacc::qalloc(30);
+    accelerator->execute(qreg, program);
+    qreg->print();
+    // Only two possible outcomes: 010 or 101 (q[10] flipped)
+    const auto counts = qreg->getMeasurementCounts();
+    EXPECT_EQ(counts.size(), 2);
+    const auto prob0 = qreg->computeMeasurementProbability("010");
+    const auto prob1 = qreg->computeMeasurementProbability("101");
+    EXPECT_NEAR(prob0 + prob1, 1.0, 1e-12);
+    EXPECT_NEAR(prob0, 0.5, 0.1);
+}
+
+TEST(MpsMeasurementTester, checkRandomSeed)
 {
   std::vector<std::map<std::string, int>> results;
   constexpr int NB_TESTS = 20;
@@ -0,0 +1,104 @@
+#include <memory>
+#include <gtest/gtest.h>
+#include "xacc.hpp"
+#include "xacc_service.hpp"
+#include "NoiseModel.hpp"
+
+namespace {
+// Single-qubit amplitude damping (25% rate) after X on qubit 0:
+const std::string ad_json =
+    R"({"gate_noise": [{"gate_name": "X", "register_location": ["0"], "noise_channels": [{"matrix": [[[[1.0, 0.0], [0.0, 0.0]], [[0.0, 0.0], [0.8660254037844386, 0.0]]], [[[0.0, 0.0], [0.5, 0.0]], [[0.0, 0.0], [0.0, 0.0]]]]}]}], "bit_order": "MSB"})";
+// Same channel on the identity (idle) gate of qubit 0:
+const std::string idle_ad_json =
+    R"({"gate_noise": [{"gate_name": "I", "register_location": ["0"], "noise_channels": [{"matrix": [[[[1.0, 0.0], [0.0, 0.0]], [[0.0, 0.0], [0.8660254037844386, 0.0]]], [[[0.0, 0.0], [0.5, 0.0]], [[0.0, 0.0], [0.0, 0.0]]]]}]}], "bit_order": "MSB"})";
+} // namespace
+
+TEST(MpsTrajectoryTester, checkAmplitudeDamping)
+{
+    auto noiseModel = xacc::getService<xacc::NoiseModel>("json");
+    noiseModel->initialize({{"noise-model", ad_json}});
+    auto xasmCompiler = xacc::getCompiler("xasm");
+    auto ir = xasmCompiler->compile(R"(__qpu__ void testTrajAd(qbit q) {
+        X(q[0]);
+        CNOT(q[0], q[1]);
+        Measure(q[0]);
+        Measure(q[1]);
+    })");
+    auto program = ir->getComposite("testTrajAd");
+    {
+        // One shot per trajectory
+        auto accelerator = xacc::getAccelerator("tnqvm", {{"tnqvm-visitor", "exatn-mps-traj"}, {"noise-model", noiseModel}, {"shots", 4096}});
+        auto qreg = xacc::qalloc(3);
+        accelerator->execute(qreg, program);
+        // Decay (25%) before the CNOT: 00, otherwise: 11
+        EXPECT_EQ(qreg->getMeasurementCounts().size(), 2);
+        EXPECT_NEAR(qreg->computeMeasurementProbability("00"), 0.25, 0.05);
+        EXPECT_NEAR(qreg->computeMeasurementProbability("11"), 0.75, 0.05);
+    }
+    {
+        // No shots: exp-val-z averaged over the trajectories
+        auto irZ0 = xasmCompiler->compile(R"(__qpu__ void testTrajAdZ0(qbit q) {
+            X(q[0]);
+            CNOT(q[0], q[1]);
+            Measure(q[0]);
+        })");
+        auto accelerator = xacc::getAccelerator("tnqvm", {{"tnqvm-visitor", "exatn-mps-traj"}, {"noise-model", noiseModel}, {"trajectories", 2000}});
+        auto qreg = xacc::qalloc(3);
+        accelerator->execute(qreg, irZ0->getComposite("testTrajAdZ0"));
+        // <Z0> = P(decay) - P(no decay) = 0.25 - 0.75 (i.e. depends on the damping rate)
+        EXPECT_NEAR(qreg->getExpectationValueZ(), -0.5, 0.1);
+    }
+}
+
+TEST(MpsTrajectoryTester, checkIdleNoise)
+{
+    // Noise channels on the identity gate are applied, as in "exatn-dm".
+    auto noiseModel = xacc::getService<xacc::NoiseModel>("json");
+    noiseModel->initialize({{"noise-model", idle_ad_json}});
+    auto provider = xacc::getIRProvider("quantum");
+    auto program = provider->createComposite("testTrajIdle", {});
+    program->addInstruction(provider->createInstruction("X", 0));
+    program->addInstruction(provider->createInstruction("I", 0));
+    program->addInstruction(provider->createInstruction("Measure", 0));
+
+    auto trajAcc = xacc::getAccelerator("tnqvm", {{"tnqvm-visitor", "exatn-mps-traj"}, {"noise-model", noiseModel}, {"trajectories", 2000}});
+    auto trajBuffer = xacc::qalloc(2);
+    trajAcc->execute(trajBuffer, program);
+    auto dmAcc = xacc::getAccelerator("tnqvm", {{"tnqvm-visitor", "exatn-dm"}, {"noise-model", noiseModel}});
+    auto dmBuffer = xacc::qalloc(2);
+    dmAcc->execute(dmBuffer, program);
+    // <Z0> = 0.25 - 0.75 with the damping, -1.0 if the idle noise were dropped.
+    EXPECT_NEAR(dmBuffer->getExpectationValueZ(), -0.5, 1e-6);
+    EXPECT_NEAR(trajBuffer->getExpectationValueZ(), dmBuffer->getExpectationValueZ(), 0.1);
+}
+
+TEST(MpsTrajectoryTester, checkNoiseless)
+{
+    // Without noise model: a single (pure state) trajectory, same as "exatn-mps".
+    auto xasmCompiler = xacc::getCompiler("xasm");
+    auto ir = xasmCompiler->compile(R"(__qpu__ void testTrajNoiseless(qbit q) {
+        H(q[0]);
+        Ry(q[1], 0.7);
+        CNOT(q[0], q[3]);
+        CNOT(q[1], q[2]);
+        Measure(q[0]);
+        Measure(q[2]);
+    })");
+    auto program = ir->getComposite("testTrajNoiseless");
+    auto trajAcc = xacc::getAccelerator("tnqvm", {{"tnqvm-visitor", "exatn-mps-traj"}});
+    auto trajBuffer = xacc::qalloc(4);
+    trajAcc->execute(trajBuffer, program);
+    auto mpsAcc = xacc::getAccelerator("tnqvm", {{"tnqvm-visitor", "exatn-mps"}});
+    auto mpsBuffer = xacc::qalloc(4);
+    mpsAcc->execute(mpsBuffer, program);
+    EXPECT_NEAR(trajBuffer->getExpectationValueZ(), mpsBuffer->getExpectationValueZ(), 1e-9);
+}
+
+int main(int argc, char **argv) 
+{
+  xacc::Initialize();
+  ::testing::InitGoogleTest(&argc, argv);
+  auto ret = RUN_ALL_TESTS();
+  xacc::Finalize();
+  return ret;
+}
@@ -1,4 +1,6 @@
 #include <memory>
+#include <algorithm>
+#include <cmath>
 #include <gtest/gtest.h>
 #include "xacc.hpp"
 #include "xacc_service.hpp"
@@ -99,6 +101,129 @@ TEST(NearestNeighborTransformTester, checkDistanceConfig)
     EXPECT_EQ(lastInst->bits()[1], 1);
 }
 
+TEST(NearestNeighborTransformTester, checkLazyPermutation) 
+{    
+    // QFT-like all-to-all interactions
+    const auto createProgram = []() {
+        auto provider = xacc::getIRProvider("quantum");
+        auto program = provider->createComposite("test3");
+        const size_t nbQubits = 8;
+        for (size_t i = 0; i < nbQubits; ++i)
+        {
+            program->addInstruction(provider->createInstruction("H", { i }));
+            for (size_t j = i + 1; j < nbQubits; ++j)
+            {
+                program->addInstruction(provider->createInstruction("CPhase", { j, i }, { M_PI / (1 << (j - i)) }));
+            }
+        }
+        for (size_t i = 0; i < nbQubits; ++i)
+        {
+            program->addInstruction(provider->createInstruction("Measure", { i }));
+        }
+        return program;
+    };
+
+    auto opt = xacc::getService<xacc::IRTransformation>("lnn-transform");
+    auto swapBack = createProgram();
+    opt->apply(swapBack, nullptr);
+    auto lazy = createProgram();
+    opt->apply(lazy, nullptr, { std::make_pair("lazy-permutation", true) });
+
+    EXPECT_LT(countSwap(lazy), countSwap(swapBack));
+    std::vector<size_t> measuredQubits;
+    for (int i = 0; i < lazy->nInstructions(); ++i) 
+    {
+        auto inst = lazy->getInstruction(i);
+        if (inst->bits().size() == 2)
+        {
+            const int distance = inst->bits()[0] - inst->bits()[1];
+            EXPECT_EQ(std::abs(distance), 1);
+        }
+        if (inst->name() == "Measure")
+        {
+            measuredQubits.emplace_back(inst->bits()[0]);
+        }
+    }
+    // Measurements are remapped to the final layout: all (physical) qubits are measured once.
+    ASSERT_EQ(measuredQubits.size(), 8);
+    std::sort(measuredQubits.begin(), measuredQubits.end());
+    for (size_t i = 0; i < measuredQubits.size(); ++i)
+    {
+        EXPECT_EQ(measuredQubits[i], i);
+    }
+}
+
+TEST(NearestNeighborTransformTester, checkLazyPermutationSimulation) 
+{
+    // Same circuits simulated with lazy permutation on and off must agree on every (logical) qubit. 
+    const size_t nbQubits = 6;
+    const auto createProgram = [&](size_t in_measuredQubit) {
+        auto provider = xacc::getIRProvider("quantum");
+        auto program = provider->createComposite("lazy_" + std::to_string(in_measuredQubit));
+        for (size_t i = 0; i < nbQubits; ++i)
+        {
+            // Distinct single-qubit states so that mislabeled qubits are detected.
+            program->addInstruction(provider->createInstruction("Ry", { i }, { 0.3 + 0.4 * i }));
+        }
+        program->addInstruction(provider->createInstruction("CNOT", { 0, 5 }));
+        program->addInstruction(provider->createInstruction("CPhase", { 4, 1 }, { 0.7 }));
+        program->addInstruction(provider->createInstruction("Swap", { 0, 3 }));
+        program->addInstruction(provider->createInstruction("CNOT", { 5, 2 }));
+        program->addInstruction(provider->createInstruction("Rx", { 2 }, { 1.1 }));
+        program->addInstruction(provider->createInstruction("CZ", { 3, 1 }));
+        program->addInstruction(provider->createInstruction("CNOT", { 2, 4 }));
+        program->addInstruction(provider->createInstruction("Measure", { in_measuredQubit }));
+        return program;
+    };
+
+    const auto simulate = [&](bool in_lazyPermutation) {
+        std::vector<double> expVals;
+        auto accelerator = xacc::getAccelerator("tnqvm", {
+            std::make_pair("tnqvm-visitor", "exatn-mps"),
+            std::make_pair("long-range-gates", false),
+            std::make_pair("lazy-permutation", in_lazyPermutation) });
+        for (size_t i = 0; i < nbQubits; ++i)
+        {
+            auto qreg = xacc::qalloc(nbQubits);
+            accelerator->execute(qreg, createProgram(i));
+            expVals.emplace_back(qreg->getExpectationValueZ());
+        }
+        return expVals;
+    };
+
+    const auto swapBackExpVals = simulate(false);
+    const auto lazyExpVals = simulate(true);
+    for (size_t i = 0; i < nbQubits; ++i)
+    {
+        EXPECT_NEAR(lazyExpVals[i], swapBackExpVals[i], 1e-6);
+    }
+
+    // Deterministic circuit: measured bit strings must be identical.
+    auto xasmCompiler = xacc::getCompiler("xasm");
+    auto ir = xasmCompiler->compile(R"(__qpu__ void testLazyBits(qbit q) {
+        X(q[0]);
+        CNOT(q[0], q[5]);
+        CNOT(q[5], q[2]);
+        Swap(q[0], q[4]);
+        CNOT(q[4], q[1]);
+        Measure(q[0]);
+        Measure(q[1]);
+        Measure(q[2]);
+        Measure(q[3]);
+        Measure(q[4]);
+        Measure(q[5]);
+    })");
+    auto accelerator = xacc::getAccelerator("tnqvm", {
+        std::make_pair("tnqvm-visitor", "exatn-mps"),
+        std::make_pair("long-range-gates", false),
+        std::make_pair("lazy-permutation", true),
+        std::make_pair("shots", 100) });
+    auto qreg = xacc::qalloc(nbQubits);
+    accelerator->execute(qreg, ir->getComposite("testLazyBits"));
+    // q0 = 0, q1 = 1, q2 = 1, q3 = 0, q4 = 1, q5 = 1
+    EXPECT_NEAR(qreg->computeMeasurementProbability("011011"), 1.0, 1e-12);
+}
+
 int main(int argc, char **argv) 
 {
   xacc::Initialize();
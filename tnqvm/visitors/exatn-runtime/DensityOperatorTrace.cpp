@@ -0,0 +1,178 @@
+/***********************************************************************************
+ * Copyright (c) 2017, UT-Battelle
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the xacc nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Contributors:
+ *   Implementation - Thien Nguyen
+ *
+*/
+
+#include "DensityOperatorTrace.hpp"
+#include "exatn.hpp"
+#include "ExatnRuntime.hpp"
+#include <cassert>
+#include <list>
+#include <string>
+
+namespace {
+const tnqvm::LocalOperator IDENTITY_OP{ 1.0, 0.0, 0.0, 1.0 };
+
+tnqvm::LocalOperator multiply(const tnqvm::LocalOperator& in_lhs, const tnqvm::LocalOperator& in_rhs)
+{
+    return { in_lhs[0] * in_rhs[0] + in_lhs[1] * in_rhs[2], in_lhs[0] * in_rhs[1] + in_lhs[1] * in_rhs[3],
+             in_lhs[2] * in_rhs[0] + in_lhs[3] * in_rhs[2], in_lhs[2] * in_rhs[1] + in_lhs[3] * in_rhs[3] };
+}
+
+tnqvm::LocalOperator adjoint(const tnqvm::LocalOperator& in_op)
+{
+    return { std::conj(in_op[0]), std::conj(in_op[2]), std::conj(in_op[1]), std::conj(in_op[3]) };
+}
+
+bool isIdentity(const tnqvm::LocalOperator& in_op)
+{
+    for (size_t i = 0; i < in_op.size(); ++i)
+    {
+        if (std::abs(in_op[i] - IDENTITY_OP[i]) > 1e-12)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+}
+
+namespace tnqvm {
+LocalOperator applyAdjointChannel(const LocalOperator& in_op, const std::vector<LocalOperator>& in_krausOps)
+{
+    LocalOperator result{};
+    for (const auto& krausOp : in_krausOps)
+    {
+        const auto term = multiply(adjoint(krausOp), multiply(in_op, krausOp));
+        for (size_t i = 0; i < result.size(); ++i)
+        {
+            result[i] += term[i];
+        }
+    }
+    return result;
+}
+
+std::vector<std::complex<double>> traceProductOperators(const exatn::TensorNetwork& in_rhoNetwork, size_t in_nbQubits,
+                                                        const std::vector<std::vector<LocalOperator>>& in_products)
+{
+    std::vector<std::complex<double>> result;
+    result.reserve(in_products.size());
+    if (in_products.empty())
+    {
+        return result;
+    }
+
+    // The identity tensor closes the trace (and is also the operator on unobserved qubits).
+    const std::string idTensorName = "__TRACE_ID__";
+    {
+        const bool created = exatn::createTensorSync(idTensorName, exatn::TensorElementType::COMPLEX64, exatn::TensorShape{ 2, 2 });
+        assert(created);
+        const bool initialized = exatn::initTensorDataSync(idTensorName, std::vector<std::complex<double>>(IDENTITY_OP.begin(), IDENTITY_OP.end()));
+        assert(initialized);
+    }
+
+    std::list<exatn::numerics::ContrTriple> contrSeq;
+    unsigned int maxTensorId = 0;
+    for (size_t termId = 0; termId < in_products.size(); ++termId)
+    {
+        const auto& ops = in_products[termId];
+        assert(ops.size() == in_nbQubits);
+        exatn::TensorNetwork traceNetwork(in_rhoNetwork);
+        traceNetwork.rename("__TRACE_" + std::to_string(termId) + "_" + in_rhoNetwork.getName());
+        auto tensorIdCounter = traceNetwork.getMaxTensorId();
+        std::vector<std::string> opTensorNames;
+        // Apply the operator on the ket side, i.e. (O * rho)
+        for (size_t qId = 0; qId < in_nbQubits; ++qId)
+        {
+            std::string opTensorName = idTensorName;
+            if (!isIdentity(ops[qId]))
+            {
+                opTensorName = "__TRACE_OP_" + std::to_string(qId);
+                const bool created = exatn::createTensorSync(opTensorName, exatn::TensorElementType::COMPLEX64, exatn::TensorShape{ 2, 2 });
+                assert(created);
+                const bool initialized = exatn::initTensorDataSync(opTensorName, std::vector<std::complex<double>>(ops[qId].begin(), ops[qId].end()));
+                assert(initialized);
+                opTensorNames.emplace_back(opTensorName);
+            }
+            tensorIdCounter++;
+            const bool appended = traceNetwork.appendTensorGate(tensorIdCounter, exatn::getTensor(opTensorName), { static_cast<unsigned int>(qId) });
+            assert(appended);
+        }
+        // Close the network: connect the ket and bra legs of each qubit.
+        for (size_t qId = 0; qId < in_nbQubits; ++qId)
+        {
+            tensorIdCounter++;
+            const std::vector<std::pair<unsigned int, unsigned int>> tracePairing{
+                { 0, 0 }, { static_cast<unsigned int>(in_nbQubits - qId), 1 }
+            };
+            const bool appended = traceNetwork.appendTensor(tensorIdCounter, exatn::getTensor(idTensorName), tracePairing);
+            assert(appended);
+        }
+
+        if (!contrSeq.empty())
+        {
+            traceNetwork.importContractionSequence(contrSeq, maxTensorId);
+        }
+        const bool evaledOk = exatn::evaluateSync(traceNetwork);
+        assert(evaledOk);
+        tnqvm::recordNetworkMetrics(traceNetwork);
+        if (contrSeq.empty())
+        {
+            contrSeq = traceNetwork.exportContractionSequence(&maxTensorId);
+        }
+
+        const std::string outputTensorName = traceNetwork.getTensor(0)->getName();
+        std::complex<double> traceVal{ 0.0, 0.0 };
+        auto talsh_tensor = exatn::getLocalTensor(outputTensorName);
+        if (talsh_tensor)
+        {
+            const std::complex<double>* body_ptr;
+            if (talsh_tensor->getDataAccessHostConst(&body_ptr))
+            {
+                // Should only have 1 element:
+                assert(talsh_tensor->getVolume() == 1);
+                traceVal = *body_ptr;
+            }
+        }
+        result.emplace_back(traceVal);
+
+        const bool outputDestroyed = exatn::destroyTensorSync(outputTensorName);
+        assert(outputDestroyed);
+        for (const auto& opTensorName : opTensorNames)
+        {
+            const bool destroyed = exatn::destroyTensorSync(opTensorName);
+            assert(destroyed);
+        }
+    }
+
+    const bool destroyed = exatn::destroyTensorSync(idTensorName);
+    assert(destroyed);
+    return result;
+}
+}
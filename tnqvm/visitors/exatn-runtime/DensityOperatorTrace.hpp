@@ -0,0 +1,54 @@
+/***********************************************************************************
+ * Copyright (c) 2017, UT-Battelle
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the xacc nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Contributors:
+ *   Implementation - Thien Nguyen
+ *
+*/
+
+#pragma once
+
+#include <array>
+#include <complex>
+#include <vector>
+#include "tensor_network.hpp"
+
+namespace tnqvm {
+// Single-qubit operator (2x2 matrix, row-major)
+using LocalOperator = std::array<std::complex<double>, 4>;
+
+// Heisenberg picture of a single-qubit channel (Kraus operators, row-major 2x2):
+// returns O' = Sum_k [K_k^dagger * O * K_k], i.e. Tr(O' * rho) = Tr(O * E(rho)).
+// A unitary gate is a channel with a single Kraus operator.
+LocalOperator applyAdjointChannel(const LocalOperator& in_op, const std::vector<LocalOperator>& in_krausOps);
+
+// Computes Tr(rho * (O_0 x O_1 x ... x O_{n-1})) for each of the product operators (one operator per qubit).
+// The density operator network must have (2 * in_nbQubits) open legs: [ket_0, ..., ket_{n-1}, bra_0, ..., bra_{n-1}],
+// as the exatn-dm and exatn-pmps networks do; it is not modified.
+// Every trace network has the same topology, hence the contraction sequence of the first one is reused for the rest.
+std::vector<std::complex<double>> traceProductOperators(const exatn::TensorNetwork& in_rhoNetwork, size_t in_nbQubits,
+                                                        const std::vector<std::vector<LocalOperator>>& in_products);
+}
@@ -0,0 +1,290 @@
+/***********************************************************************************
+ * Copyright (c) 2017, UT-Battelle
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the xacc nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Contributors:
+ *   Implementation - Thien Nguyen
+ *
+*/
+
+#include "ExatnRuntime.hpp"
+#include "exatn.hpp"
+#include "xacc.hpp"
+#include "utils/MetricsRegistry.hpp"
+#include <algorithm>
+#include <cassert>
+#include <thread>
+#ifdef TNQVM_EXATN_USES_MKL_BLAS
+#include <dlfcn.h>
+#endif
+
+namespace {
+// Default host memory buffer size: 8GB
+const int64_t DEFAULT_HOST_BUFFER_SIZE_BYTES = 8 * (1ULL << 30);
+// Max amount of the host buffer that is touched when prewarming.
+const int64_t MAX_PREWARM_SIZE_BYTES = 1ULL << 30;
+
+void preloadMklLibraries()
+{
+#ifdef TNQVM_EXATN_USES_MKL_BLAS
+    // Fix for TNQVM bug #30
+    static bool loaded = false;
+    if (loaded)
+    {
+        return;
+    }
+    void *core_handle =
+        dlopen("@EXATN_MKL_PATH@/libmkl_core@CMAKE_SHARED_LIBRARY_SUFFIX@",
+                RTLD_LAZY | RTLD_GLOBAL);
+    if (core_handle == nullptr) {
+        std::string err = std::string(dlerror());
+        xacc::error("Could not load mkl_core - " + err);
+    }
+
+    void *thread_handle = dlopen(
+        "@EXATN_MKL_PATH@/libmkl_gnu_thread@CMAKE_SHARED_LIBRARY_SUFFIX@",
+        RTLD_LAZY | RTLD_GLOBAL);
+    if (thread_handle == nullptr) {
+        std::string err = std::string(dlerror());
+        xacc::error("Could not load mkl_gnu_thread - " + err);
+    }
+    loaded = true;
+#endif
+}
+}
+
+namespace tnqvm {
+ExatnRuntime& ExatnRuntime::get()
+{
+    static ExatnRuntime instance;
+    return instance;
+}
+
+ExatnRuntime::ExatnRuntime():
+    m_hostBufferSize(DEFAULT_HOST_BUFFER_SIZE_BYTES),
+    m_mpiCommunicator(nullptr),
+    m_loggingSubscribed(false)
+{}
+
+int64_t ExatnRuntime::getRequestedBufferSize(const xacc::HeterogeneousMap& in_options)
+{
+    if (!in_options.keyExists<int>("exatn-buffer-size-gb"))
+    {
+        return -1;
+    }
+    int bufferSizeGb = in_options.get<int>("exatn-buffer-size-gb");
+    if (bufferSizeGb < 1)
+    {
+        std::cout << "Minimum buffer size is 1 GB.\n";
+        bufferSizeGb = 1;
+    }
+    return bufferSizeGb * (1LL << 30);
+}
+
+void ExatnRuntime::waitForPrewarm()
+{
+    if (m_prewarm.valid())
+    {
+        m_prewarm.get();
+    }
+}
+
+void ExatnRuntime::initializeRuntime(int64_t in_hostBufferSizeBytes, void* in_mpiCommunicator)
+{
+    preloadMklLibraries();
+    exatn::ParamConf exatnParams;
+    const bool success = exatnParams.setParameter("host_memory_buffer_size", in_hostBufferSizeBytes);
+    assert(success);
+    std::cout << "Set ExaTN host memory buffer to " << in_hostBufferSizeBytes << " bytes.\n";
+// This is a flag from ExaTN indicating that ExaTN was compiled
+// w/ MPI enabled.
+#ifdef MPI_ENABLED
+    if (in_mpiCommunicator)
+    {
+        xacc::info("Setting ExaTN MPI_COMMUNICATOR...");
+        exatn::MPICommProxy commProxy(in_mpiCommunicator);
+        exatn::initialize(commProxy, exatnParams);
+    }
+    else
+    {
+        // No specific communicator is specified,
+        // exaTN will automatically use MPI_COMM_WORLD.
+        exatn::initialize(exatnParams);
+    }
+#else
+    exatn::initialize(exatnParams);
+#endif
+    exatn::activateContrSeqCaching();
+    m_hostBufferSize = in_hostBufferSizeBytes;
+    m_mpiCommunicator = in_mpiCommunicator;
+
+    if (exatn::getDefaultProcessGroup().getSize() > 1)
+    {
+        // Multiple MPI processes:
+        // if verbose is set, we must redirect log to files
+        // with custom names for each process.
+        if (xacc::verbose)
+        {
+            // Get the rank of this process.
+            const int processRank = exatn::getProcessRank();
+            const std::string fileNamePrefix = "process" + std::to_string(processRank);
+            // Redirect log to files (one for each MPI process)
+            xacc::logToFile(true, fileNamePrefix);
+        }
+    }
+
+    // ExaTN and XACC logging levels are always in-synced.
+    // Note: If xacc::verbose is not set, we always set ExaTN logging level to 0.
+    exatn::resetClientLoggingLevel(xacc::verbose ? xacc::getLoggingLevel() : 0);
+    exatn::resetRuntimeLoggingLevel(xacc::verbose ? xacc::getLoggingLevel() : 0);
+    if (!m_loggingSubscribed)
+    {
+        xacc::subscribeLoggingLevel([](int level) {
+            if (exatn::isInitialized())
+            {
+                exatn::resetClientLoggingLevel(xacc::verbose ? level : 0);
+                exatn::resetRuntimeLoggingLevel(xacc::verbose ? level : 0);
+            }
+        });
+        m_loggingSubscribed = true;
+    }
+
+    //Set up ExaTN computational backend:
+    const std::string backend = "cuquantum";
+    auto backends = exatn::queryComputationalBackends();
+    if (std::find(backends.cbegin(), backends.cend(), backend) != backends.cend())
+    {
+        exatn::switchComputationalBackend(backend);
+    }
+}
+
+bool ExatnRuntime::configure(int64_t in_hostBufferSizeBytes, void* in_mpiCommunicator)
+{
+    const int64_t bufferSize = in_hostBufferSizeBytes > 0 ? in_hostBufferSizeBytes : DEFAULT_HOST_BUFFER_SIZE_BYTES;
+    if (!exatn::isInitialized())
+    {
+        initializeRuntime(bufferSize, in_mpiCommunicator);
+        return true;
+    }
+    // Keep the current buffer unless a different size is explicitly requested.
+    if (in_hostBufferSizeBytes <= 0 || in_hostBufferSizeBytes == m_hostBufferSize)
+    {
+        return false;
+    }
+    // The buffer size can only be set at initialization.
+#ifdef MPI_ENABLED
+    if (!m_mpiCommunicator)
+    {
+        // ExaTN owns MPI (MPI_COMM_WORLD), which cannot be re-initialized.
+        xacc::warning("The ExaTN host buffer size cannot be changed after initialization when ExaTN owns MPI. "
+                      "Keeping " + std::to_string(m_hostBufferSize) + " bytes.");
+        return false;
+    }
+#endif
+    xacc::info("Resizing ExaTN host buffer: " + std::to_string(m_hostBufferSize) +
+               " -> " + std::to_string(in_hostBufferSizeBytes) + " bytes.");
+    exatn::finalize();
+    initializeRuntime(in_hostBufferSizeBytes, m_mpiCommunicator);
+    return true;
+}
+
+bool ExatnRuntime::initialize(const xacc::HeterogeneousMap& in_options)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    waitForPrewarm();
+    void* communicator = in_options.keyExists<void*>("mpi-communicator") ? in_options.get<void*>("mpi-communicator") : nullptr;
+    const bool initialized = configure(getRequestedBufferSize(in_options), communicator);
+    if (in_options.stringExists("exatn-contract-seq-optimizer"))
+    {
+        const std::string optimizerName = in_options.getString("exatn-contract-seq-optimizer");
+        std::cout << "Using '" << optimizerName << "' optimizer.\n";
+        exatn::resetContrSeqOptimizer(optimizerName);
+    }
+    return initialized;
+}
+
+void ExatnRuntime::prewarm(const xacc::HeterogeneousMap& in_options)
+{
+#ifndef MPI_ENABLED
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (exatn::isInitialized() || m_prewarm.valid())
+    {
+        return;
+    }
+    const int64_t requestedBufferSize = getRequestedBufferSize(in_options);
+    const int64_t bufferSize = requestedBufferSize > 0 ? requestedBufferSize : DEFAULT_HOST_BUFFER_SIZE_BYTES;
+    m_prewarm = std::async(std::launch::async, [this, bufferSize]() {
+        initializeRuntime(bufferSize, nullptr);
+        // Touch the beginning of the host buffer (where tensors get allocated first)
+        // so that the first contraction doesn't pay for the page faults.
+        const std::string prewarmTensorName = "TNQVM_PREWARM";
+        const int64_t prewarmVolume = std::min(bufferSize / 2, MAX_PREWARM_SIZE_BYTES) / static_cast<int64_t>(sizeof(double));
+        if (exatn::createTensorSync(prewarmTensorName, exatn::TensorElementType::REAL64, exatn::TensorShape{static_cast<exatn::DimExtent>(prewarmVolume)}))
+        {
+            exatn::initTensorSync(prewarmTensorName, 0.0);
+            exatn::destroyTensorSync(prewarmTensorName);
+        }
+    });
+#endif
+}
+
+bool ExatnRuntime::resize(int64_t in_hostBufferSizeBytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    waitForPrewarm();
+    configure(in_hostBufferSizeBytes, m_mpiCommunicator);
+    return m_hostBufferSize == in_hostBufferSizeBytes;
+}
+
+void ExatnRuntime::finalize()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    waitForPrewarm();
+    // Note: we lazily initialize ExaTN but always register this TearDown service by default,
+    // hence must check whether exaTN is initialized or not before finalizing it.
+    if (exatn::isInitialized())
+    {
+        xacc::debug("[exatn tear down] Finalizing ExaTN service...");
+        exatn::finalize();
+    }
+}
+
+void recordNetworkMetrics(exatn::numerics::TensorNetwork& in_network, size_t in_elementSize)
+{
+    auto& metrics = MetricsRegistry::get_instance();
+    metrics.increment("contractions");
+    // Both are cached by the network after its contraction sequence has been determined (on evaluation).
+    metrics.increment("contract-flops", in_network.getFMAFlops());
+    metrics.increment("contract-bytes", in_network.getMaxIntermediatePresenceVolume() * in_elementSize);
+}
+
+void recordNetworkMetrics(exatn::numerics::TensorExpansion& in_expansion, size_t in_elementSize)
+{
+    for (size_t i = 0; i < in_expansion.getNumComponents(); ++i)
+    {
+        recordNetworkMetrics(*(in_expansion.getComponent(i).network), in_elementSize);
+    }
+}
+}
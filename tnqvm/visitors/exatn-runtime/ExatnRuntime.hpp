@@ -0,0 +1,103 @@
+/***********************************************************************************
+ * Copyright (c) 2017, UT-Battelle
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the xacc nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Contributors:
+ *   Implementation - Thien Nguyen
+ *
+*/
+
+#pragma once
+
+#include <cstdint>
+#include "heterogeneous.hpp"
+#include <future>
+#include <mutex>
+
+namespace exatn {
+namespace numerics {
+class TensorNetwork;
+class TensorExpansion;
+}
+} // namespace exatn
+
+namespace tnqvm {
+// Records an evaluated tensor network in the metrics registry (utils/MetricsRegistry.hpp):
+// `contractions` (+1), `contract-flops` (FMA flops of its contraction sequence) and
+// `contract-bytes` (max volume of the intermediates times the element size).
+void recordNetworkMetrics(exatn::numerics::TensorNetwork& in_network, size_t in_elementSize = 2 * sizeof(double));
+// Same for each component network of an evaluated tensor expansion.
+void recordNetworkMetrics(exatn::numerics::TensorExpansion& in_expansion, size_t in_elementSize = 2 * sizeof(double));
+
+// Process-wide manager of the ExaTN runtime, shared by all ExaTN-based visitors.
+// ExaTN is lazily initialized once (MKL preload, host buffer, MPI communicator, logging, backend)
+// from the options of the first visitor that needs it. Supported options:
+// - `exatn-buffer-size-gb` (int): host memory buffer size, default 8 GB.
+//   If a later visitor requests a different size, the runtime is re-initialized (resized).
+// - `exatn-contract-seq-optimizer` (string): contraction sequence optimizer (can be changed at any time).
+// - `mpi-communicator` (void*): MPI communicator (first initialization only).
+class ExatnRuntime
+{
+public:
+    static ExatnRuntime& get();
+
+    // Makes sure the runtime is initialized and configured as requested by the options.
+    // Returns true if ExaTN has been (re-)initialized by this call, i.e. any tensors
+    // which were created before (e.g. cached gate tensors) are gone.
+    bool initialize(const xacc::HeterogeneousMap& in_options);
+    // Starts the initialization on a background thread (e.g. while the IR is being compiled),
+    // including touching (part of) the host memory buffer. The next `initialize` call waits for it.
+    // Note: no-op if ExaTN was built with MPI (MPI must be initialized on the main thread).
+    void prewarm(const xacc::HeterogeneousMap& in_options);
+    // Re-initializes ExaTN with a new host buffer size (all tensors are destroyed,
+    // hence must not be called while a visitor is running).
+    // Returns false if the runtime cannot be re-initialized, e.g. ExaTN owns MPI.
+    bool resize(int64_t in_hostBufferSizeBytes);
+    // Host buffer size of the current runtime (bytes).
+    int64_t getHostBufferSize() const { return m_hostBufferSize; }
+    // Finalizes ExaTN if it has been initialized, e.g. on XACC finalization.
+    void finalize();
+
+private:
+    ExatnRuntime();
+    ExatnRuntime(const ExatnRuntime&) = delete;
+    ExatnRuntime& operator=(const ExatnRuntime&) = delete;
+    // Requires m_mutex
+    void waitForPrewarm();
+    void initializeRuntime(int64_t in_hostBufferSizeBytes, void* in_mpiCommunicator);
+    // (Re-)initializes the runtime if needed (requires m_mutex), returns true if it did.
+    // A non-positive buffer size means no specific request.
+    bool configure(int64_t in_hostBufferSizeBytes, void* in_mpiCommunicator);
+    static int64_t getRequestedBufferSize(const xacc::HeterogeneousMap& in_options);
+
+private:
+    std::mutex m_mutex;
+    std::future<void> m_prewarm;
+    int64_t m_hostBufferSize;
+    // MPI communicator that ExaTN was initialized with (null: ExaTN's own MPI_COMM_WORLD).
+    void* m_mpiCommunicator;
+    bool m_loggingSubscribed;
+};
+}
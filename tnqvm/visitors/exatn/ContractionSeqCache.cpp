@@ -0,0 +1,237 @@
+/***********************************************************************************
+ * Copyright (c) 2017, UT-Battelle
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the xacc nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Contributors:
+ *   Implementation - Thien Nguyen
+ *
+*/
+
+#include "ContractionSeqCache.hpp"
+#include "xacc.hpp"
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <list>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+// Cache file format version: bump if the format changes.
+const std::string CONTRACTION_SEQ_FILE_HEADER = "tnqvm-contraction-seq-v1";
+
+// 64-bit FNV-1a: stable across processes/platforms (unlike std::hash).
+uint64_t fnv1aHash(const std::string& in_data)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (const auto& c : in_data)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Creates the directory (and its parents) if needed.
+bool makeDirectories(const std::string& in_path)
+{
+    for (size_t pos = in_path.find('/', 1); ; pos = in_path.find('/', pos + 1))
+    {
+        const std::string subPath = in_path.substr(0, pos);
+        if (!subPath.empty() && mkdir(subPath.c_str(), 0755) != 0 && errno != EEXIST)
+        {
+            return false;
+        }
+        if (pos == std::string::npos)
+        {
+            return true;
+        }
+    }
+}
+}
+
+namespace tnqvm {
+ContractionSeqCache::ContractionSeqCache(const std::string& in_cacheDir, const std::string& in_optimizerName):
+    m_cacheDir(in_cacheDir),
+    m_optimizerName(in_optimizerName)
+{
+    while (m_cacheDir.size() > 1 && m_cacheDir.back() == '/')
+    {
+        m_cacheDir.pop_back();
+    }
+    if (!m_cacheDir.empty() && !makeDirectories(m_cacheDir))
+    {
+        xacc::warning("Failed to create the contraction sequence cache directory: " + m_cacheDir);
+    }
+}
+
+std::string ContractionSeqCache::getKey(const exatn::numerics::TensorNetwork& in_network) const
+{
+    // Tensor Ids are iterated in order, and each tensor is described
+    // by its dimension extents and the (tensor Id, dimension Id) of each of its legs.
+    std::stringstream topology;
+    topology << m_optimizerName << ";";
+    for (auto iter = in_network.cbegin(); iter != in_network.cend(); ++iter)
+    {
+        topology << iter->first << "[";
+        for (const auto& dim : iter->second.getTensor()->getDimExtents())
+        {
+            topology << dim << ",";
+        }
+        topology << "](";
+        for (const auto& leg : iter->second.getTensorLegs())
+        {
+            topology << leg.getTensorId() << ":" << leg.getDimensionId() << ",";
+        }
+        topology << ");";
+    }
+    std::stringstream key;
+    key << std::hex << std::setw(16) << std::setfill('0') << fnv1aHash(topology.str());
+    return key.str();
+}
+
+bool ContractionSeqCache::apply(exatn::numerics::TensorNetwork& io_network, Cost* out_cost) const
+{
+    const std::string key = getKey(io_network);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto iter = m_plans.find(key);
+    if (iter == m_plans.end() && load(key, io_network))
+    {
+        // Keep the sequence loaded from disk in memory too (its cost is unknown).
+        Plan plan;
+        plan.sequence = io_network.exportContractionSequence(&plan.maxTensorId);
+        iter = m_plans.emplace(key, std::move(plan)).first;
+    }
+    if (iter != m_plans.end())
+    {
+        if (iter->second.sequence.size() + 1 == io_network.getNumTensors())
+        {
+            io_network.importContractionSequence(iter->second.sequence, iter->second.maxTensorId);
+            if (out_cost)
+            {
+                *out_cost = iter->second.cost;
+            }
+            return true;
+        }
+        m_plans.erase(iter);
+    }
+    // Cache miss: run the optimizer now (it would otherwise run on evaluation)
+    // and cache its result.
+    io_network.getOperationList(m_optimizerName);
+    Plan plan;
+    plan.sequence = io_network.exportContractionSequence(&plan.maxTensorId);
+    plan.cost.flops = io_network.getFMAFlops();
+    plan.cost.maxIntermediateVolume = io_network.getMaxIntermediatePresenceVolume();
+    if (out_cost)
+    {
+        *out_cost = plan.cost;
+    }
+    m_plans[key] = std::move(plan);
+    save(key, io_network);
+    return false;
+}
+
+bool ContractionSeqCache::load(const std::string& in_key, exatn::numerics::TensorNetwork& io_network) const
+{
+    if (m_cacheDir.empty())
+    {
+        return false;
+    }
+    std::ifstream cacheFile(m_cacheDir + "/" + in_key + ".cseq");
+    if (!cacheFile.is_open())
+    {
+        return false;
+    }
+
+    std::string header;
+    std::string optimizerName;
+    unsigned int maxTensorId = 0;
+    size_t nbContractions = 0;
+    if (!(cacheFile >> header >> optimizerName >> maxTensorId >> nbContractions) ||
+        header != CONTRACTION_SEQ_FILE_HEADER || optimizerName != m_optimizerName)
+    {
+        return false;
+    }
+
+    std::list<exatn::numerics::ContrTriple> contrSeq;
+    for (size_t i = 0; i < nbContractions; ++i)
+    {
+        exatn::numerics::ContrTriple triple;
+        if (!(cacheFile >> triple.result_id >> triple.left_id >> triple.right_id))
+        {
+            // Truncated/corrupted file: ignore it.
+            return false;
+        }
+        contrSeq.emplace_back(triple);
+    }
+    // A network with N input tensors is contracted in (N - 1) pairwise contractions.
+    if (contrSeq.size() + 1 != io_network.getNumTensors())
+    {
+        return false;
+    }
+
+    io_network.importContractionSequence(contrSeq, maxTensorId);
+    return true;
+}
+
+void ContractionSeqCache::save(const std::string& in_key, const exatn::numerics::TensorNetwork& in_network) const
+{
+    if (m_cacheDir.empty())
+    {
+        return;
+    }
+    unsigned int maxTensorId = 0;
+    const auto& contrSeq = in_network.exportContractionSequence(&maxTensorId);
+    if (contrSeq.empty())
+    {
+        return;
+    }
+
+    // Write to a temporary file then rename it so that
+    // other processes never read a partially-written sequence.
+    const std::string fileName = m_cacheDir + "/" + in_key + ".cseq";
+    const std::string tempFileName = fileName + ".tmp" + std::to_string(getpid());
+    {
+        std::ofstream cacheFile(tempFileName);
+        if (!cacheFile.is_open())
+        {
+            return;
+        }
+        cacheFile << CONTRACTION_SEQ_FILE_HEADER << "\n" << m_optimizerName << "\n"
+                  << maxTensorId << "\n" << contrSeq.size() << "\n";
+        for (const auto& triple : contrSeq)
+        {
+            cacheFile << triple.result_id << " " << triple.left_id << " " << triple.right_id << "\n";
+        }
+    }
+    if (std::rename(tempFileName.c_str(), fileName.c_str()) != 0)
+    {
+        std::remove(tempFileName.c_str());
+    }
+}
+}
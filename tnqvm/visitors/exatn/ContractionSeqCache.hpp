@@ -0,0 +1,86 @@
+/***********************************************************************************
+ * Copyright (c) 2017, UT-Battelle
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the xacc nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Contributors:
+ *   Implementation - Thien Nguyen
+ *
+*/
+
+#pragma once
+
+#include "tensor_network.hpp"
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace tnqvm {
+// Cache of optimized tensor contraction sequences (plans).
+// ExaTN's own contraction sequence cache only lives as long as the process,
+// hence repeated runs of the same circuit would re-run the (expensive) sequence optimizer.
+// Sequences are keyed by a hash of the network topology (tensor shapes and connections,
+// not tensor names/data) and the optimizer name, and kept in memory, e.g. the marginal
+// networks of every shot share the plans of the first one.
+// If a cache directory is given, sequences are also persisted one file per network.
+class ContractionSeqCache
+{
+public:
+    // Contraction cost of a sequence, negative if unknown (loaded from disk).
+    struct Cost
+    {
+        double flops = -1.0;
+        double maxIntermediateVolume = -1.0;
+    };
+
+    // Empty `in_cacheDir`: in-memory cache only.
+    ContractionSeqCache(const std::string& in_cacheDir, const std::string& in_optimizerName);
+    // Sets the contraction sequence of the network (before evaluation):
+    // taken from the cache if available, otherwise determined by the optimizer and saved to the cache.
+    // Returns true if this was a cache hit.
+    bool apply(exatn::numerics::TensorNetwork& io_network, Cost* out_cost = nullptr) const;
+    // Canonical key of the network topology (+ optimizer)
+    std::string getKey(const exatn::numerics::TensorNetwork& in_network) const;
+
+private:
+    struct Plan
+    {
+        std::list<exatn::numerics::ContrTriple> sequence;
+        unsigned int maxTensorId = 0;
+        Cost cost;
+    };
+
+    bool load(const std::string& in_key, exatn::numerics::TensorNetwork& io_network) const;
+    void save(const std::string& in_key, const exatn::numerics::TensorNetwork& in_network) const;
+
+private:
+    std::string m_cacheDir;
+    std::string m_optimizerName;
+    // In-memory plans by key.
+    mutable std::unordered_map<std::string, Plan> m_plans;
+    // Serializes cache access from this process (e.g. concurrent slice submission).
+    mutable std::mutex m_mutex;
+};
+}
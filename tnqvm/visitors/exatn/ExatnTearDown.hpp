@@ -2,6 +2,7 @@
 
 #include "TearDown.hpp"
 #include "exatn.hpp"
+#include "ExatnRuntime.hpp"
 #include "xacc.hpp"
 
 // Impl xacc TearDown interface to finalize ExaTN when we are done (XACC::Finalize)
@@ -11,13 +12,9 @@ class ExatnTearDown : public xacc::TearDown
 public:
     virtual void tearDown() override
     {
-        // Note: we lazily initialize ExaTN but always register this TearDown service by default,
-        // hence must check whether exaTN is initialized or not before finalizing it.
-        if(exatn::isInitialized())
-        {
-            xacc::debug("[exatn tear down] Finalizing ExaTN service...");
-            exatn::finalize();
-        }
+        // Finalizes ExaTN if it has been (lazily) initialized,
+        // waiting for any pending background prewarm first.
+        ExatnRuntime::get().finalize();
     }
 };
 } // namespace
\ No newline at end of file
@@ -39,15 +39,20 @@
 #include "Instruction.hpp"
 #include "talshxx.hpp"
 #include <numeric>
+#include <algorithm>
+#include <cmath>
 #include <random>
 #include <chrono>
 #include <functional>
 #include <unordered_set>
+#include <map>
+#include <sstream>
+#include <iomanip>
+#include <limits>
 #include "utils/GateMatrixAlgebra.hpp"
-
-#ifdef TNQVM_EXATN_USES_MKL_BLAS
-#include <dlfcn.h>
-#endif
+#include "ContractionSeqCache.hpp"
+#include "ExatnRuntime.hpp"
+#include "utils/RandomEngine.hpp"
 
 bool tnqvm_timing_log_enabled = true;
 
@@ -61,8 +66,9 @@ std::string generateQubitTensorName(int qubitIndex) {
 // e.g. simulating bit-string measurement by tensor contraction.
 const int MAX_NUMBER_QUBITS_FOR_STATE_VEC = 50;
 
-// Max memory size: 8GB
-const int64_t MAX_TALSH_MEMORY_BUFFER_SIZE_BYTES = 8 * (1ULL << 30);
+// Default number of wave function slices that are contracted concurrently
+// (exp-val-z by slicing on a single process).
+const int DEFAULT_MAX_CONCURRENT_SLICES = 4;
 
 template<typename TNQVM_COMPLEX_TYPE>
 std::vector<TNQVM_COMPLEX_TYPE> flattenGateMatrix(
@@ -97,25 +103,111 @@ template<typename TNQVM_COMPLEX_TYPE>
 double calcExpValueZ(const std::vector<int>& in_bits, const std::vector<TNQVM_COMPLEX_TYPE>& in_stateVec)
 {
   TNQVM_TELEMETRY_ZONE("calcExpValueZ", __FILE__, __LINE__);
-  const auto hasEvenParity = [](uint64_t x, const std::vector<int>& in_qubitIndices) -> bool {
-    size_t count = 0;
-    for (const auto& bitIdx : in_qubitIndices)
-    {
-        if (x & (1ULL << bitIdx))
-        {
-            count++;
-        }
-    }
-    return (count % 2) == 0;
-  };
+  return CalcExpValueZ(in_stateVec, in_bits);
+}
 
-  double result = 0.0;
-  for(uint64_t i = 0; i < in_stateVec.size(); ++i)
-  {
-    result += (hasEvenParity(i, in_bits) ? 1.0 : -1.0) * std::norm(in_stateVec[i]);
+// Matrix of a single-qubit gate instruction (e.g. a VQE basis change),
+// empty if the gate is not supported.
+GateMatrixType getSingleQubitGateMatrix(xacc::Instruction& in_gate)
+{
+  using tnqvm::CommonGates;
+  using tnqvm::GetGateMatrix;
+  switch (tnqvm::GetGateType(in_gate.name())) {
+  case CommonGates::I: return GetGateMatrix<CommonGates::I>();
+  case CommonGates::H: return GetGateMatrix<CommonGates::H>();
+  case CommonGates::X: return GetGateMatrix<CommonGates::X>();
+  case CommonGates::Y: return GetGateMatrix<CommonGates::Y>();
+  case CommonGates::Z: return GetGateMatrix<CommonGates::Z>();
+  case CommonGates::T: return GetGateMatrix<CommonGates::T>();
+  case CommonGates::Tdg: return GetGateMatrix<CommonGates::Tdg>();
+  case CommonGates::Rx: return GetGateMatrix<CommonGates::Rx>(in_gate.getParameter(0).as<double>());
+  case CommonGates::Ry: return GetGateMatrix<CommonGates::Ry>(in_gate.getParameter(0).as<double>());
+  case CommonGates::Rz: return GetGateMatrix<CommonGates::Rz>(in_gate.getParameter(0).as<double>());
+  case CommonGates::U:
+    return GetGateMatrix<CommonGates::U>(in_gate.getParameter(0).as<double>(),
+                                         in_gate.getParameter(1).as<double>(),
+                                         in_gate.getParameter(2).as<double>());
+  default: return {};
   }
+}
 
-  return result;
+// VQE mode: an observable sub-circuit (change of basis + measurements)
+// decomposed into single-qubit basis-change gates per qubit and measured qubits.
+struct ObservedBasis
+{
+  // Unique key of the basis-change gate sequence on each qubit.
+  // Measured qubits w/o basis change have an empty key (Z basis).
+  std::map<size_t, std::string> basisKeys;
+  // Basis-change gate matrices on each qubit (circuit order).
+  std::map<size_t, std::vector<GateMatrixType>> basisChanges;
+  std::vector<size_t> measuredQubits;
+  // Terms that share this basis (for a merged group)
+  std::vector<size_t> termIds;
+};
+
+// Returns false if the sub-circuit cannot be expressed as single-qubit basis changes,
+// e.g. it contains multi-qubit gates.
+bool decomposeObservedCircuit(const std::shared_ptr<CompositeInstruction>& in_function, ObservedBasis& out_basis)
+{
+  InstructionIterator it(in_function);
+  while (it.hasNext()) {
+    auto nextInst = it.next();
+    if (!nextInst->isEnabled() || nextInst->isComposite()) {
+      continue;
+    }
+    if (nextInst->name() == "Measure") {
+      out_basis.measuredQubits.emplace_back(nextInst->bits()[0]);
+      continue;
+    }
+    if (nextInst->bits().size() != 1) {
+      return false;
+    }
+    auto gateMatrix = getSingleQubitGateMatrix(*nextInst);
+    if (gateMatrix.empty()) {
+      return false;
+    }
+    const size_t qubitIdx = nextInst->bits()[0];
+    std::stringstream gateKey;
+    gateKey << std::setprecision(std::numeric_limits<double>::max_digits10) << nextInst->name();
+    for (size_t i = 0; i < nextInst->nParameters(); ++i) {
+      gateKey << "_" << nextInst->getParameter(i).as<double>();
+    }
+    gateKey << ";";
+    out_basis.basisKeys[qubitIdx].append(gateKey.str());
+    out_basis.basisChanges[qubitIdx].emplace_back(std::move(gateMatrix));
+  }
+  for (const auto& qubitIdx : out_basis.measuredQubits) {
+    // No-op if there is a basis change on this qubit.
+    out_basis.basisKeys.emplace(qubitIdx, "");
+  }
+  return !out_basis.measuredQubits.empty();
+}
+
+// Greedily merges (in input order) terms whose bases agree on every shared qubit,
+// i.e. qubit-wise commuting terms that can be measured from the same rotated state.
+std::vector<ObservedBasis> groupObservedBases(const std::vector<ObservedBasis>& in_terms)
+{
+  std::vector<ObservedBasis> groups;
+  for (size_t termId = 0; termId < in_terms.size(); ++termId) {
+    const auto& term = in_terms[termId];
+    const auto isCompatible = [&term](const ObservedBasis& in_group) {
+      for (const auto& [qubitIdx, basisKey] : term.basisKeys) {
+        const auto iter = in_group.basisKeys.find(qubitIdx);
+        if (iter != in_group.basisKeys.end() && iter->second != basisKey) {
+          return false;
+        }
+      }
+      return true;
+    };
+    auto groupIter = std::find_if(groups.begin(), groups.end(), isCompatible);
+    if (groupIter == groups.end()) {
+      groupIter = groups.emplace(groups.end());
+    }
+    groupIter->basisKeys.insert(term.basisKeys.begin(), term.basisKeys.end());
+    groupIter->basisChanges.insert(term.basisChanges.begin(), term.basisChanges.end());
+    groupIter->termIds.emplace_back(termId);
+  }
+  return groups;
 }
 } // namespace
 
@@ -232,25 +324,13 @@ template<typename TNQVM_COMPLEX_TYPE>
 int CalculateExpectationValueFunctor<TNQVM_COMPLEX_TYPE>::apply(talsh::Tensor &local_tensor) {
   TNQVM_TELEMETRY_ZONE(__FUNCTION__, __FILE__, __LINE__);
 
-  const auto hasEvenParity =
-      [](size_t x, const std::vector<int> &in_qubitIndices) -> bool {
-    size_t count = 0;
-    for (const auto &bitIdx : in_qubitIndices) {
-      if (x & (1ULL << bitIdx)) {
-        count++;
-      }
-    }
-    return (count % 2) == 0;
-  };
-
   TNQVM_COMPLEX_TYPE *elements;
   const bool isOkay = local_tensor.getDataAccessHost(&elements);
   m_result = 0.0;
   if (isOkay) {
-    for (uint64_t i = 0; i < local_tensor.getVolume(); ++i) {
-      m_result += (hasEvenParity(i, m_qubitIndices) ? 1.0 : -1.0) *
-                  std::norm(elements[i]);
-    }
+    m_result = CalcExpValueZBatch(elements, local_tensor.getVolume(),
+                                  {ParityMask(m_qubitIndices)})
+                   .front();
   }
 
   return 0;
@@ -379,124 +459,16 @@ void ExatnDebugLogger<TNQVM_COMPLEX_TYPE>::postMeasurement(tnqvm::ExatnVisitor<T
 template<typename TNQVM_COMPLEX_TYPE>
 ExatnVisitor<TNQVM_COMPLEX_TYPE>::ExatnVisitor()
     : m_tensorNetwork("Quantum Circuit"), m_tensorIdCounter(0),
-      m_hasEvaluated(false), m_isAppendingCircuitGates(true) {}
+      m_hasEvaluated(false), m_isAppendingCircuitGates(true),
+      m_maxConcurrentSlices(DEFAULT_MAX_CONCURRENT_SLICES),
+      m_fusedGateCounter(0) {}
 
 template<typename TNQVM_COMPLEX_TYPE>
 void ExatnVisitor<TNQVM_COMPLEX_TYPE>::initialize(std::shared_ptr<AcceleratorBuffer> buffer,
                                                   int nbShots) {
-  int64_t talshHostBufferSizeInBytes = MAX_TALSH_MEMORY_BUFFER_SIZE_BYTES;
-  if (!exatn::isInitialized()) {
-#ifdef TNQVM_EXATN_USES_MKL_BLAS
-    // Fix for TNQVM bug #30
-    void *core_handle =
-        dlopen("@EXATN_MKL_PATH@/libmkl_core@CMAKE_SHARED_LIBRARY_SUFFIX@",
-               RTLD_LAZY | RTLD_GLOBAL);
-    if (core_handle == nullptr) {
-      std::string err = std::string(dlerror());
-      xacc::error("Could not load mkl_core - " + err);
-    }
-
-    void *thread_handle = dlopen(
-        "@EXATN_MKL_PATH@/libmkl_gnu_thread@CMAKE_SHARED_LIBRARY_SUFFIX@",
-        RTLD_LAZY | RTLD_GLOBAL);
-    if (thread_handle == nullptr) {
-      std::string err = std::string(dlerror());
-      xacc::error("Could not load mkl_gnu_thread - " + err);
-    }
-#endif
-
-    // If exaTN has not been initialized, do it now.
-    exatn::ParamConf exatnParams;
-    if (options.keyExists<int>("exatn-buffer-size-gb"))
-    {
-      int bufferSizeGb = options.get<int>("exatn-buffer-size-gb");
-      if (bufferSizeGb < 1)
-      {
-        std::cout << "Minimum buffer size is 1 GB.\n";
-        bufferSizeGb = 1;
-      }
-      // Set the memory buffer size:
-      const int64_t memorySizeBytes = bufferSizeGb * (1ULL << 30);
-      std::cout << "Set ExaTN host memory buffer to " << memorySizeBytes << " bytes.\n";
-      const bool success = exatnParams.setParameter("host_memory_buffer_size", memorySizeBytes);
-      assert(success);
-      // Update buffer size.
-      talshHostBufferSizeInBytes = memorySizeBytes;
-    }
-    else
-    {
-      // Use default buffer size
-      const bool success = exatnParams.setParameter("host_memory_buffer_size", MAX_TALSH_MEMORY_BUFFER_SIZE_BYTES);
-      assert(success);
-    }
-// This is a flag from ExaTN indicating that ExaTN was compiled
-// w/ MPI enabled.
-#ifdef MPI_ENABLED
-    {
-      if (options.keyExists<void*>("mpi-communicator"))
-      {
-        xacc::info("Setting ExaTN MPI_COMMUNICATOR...");
-        auto communicator = options.get<void*>("mpi-communicator");
-        exatn::MPICommProxy commProxy(communicator);
-        exatn::initialize(commProxy, exatnParams);
-      }
-      else
-      {
-        // No specific communicator is specified,
-        // exaTN will automatically use MPI_COMM_WORLD.
-        exatn::initialize(exatnParams);
-      }
-      exatn::activateContrSeqCaching();
-      //exatn::resetExecutionSerialization(true,true); //validation
-    }
-#else
-    {
-      exatn::initialize(exatnParams);
-      exatn::activateContrSeqCaching();
-      //exatn::resetExecutionSerialization(true,true); //validation
-    }
-#endif
-
-    if (exatn::getDefaultProcessGroup().getSize() > 1)
-    {
-      // Multiple MPI processes:
-      // if verbose is set, we must redirect log to files
-      // with custom names for each process.
-      if (xacc::verbose)
-      {
-        // Get the rank of this process.
-        const int processRank = exatn::getProcessRank();
-        const std::string fileNamePrefix = "process" + std::to_string(processRank);
-        // Redirect log to files (one for each MPI process)
-        xacc::logToFile(true, fileNamePrefix);
-      }
-    }
-
-    if (options.stringExists("exatn-contract-seq-optimizer"))
-    {
-      const std::string optimizerName = options.getString("exatn-contract-seq-optimizer");
-      std::cout << "Using '" << optimizerName << "' optimizer.\n";
-      exatn::resetContrSeqOptimizer(optimizerName);
-    }
-
-    // ExaTN and XACC logging levels are always in-synced.
-    // Note: If xacc::verbose is not set, we always set ExaTN logging level to 0.
-    exatn::resetClientLoggingLevel(xacc::verbose ? xacc::getLoggingLevel() : 0);
-    exatn::resetRuntimeLoggingLevel(xacc::verbose ? xacc::getLoggingLevel() : 0);
-    xacc::subscribeLoggingLevel([](int level) {
-      exatn::resetClientLoggingLevel(xacc::verbose ? level : 0);
-      exatn::resetRuntimeLoggingLevel(xacc::verbose ? level : 0);
-    });
-
-    //Set up ExaTN computational backend:
-    const std::string backend = "cuquantum";
-    auto backends = exatn::queryComputationalBackends();
-    if(std::find(backends.cbegin(),backends.cend(),backend) != backends.cend()) {
-      exatn::switchComputationalBackend(backend);
-      //std::cout << "#MSG(TN-QVM:ExaTN): Switched computational backend to "
-      //          << backend << std::endl << std::flush; //debug
-    }
-  }
+  // Initialize (or reconfigure) the ExaTN runtime shared by all visitors.
+  ExatnRuntime::get().initialize(options);
+  const int64_t talshHostBufferSizeInBytes = ExatnRuntime::get().getHostBufferSize();
 
   m_hasEvaluated = false;
   m_buffer = std::move(buffer);
@@ -523,6 +495,18 @@ void ExatnVisitor<TNQVM_COMPLEX_TYPE>::initialize(std::shared_ptr<AcceleratorBuf
     m_maxQubit = options.get<int>("max-qubit");
     xacc::info("Set max qubit to " + m_maxQubit);
   }
+  m_maxConcurrentSlices = DEFAULT_MAX_CONCURRENT_SLICES;
+  if (options.keyExists<int>("max-concurrent-slices"))
+  {
+    m_maxConcurrentSlices = std::max(1, options.get<int>("max-concurrent-slices"));
+  }
+  {
+    // Contraction plans are always reused by networks of the same topology (e.g. slices, shots),
+    // and persisted across runs if a cache directory is provided.
+    const std::string optimizerName = options.stringExists("exatn-contract-seq-optimizer") ? options.getString("exatn-contract-seq-optimizer") : "metis";
+    const std::string cacheDir = options.stringExists("exatn-contract-seq-cache-dir") ? options.getString("exatn-contract-seq-cache-dir") : "";
+    m_contractSeqCache = std::make_shared<ContractionSeqCache>(cacheDir, optimizerName);
+  }
   // Create the qubit register tensor
   for (int i = 0; i < m_buffer->size(); ++i) {
     const bool created = exatn::createTensor(
@@ -588,8 +572,10 @@ void ExatnVisitor<TNQVM_COMPLEX_TYPE>::evaluateNetwork() {
   if (m_buffer->size() <= MAX_NUMBER_QUBITS_FOR_STATE_VEC){
     TNQVM_TELEMETRY_ZONE("exatn::evaluateSync", __FILE__, __LINE__);
     m_tensorNetwork.rename(m_kernelName);
+    applyContractionSeqCache(m_tensorNetwork);
     const bool evaluated = exatn::evaluateSync(m_tensorNetwork);
     assert(evaluated);
+    tnqvm::recordNetworkMetrics(m_tensorNetwork, sizeof(TNQVM_COMPLEX_TYPE));
     // Synchronize:
     exatn::sync();
     m_hasEvaluated = true;
@@ -597,6 +583,18 @@ void ExatnVisitor<TNQVM_COMPLEX_TYPE>::evaluateNetwork() {
   }
 }
 
+template<typename TNQVM_COMPLEX_TYPE>
+bool ExatnVisitor<TNQVM_COMPLEX_TYPE>::applyContractionSeqCache(TensorNetwork& io_network, ContractionSeqCache::Cost* out_cost) const {
+  if (m_contractSeqCache) {
+    TNQVM_TELEMETRY_ZONE(__FUNCTION__, __FILE__, __LINE__);
+    const bool cacheHit = m_contractSeqCache->apply(io_network, out_cost);
+    MetricsRegistry::get_instance().increment(cacheHit ? "exatn::contract-seq-cache:hits" : "exatn::contract-seq-cache:misses");
+    xacc::info("Contraction sequence of '" + io_network.getName() + "': " + (cacheHit ? "loaded from cache." : "optimized and cached."));
+    return cacheHit;
+  }
+  return false;
+}
+
 template<typename TNQVM_COMPLEX_TYPE>
 void ExatnVisitor<TNQVM_COMPLEX_TYPE>::resetExaTN() {
   TNQVM_TELEMETRY_ZONE(__FUNCTION__, __FILE__, __LINE__);
@@ -619,6 +617,12 @@ void ExatnVisitor<TNQVM_COMPLEX_TYPE>::resetExaTN() {
     }
   }
 
+  // State tensor carried over from a previous circuit segment (a root tensor).
+  if (!m_stateTensorName.empty()) {
+    tensorList.emplace(m_stateTensorName);
+    m_stateTensorName.clear();
+  }
+
   for (const auto &tensorName : tensorList) {
     const bool destroyed = exatn::destroyTensor(tensorName);
     assert(destroyed);
@@ -638,22 +642,31 @@ void ExatnVisitor<TNQVM_COMPLEX_TYPE>::resetNetwork() {
 
   // We must have evaluated the tensor network.
   assert(m_hasEvaluated);
-  const auto stateVec = retrieveStateVector();
-  // Re-initialize ExaTN
-  resetExaTN();
-  // The new qubit register tensor name will have name "RESET_"
-  const std::string resetTensorName = "RESET_";
-  // The qubit register tensor shape is {2, 2, 2, ...}, 1 leg for each qubit
-  std::vector<int> qubitRegResetTensorShape(m_buffer->size(), 2);
-  const bool created =
-      exatn::createTensor(resetTensorName, getExatnElementType(),
-                          qubitRegResetTensorShape);
-  assert(created);
-  // Initialize the tensor body with the state vector from the previous
-  // evaluation.
-  const bool initialized =
-      exatn::initTensorData(resetTensorName, std::move(stateVec));
-  assert(initialized);
+  // Incremental contraction: the evaluated (root) tensor stays in ExaTN and
+  // becomes the initial state of the next circuit segment, i.e. the circuit
+  // prefix is never contracted again and the state doesn't go through the host.
+  const auto stateTensor = m_tensorNetwork.getTensor(0);
+  // Destroy the input state of the segment that has just been evaluated
+  // (qubit register tensors or the state tensor from the previous segment).
+  // Gate tensors are kept for reuse in the next segments.
+  std::unordered_set<std::string> inputStateTensors;
+  for (auto iter = m_tensorNetwork.cbegin(); iter != m_tensorNetwork.cend();
+       ++iter) {
+    if (iter->first == 0) {
+      continue;
+    }
+    const auto &tensorName = iter->second.getTensor()->getName();
+    if (m_gateTensorBodies.find(tensorName) == m_gateTensorBodies.end()) {
+      inputStateTensors.emplace(tensorName);
+    }
+  }
+  for (const auto &tensorName : inputStateTensors) {
+    const bool destroyed = exatn::destroyTensor(tensorName);
+    assert(destroyed);
+  }
+  m_stateTensorName = stateTensor->getName();
+  // The gate sequence cannot be inverted from the qubit register anymore.
+  m_appendedGateTensors.clear();
   // Create a new tensor network
   m_tensorNetwork = TensorNetwork();
   // Reset counter
@@ -661,7 +674,7 @@ void ExatnVisitor<TNQVM_COMPLEX_TYPE>::resetNetwork() {
 
   // Use the root tensor from previous evaluation as the initial tensor
   m_tensorNetwork.appendTensor(
-      m_tensorIdCounter, exatn::getTensor(resetTensorName),
+      m_tensorIdCounter, stateTensor,
       std::vector<std::pair<unsigned int, unsigned int>>{});
   // Reset the evaluation flag after initialization.
   m_hasEvaluated = false;
@@ -795,19 +808,35 @@ void ExatnVisitor<TNQVM_COMPLEX_TYPE>::finalize() {
 
   if (m_buffer->size() > MAX_NUMBER_QUBITS_FOR_STATE_VEC && !m_measureQbIdx.empty() && m_shots > 0 && !m_hasEvaluated)
   {
-    std::cout << "Simulating bit string by tensor contraction and projection \n";
-    for (int i = 0; i < m_shots; ++i)
+    const std::string samplingMethod = options.stringExists("sampling-method") ? options.getString("sampling-method") : "exact";
+    if (samplingMethod != "exact" && samplingMethod != "frugal-rejection")
     {
-      const auto convertToBitString = [](const std::vector<uint8_t>& in_bitVec){
-          std::string result;
-          for (const auto& bit : in_bitVec)
-          {
-              result.append(std::to_string(bit));
-          }
-          return result;
-      };
+      xacc::error("Unknown sampling method '" + samplingMethod + "'. Valid values: 'exact', 'frugal-rejection'.");
+    }
+    if (samplingMethod == "frugal-rejection")
+    {
+      xacc::info("Sampling bit strings by frugal rejection of amplitude batches.");
+      for (const auto& sample : generateFrugalSamples(m_tensorNetwork, m_measureQbIdx, m_shots))
+      {
+        m_buffer->appendMeasurement(sample);
+      }
+    }
+    else
+    {
+      std::cout << "Simulating bit string by tensor contraction and projection \n";
+      for (int i = 0; i < m_shots; ++i)
+      {
+        const auto convertToBitString = [](const std::vector<uint8_t>& in_bitVec){
+            std::string result;
+            for (const auto& bit : in_bitVec)
+            {
+                result.append(std::to_string(bit));
+            }
+            return result;
+        };
 
-      m_buffer->appendMeasurement(convertToBitString(generateMeasureSample(m_tensorNetwork, m_measureQbIdx)));
+        m_buffer->appendMeasurement(convertToBitString(generateMeasureSample(m_tensorNetwork, m_measureQbIdx)));
+      }
     }
   }
   else
@@ -978,11 +1007,10 @@ void ExatnVisitor<TNQVM_COMPLEX_TYPE>::visit(Measure &in_MeasureGate) {
     return;
   }
   // When we visit a measure gate, evaluate the current tensor network (up to
-  // this measurement) Note: currently, we cannot do gate operations post
-  // measurement yet (i.e. multiple evaluateNetwork() calls). Multiple
-  // measurement ops at the end is supported, i.e. can measure the entire qubit
-  // register.
-  // TODO: reset the tensor network and continue appending gate tensors.
+  // this measurement). Multiple measurement ops at the end is supported, i.e.
+  // can measure the entire qubit register. If more gates are appended after
+  // this, the evaluated state is the initial tensor of the next segment
+  // (see resetNetwork()).
   if (!m_hasEvaluated) {
     // If this is the first measure gate that we visit,
     // i.e. the tensor network hasn't been evaluate, do it now.
@@ -1024,51 +1052,9 @@ void ExatnVisitor<TNQVM_COMPLEX_TYPE>::appendGateTensor(const xacc::Instruction
   // If the tensor data for this gate hasn't been initialized before,
   // then initialize it.
   if (m_gateTensorBodies.find(uniqueGateName) == m_gateTensorBodies.end()) {
-    const auto gateMatrixRaw= GetGateMatrix<GateType>(in_params...);
-    std::vector<std::vector<TNQVM_COMPLEX_TYPE>> gateMatrix;
-    for (auto& row : gateMatrixRaw)
-    {
-      std::vector<TNQVM_COMPLEX_TYPE> rowConverted(row.begin(), row.end());
-      gateMatrix.emplace_back(std::move(rowConverted));
-    }
-    m_gateTensorBodies[uniqueGateName] = flattenGateMatrix(gateMatrix);
-    // Currently, we only support 2-qubit gates.
-    assert(in_gateInstruction.nRequiredBits() > 0 &&
-           in_gateInstruction.nRequiredBits() <= 2);
-    const auto gateTensorShape =
-        (in_gateInstruction.nRequiredBits() == 1 ? TensorShape{2, 2}
-                                                 : TensorShape{2, 2, 2, 2});
-    // Create the tensor
-    const bool created = exatn::createTensor(
-        uniqueGateName, getExatnElementType(), gateTensorShape);
-    assert(created);
-    // Init tensor body data
-    exatn::initTensorData(uniqueGateName, flattenGateMatrix(gateMatrix));
-    // Register tensor isometry:
-    // For rank-2 gate isometric leg groups are: {0}, {1}.
-    // For rank-4 gate isometric leg groups are: {0,1}, {2,3}.
-    if (in_gateInstruction.nRequiredBits() == 1) {
-      const bool registered =
-          exatn::registerTensorIsometry(uniqueGateName, {0}, {1});
-      assert(registered);
-    } else if (in_gateInstruction.nRequiredBits() == 2) {
-      const bool registered =
-          exatn::registerTensorIsometry(uniqueGateName, {0, 1}, {2, 3});
-      assert(registered);
-    }
-  }
-
-  // Helper to create unique tensor names in the format
-  // <GateTypeName>_<Counter>, e.g. H2, CNOT5, etc. Note: this is different from
-  // the gate instance unique name which is referencing *unique* gate matrices.
-  // Multiple tensors can just refer to the same tensor body,
-  // for example, all H_k (Hadamard gates) in the circuit will all refer to a
-  // single *H* tensor body data.
-  const auto generateTensorName = [&]() -> std::string {
-    return GetGateName(GateType) + "_" + std::to_string(m_tensorIdCounter);
-  };
-
-  m_tensorIdCounter++;
+    createGateTensor(uniqueGateName, GetGateMatrix<GateType>(in_params...),
+                     in_gateInstruction.nRequiredBits());
+  }
 
   // Because the qubit location and gate pairing are of different integer types,
   // we need to reconstruct the qubit vector.
@@ -1086,31 +1072,93 @@ void ExatnVisitor<TNQVM_COMPLEX_TYPE>::appendGateTensor(const xacc::Instruction
     std::reverse(gatePairing.begin(), gatePairing.end());
   }
 
+  appendGateTensorToNetwork(uniqueGateName, gateName, gatePairing);
+}
+
+template <typename TNQVM_COMPLEX_TYPE>
+void ExatnVisitor<TNQVM_COMPLEX_TYPE>::createGateTensor(
+    const std::string &in_uniqueGateName,
+    const std::vector<std::vector<std::complex<double>>> &in_gateMatrix,
+    size_t in_nbQubits) {
+  std::vector<std::vector<TNQVM_COMPLEX_TYPE>> gateMatrix;
+  for (auto &row : in_gateMatrix) {
+    std::vector<TNQVM_COMPLEX_TYPE> rowConverted(row.begin(), row.end());
+    gateMatrix.emplace_back(std::move(rowConverted));
+  }
+  m_gateTensorBodies[in_uniqueGateName] = flattenGateMatrix(gateMatrix);
+  // Currently, we only support 2-qubit gates.
+  assert(in_nbQubits > 0 && in_nbQubits <= 2);
+  const auto gateTensorShape =
+      (in_nbQubits == 1 ? TensorShape{2, 2} : TensorShape{2, 2, 2, 2});
+  // Create the tensor
+  const bool created = exatn::createTensor(
+      in_uniqueGateName, getExatnElementType(), gateTensorShape);
+  assert(created);
+  // Init tensor body data
+  exatn::initTensorData(in_uniqueGateName, flattenGateMatrix(gateMatrix));
+  // Register tensor isometry:
+  // For rank-2 gate isometric leg groups are: {0}, {1}.
+  // For rank-4 gate isometric leg groups are: {0,1}, {2,3}.
+  if (in_nbQubits == 1) {
+    const bool registered =
+        exatn::registerTensorIsometry(in_uniqueGateName, {0}, {1});
+    assert(registered);
+  } else if (in_nbQubits == 2) {
+    const bool registered =
+        exatn::registerTensorIsometry(in_uniqueGateName, {0, 1}, {2, 3});
+    assert(registered);
+  }
+}
+
+template <typename TNQVM_COMPLEX_TYPE>
+void ExatnVisitor<TNQVM_COMPLEX_TYPE>::appendGateTensorToNetwork(
+    const std::string &in_uniqueGateName, const std::string &in_gateName,
+    const std::vector<unsigned int> &in_gatePairing) {
+  m_tensorIdCounter++;
+
   if (m_isAppendingCircuitGates) {
     // Append the gate tensor to the tracking list to apply inverse
     m_appendedGateTensors.emplace_back(
-        std::make_pair(uniqueGateName, gatePairing));
+        std::make_pair(in_uniqueGateName, in_gatePairing));
   }
 
   // Append the tensor for this gate to the network
   const bool appended = m_tensorNetwork.appendTensorGate(
       m_tensorIdCounter,
       // Get the gate tensor data which must have been initialized.
-      exatn::getTensor(uniqueGateName),
+      exatn::getTensor(in_uniqueGateName),
       // which qubits that the gate is acting on
-      gatePairing);
+      in_gatePairing);
   if (!appended) {
-    const std::string gatePairingString = [&gatePairing](){
+    const std::string gatePairingString = [&in_gatePairing](){
       std::stringstream ss;
       ss << "{";
-      for (const auto& pairIdx : gatePairing) {
+      for (const auto& pairIdx : in_gatePairing) {
         ss << pairIdx << ",";
       }
       ss << "}";
       return ss.str();
     }();
-    xacc::error("Failed to append tensor for gate " + in_gateInstruction.name() + ", pairing = " + gatePairingString);
+    xacc::error("Failed to append tensor for gate " + in_gateName + ", pairing = " + gatePairingString);
+  }
+}
+
+template <typename TNQVM_COMPLEX_TYPE>
+void ExatnVisitor<TNQVM_COMPLEX_TYPE>::applyFusedGate(
+    const std::vector<size_t> &in_bits,
+    const std::vector<std::vector<std::complex<double>>> &in_matrix) {
+  TNQVM_TELEMETRY_ZONE(__FUNCTION__, __FILE__, __LINE__);
+  if (m_hasEvaluated) {
+    resetNetwork();
   }
+  // Each fused gate has its own tensor (the matrix is unlikely to be reused).
+  const std::string uniqueGateName =
+      "FUSED_" + std::to_string(m_fusedGateCounter++);
+  createGateTensor(uniqueGateName, in_matrix, in_bits.size());
+  // Two-qubit fused matrices have bits[0] as the MSB, i.e. same leg pairing
+  // as control gates.
+  std::vector<unsigned int> gatePairing(in_bits.rbegin(), in_bits.rend());
+  appendGateTensorToNetwork(uniqueGateName, "FUSED", gatePairing);
 }
 
 template<typename TNQVM_COMPLEX_TYPE>
@@ -1192,6 +1240,7 @@ TNQVM_COMPLEX_TYPE ExatnVisitor<TNQVM_COMPLEX_TYPE>::evaluateTerm(
 
     if (exatn::evaluateSync(m_tensorNetwork)) {
       exatn::sync();
+      tnqvm::recordNetworkMetrics(m_tensorNetwork, sizeof(TNQVM_COMPLEX_TYPE));
       auto talsh_tensor =
           exatn::getLocalTensor(m_tensorNetwork.getTensor(0)->getName());
       assert(talsh_tensor->getVolume() == 1);
@@ -1296,6 +1345,7 @@ std::vector<TNQVM_COMPLEX_TYPE> ExatnVisitor<TNQVM_COMPLEX_TYPE>::getReducedDens
 
     if (exatn::evaluateSync(combinedNetwork)) {
       exatn::sync();
+      tnqvm::recordNetworkMetrics(combinedNetwork, sizeof(TNQVM_COMPLEX_TYPE));
       auto talsh_tensor =
           exatn::getLocalTensor(combinedNetwork.getTensor(0)->getName());
       const auto tensorVolume = talsh_tensor->getVolume();
@@ -1429,8 +1479,10 @@ std::vector<uint8_t> ExatnVisitor<TNQVM_COMPLEX_TYPE>::getMeasureSample(
       // Evaluate
       {
         TNQVM_TELEMETRY_ZONE("exatn::evaluateSync", __FILE__, __LINE__);
+        applyContractionSeqCache(combinedNetwork);
         if (exatn::evaluateSync(combinedNetwork)) {
           exatn::sync();
+          tnqvm::recordNetworkMetrics(combinedNetwork, sizeof(TNQVM_COMPLEX_TYPE));
           auto talsh_tensor =
               exatn::getLocalTensor(combinedNetwork.getTensor(0)->getName());
           const auto tensorVolume = talsh_tensor->getVolume();
@@ -1512,36 +1564,7 @@ const double ExatnVisitor<TNQVM_COMPLEX_TYPE>::getExpectationValueZ(
   const std::string resetTensorName = "RESET_";
   if (!m_hasEvaluated)
   {
-    {
-      TNQVM_TELEMETRY_ZONE("exatn::evaluateSync", __FILE__, __LINE__);
-      const bool evaluated = exatn::evaluateSync(m_tensorNetwork);
-      assert(evaluated);
-      // Synchronize:
-      exatn::sync();
-      m_cacheStateVec = retrieveStateVector();
-    }
-
-    // State vector after the base ansatz
-    assert(m_cacheStateVec.size() == (1ULL << m_buffer->size()));
-
-    // The qubit register tensor shape is {2, 2, 2, ...}, 1 leg for each qubit
-    std::vector<int> qubitRegResetTensorShape(m_buffer->size(), 2);
-    const bool created = exatn::createTensor(resetTensorName, getExatnElementType(), qubitRegResetTensorShape);
-    assert(created);
-    // Initialize the tensor body with the state vector from the previous
-    // evaluation.
-    const bool initialized = exatn::initTensorData(resetTensorName, m_cacheStateVec);
-    assert(initialized);
-    for (auto iter = m_qubitRegTensor.cbegin(); iter != m_qubitRegTensor.cend(); ++iter)
-    {
-      const auto& tensorName = iter->second.getTensor()->getName();
-      // Not a root tensor
-      if (!tensorName.empty() && tensorName[0] != '_')
-      {
-        const bool destroyed = exatn::destroyTensorSync(tensorName);
-        assert(destroyed);
-      }
-    }
+    cacheAnsatzState();
   }
 
   // Create a new tensor network
@@ -1579,6 +1602,7 @@ const double ExatnVisitor<TNQVM_COMPLEX_TYPE>::getExpectationValueZ(
     TNQVM_TELEMETRY_ZONE("exatn::evaluateSync", __FILE__, __LINE__);
     const bool evaluated = exatn::evaluateSync(m_tensorNetwork);
     assert(evaluated);
+    tnqvm::recordNetworkMetrics(m_tensorNetwork, sizeof(TNQVM_COMPLEX_TYPE));
   }
   m_hasEvaluated = true;
   const double exp_val_z = (nbBasisChangeInsts > 0) ? calcExpValueZ(m_measureQbIdx, retrieveStateVector()) :  calcExpValueZ(m_measureQbIdx, m_cacheStateVec);
@@ -1587,6 +1611,110 @@ const double ExatnVisitor<TNQVM_COMPLEX_TYPE>::getExpectationValueZ(
   return exp_val_z;
 }
 
+template<typename TNQVM_COMPLEX_TYPE>
+std::vector<double> ExatnVisitor<TNQVM_COMPLEX_TYPE>::getExpectationValueZBatch(
+    const std::vector<std::shared_ptr<CompositeInstruction>> &in_functions) {
+  TNQVM_TELEMETRY_ZONE(__FUNCTION__, __FILE__, __LINE__);
+  if (!m_buffer) {
+    xacc::error("Please initialize the visitor backend before calling "
+                "getExpectationValueZBatch()!");
+    return {};
+  }
+  // Cannot cache the wavefunction: evaluate term-by-term (slicing).
+  if (m_buffer->size() > m_maxQubit) {
+    return TNQVMVisitor::getExpectationValueZBatch(in_functions);
+  }
+
+  std::vector<ObservedBasis> terms(in_functions.size());
+  for (size_t i = 0; i < in_functions.size(); ++i) {
+    if (!decomposeObservedCircuit(in_functions[i], terms[i])) {
+      // Not a product of single-qubit basis changes:
+      // contract each observable sub-circuit instead.
+      return TNQVMVisitor::getExpectationValueZBatch(in_functions);
+    }
+  }
+  const auto groups = groupObservedBases(terms);
+
+  if (!m_hasEvaluated) {
+    cacheAnsatzState();
+  }
+  assert(m_cacheStateVec.size() == (1ULL << m_buffer->size()));
+
+  std::vector<double> result(in_functions.size(), 0.0);
+  // Small state vectors: evaluate the groups concurrently (one state vector copy per group in flight).
+  // Otherwise, one group at a time since the gate kernels and the reduction are already multi-threaded.
+  const bool concurrentGroups = static_cast<int64_t>(m_cacheStateVec.size()) < PARALLEL_STATE_VECTOR_SIZE;
+#pragma omp parallel for schedule(dynamic) if (concurrentGroups && groups.size() > 1)
+  for (int64_t groupId = 0; groupId < static_cast<int64_t>(groups.size()); ++groupId) {
+    const auto &group = groups[groupId];
+    std::vector<uint64_t> parityMasks;
+    parityMasks.reserve(group.termIds.size());
+    for (const auto &termId : group.termIds) {
+      parityMasks.emplace_back(ParityMask(terms[termId].measuredQubits));
+    }
+
+    std::vector<double> expVals;
+    if (group.basisChanges.empty()) {
+      // Z basis: use the cached state vector as-is.
+      expVals = CalcExpValueZBatch(m_cacheStateVec.data(), m_cacheStateVec.size(), parityMasks);
+    } else {
+      auto stateVec = m_cacheStateVec;
+      for (const auto &basisChange : group.basisChanges) {
+        for (const auto &gateMatrix : basisChange.second) {
+          ApplySingleQubitGate(stateVec, basisChange.first, gateMatrix);
+        }
+      }
+      expVals = CalcExpValueZBatch(stateVec.data(), stateVec.size(), parityMasks);
+    }
+
+    for (size_t i = 0; i < group.termIds.size(); ++i) {
+      result[group.termIds[i]] = expVals[i];
+    }
+  }
+
+  return result;
+}
+
+template<typename TNQVM_COMPLEX_TYPE>
+void ExatnVisitor<TNQVM_COMPLEX_TYPE>::cacheAnsatzState() {
+  TNQVM_TELEMETRY_ZONE(__FUNCTION__, __FILE__, __LINE__);
+  // The new qubit register tensor name will have name "RESET_"
+  const std::string resetTensorName = "RESET_";
+  {
+    TNQVM_TELEMETRY_ZONE("exatn::evaluateSync", __FILE__, __LINE__);
+    applyContractionSeqCache(m_tensorNetwork);
+    const bool evaluated = exatn::evaluateSync(m_tensorNetwork);
+    assert(evaluated);
+    tnqvm::recordNetworkMetrics(m_tensorNetwork, sizeof(TNQVM_COMPLEX_TYPE));
+    // Synchronize:
+    exatn::sync();
+    m_cacheStateVec = retrieveStateVector();
+  }
+
+  // State vector after the base ansatz
+  assert(m_cacheStateVec.size() == (1ULL << m_buffer->size()));
+
+  // The qubit register tensor shape is {2, 2, 2, ...}, 1 leg for each qubit
+  std::vector<int> qubitRegResetTensorShape(m_buffer->size(), 2);
+  const bool created = exatn::createTensor(resetTensorName, getExatnElementType(), qubitRegResetTensorShape);
+  assert(created);
+  // Initialize the tensor body with the state vector from the previous
+  // evaluation.
+  const bool initialized = exatn::initTensorData(resetTensorName, m_cacheStateVec);
+  assert(initialized);
+  for (auto iter = m_qubitRegTensor.cbegin(); iter != m_qubitRegTensor.cend(); ++iter)
+  {
+    const auto& tensorName = iter->second.getTensor()->getName();
+    // Not a root tensor
+    if (!tensorName.empty() && tensorName[0] != '_')
+    {
+      const bool destroyed = exatn::destroyTensorSync(tensorName);
+      assert(destroyed);
+    }
+  }
+  m_hasEvaluated = true;
+}
+
 template <typename TNQVM_COMPLEX_TYPE>
 double ExatnVisitor<TNQVM_COMPLEX_TYPE>::getExpectationValueZBySlicing(
     std::shared_ptr<CompositeInstruction> in_function) {
@@ -1620,28 +1748,79 @@ double ExatnVisitor<TNQVM_COMPLEX_TYPE>::getExpectationValueZBySlicing() {
   // compute partial expectations for all slices then reduce.
   // Loop to be parallelized
   if (getNumMpiProcs() <= 1) {
-    std::vector<double> partialExpectationValues(nbProjectedPaths);
-    for (int i = 0; i < nbProjectedPaths; ++i) {
-      bool evenParity = true;
-      // Open legs: 0-m_maxQubit
-      std::vector<int> bitString(m_maxQubit, -1);
-      for (int64_t bitIdx = 0; bitIdx < nbProjectedQubits; ++bitIdx) {
-        const int globalQid = bitIdx + m_maxQubit;
-        const int64_t bitMask = 1ULL << bitIdx;
-        if ((i & bitMask) == bitMask) {
-          bitString.emplace_back(1);
-          if (xacc::container::contains(m_measureQbIdx, globalQid)) {
-            // Flip even parity flag
-            evenParity = !evenParity;
+    // Slices are independent: keep up to m_maxConcurrentSlices contractions
+    // in flight in the ExaTN runtime, and submit a new one as soon as any
+    // of them completes. To keep the same memory footprint as one slice,
+    // each doubling of the concurrency projects one more qubit.
+    size_t concurrencyLog2 = 0;
+    while ((2ULL << concurrencyLog2) <= m_maxConcurrentSlices &&
+           concurrencyLog2 + 1 < m_maxQubit) {
+      ++concurrencyLog2;
+    }
+    const size_t nbOpenQubits = m_maxQubit - concurrencyLog2;
+    const size_t nbSliceProjectedQubits = m_buffer->size() - nbOpenQubits;
+    const int64_t nbSlices = (1ULL << nbSliceProjectedQubits);
+    const size_t nbSlots = std::min<int64_t>(1ULL << concurrencyLog2, nbSlices);
+
+    // Partial exp-val of each slice, reduced in slice order (deterministic).
+    std::vector<double> partialExpectationValues(nbSlices);
+    std::vector<bool> evenParities(nbSlices, true);
+    // In-flight slice contractions, each one uses a slot (tensor name suffix).
+    struct InFlightSlice {
+      int64_t sliceIdx;
+      size_t slot;
+      WaveFuncSliceContraction contraction;
+    };
+    std::vector<InFlightSlice> inFlight;
+    std::vector<size_t> freeSlots;
+    for (size_t slot = nbSlots; slot > 0; --slot) {
+      freeSlots.emplace_back(slot - 1);
+    }
+    int64_t nextSlice = 0;
+    while (nextSlice < nbSlices || !inFlight.empty()) {
+      // Fill all free slots
+      while (nextSlice < nbSlices && !freeSlots.empty()) {
+        // Open legs: 0-nbOpenQubits
+        std::vector<int> bitString(nbOpenQubits, -1);
+        for (int64_t bitIdx = 0; bitIdx < nbSliceProjectedQubits; ++bitIdx) {
+          const int globalQid = bitIdx + nbOpenQubits;
+          const int64_t bitMask = 1ULL << bitIdx;
+          if ((nextSlice & bitMask) == bitMask) {
+            bitString.emplace_back(1);
+            if (xacc::container::contains(m_measureQbIdx, globalQid)) {
+              // Flip even parity flag
+              evenParities[nextSlice] = !evenParities[nextSlice];
+            }
+          } else {
+            bitString.emplace_back(0);
           }
-        } else {
-          bitString.emplace_back(0);
+        }
+        const size_t slot = freeSlots.back();
+        freeSlots.pop_back();
+        inFlight.emplace_back(InFlightSlice{
+            nextSlice, slot,
+            submitWaveFuncSlice(m_tensorNetwork, bitString,
+                                exatn::getDefaultProcessGroup(),
+                                "_S" + std::to_string(slot))});
+        ++nextSlice;
+      }
+
+      // Collect a completed slice (or wait for the oldest one).
+      size_t doneIdx = 0;
+      for (size_t i = 0; i < inFlight.size(); ++i) {
+        if (isWaveFuncSliceReady(inFlight[i].contraction)) {
+          doneIdx = i;
+          break;
         }
       }
-      std::vector<TNQVM_COMPLEX_TYPE> waveFuncSlice = computeWaveFuncSlice(
-          m_tensorNetwork, bitString, exatn::getDefaultProcessGroup());
+      const int64_t sliceIdx = inFlight[doneIdx].sliceIdx;
+      std::vector<TNQVM_COMPLEX_TYPE> waveFuncSlice =
+          collectWaveFuncSlice(inFlight[doneIdx].contraction);
       const double exp_val_z = calcExpValueZ(m_measureQbIdx, waveFuncSlice);
-      partialExpectationValues[i] = evenParity ? exp_val_z : -exp_val_z;
+      partialExpectationValues[sliceIdx] =
+          evenParities[sliceIdx] ? exp_val_z : -exp_val_z;
+      freeSlots.emplace_back(inFlight[doneIdx].slot);
+      inFlight.erase(inFlight.begin() + doneIdx);
     }
     const auto finalExpVal = std::accumulate(
         partialExpectationValues.begin(), partialExpectationValues.end(), 0.0);
@@ -1901,27 +2080,28 @@ std::vector<uint8_t> ExatnVisitor<TNQVM_COMPLEX_TYPE>::generateMeasureSample(con
 
         const bool isoCollapsed = combinedNetwork.collapseIsometries();
         {
-          // DEBUG:
+          // The marginal network of the k-th measured qubit has the same topology for every shot
+          // (only the collapse tensor data differ): its plan is optimized once and reused.
+          ContractionSeqCache::Cost planCost;
           {
-            const std::string optimizerName = options.stringExists("exatn-contract-seq-optimizer") ? options.getString("exatn-contract-seq-optimizer") : "metis";
             const auto startOpt = std::chrono::system_clock::now();
-            combinedNetwork.getOperationList(optimizerName);
+            const bool cacheHit = applyContractionSeqCache(combinedNetwork, &planCost);
             const auto endOpt = std::chrono::system_clock::now();
-              std::cout << "getOperationList() took: "
-              << std::chrono::duration_cast<std::chrono::milliseconds>(endOpt - startOpt).count()
-              << " ms\n";
+            xacc::info("Contraction plan (" + std::string(cacheHit ? "cached" : "optimized") + ") took: " +
+                       std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(endOpt - startOpt).count()) + " ms");
           }
 
-          const double flops = combinedNetwork.getFMAFlops();
-          const double intermediatesVolume = combinedNetwork.getMaxIntermediatePresenceVolume();
+          const double flops = planCost.flops >= 0.0 ? planCost.flops : combinedNetwork.getFMAFlops();
+          const double intermediatesVolume = planCost.maxIntermediateVolume >= 0.0 ? planCost.maxIntermediateVolume : combinedNetwork.getMaxIntermediatePresenceVolume();
           assert(intermediatesVolume >= 0.0);
           const int64_t sizeInBytes = static_cast<int64_t>(intermediatesVolume * sizeof(TNQVM_COMPLEX_TYPE));
-          std::cout << "Combined circuit requires " << flops << " FMA flops and " << sizeInBytes << " bytes\n";
+          xacc::info("Combined circuit requires " + std::to_string(flops) + " FMA flops and " + std::to_string(sizeInBytes) + " bytes");
 
-          if (sizeInBytes > MAX_TALSH_MEMORY_BUFFER_SIZE_BYTES)
+          const int64_t hostBufferSize = ExatnRuntime::get().getHostBufferSize();
+          if (sizeInBytes > hostBufferSize)
           {
             xacc::error("ExaTN intermediate tensors require more memory than max allowed of " +
-              std::to_string(MAX_TALSH_MEMORY_BUFFER_SIZE_BYTES) + " bytes.");
+              std::to_string(hostBufferSize) + " bytes.");
           }
         }
 
@@ -1931,6 +2111,7 @@ std::vector<uint8_t> ExatnVisitor<TNQVM_COMPLEX_TYPE>::generateMeasureSample(con
           if (exatn::evaluateSync(combinedNetwork))
           {
               exatn::sync();
+              tnqvm::recordNetworkMetrics(combinedNetwork, sizeof(TNQVM_COMPLEX_TYPE));
               auto talsh_tensor = exatn::getLocalTensor(combinedNetwork.getTensor(0)->getName());
               const auto tensorVolume = talsh_tensor->getVolume();
               // Single qubit density matrix
@@ -1984,6 +2165,106 @@ std::vector<uint8_t> ExatnVisitor<TNQVM_COMPLEX_TYPE>::generateMeasureSample(con
     return resultBitString;
 }
 
+template<typename TNQVM_COMPLEX_TYPE>
+std::vector<std::string> ExatnVisitor<TNQVM_COMPLEX_TYPE>::generateFrugalSamples(const TensorNetwork& in_tensorNetwork, const std::vector<int>& in_qubitIdx, int in_nbShots)
+{
+  TNQVM_TELEMETRY_ZONE(__FUNCTION__, __FILE__, __LINE__);
+  const int nbQubits = m_buffer->size();
+  int nbOpenQubits = options.keyExists<int>("sampling-open-qubits") ? options.get<int>("sampling-open-qubits") : 10;
+  nbOpenQubits = std::max(1, std::min<int>({nbOpenQubits, static_cast<int>(in_qubitIdx.size()), static_cast<int>(m_maxQubit)}));
+  const double rejectionFactor = options.keyExists<double>("frugal-rejection-factor") ? options.get<double>("frugal-rejection-factor") : 10.0;
+  if (rejectionFactor <= 0.0)
+  {
+    xacc::error("Invalid 'frugal-rejection-factor' value: must be positive.");
+  }
+
+  // Open legs: the first k measured qubits, each batch gives the amplitudes of
+  // 2^k bitstrings which only differ in these qubits.
+  std::vector<int> openQubits(in_qubitIdx.begin(), in_qubitIdx.begin() + nbOpenQubits);
+  std::sort(openQubits.begin(), openQubits.end());
+  openQubits.erase(std::unique(openQubits.begin(), openQubits.end()), openQubits.end());
+  const uint64_t batchSize = 1ULL << openQubits.size();
+  // Bit position (in the batch index) of each qubit: the slice is column-major,
+  // i.e. the lowest open qubit is the fastest index.
+  std::vector<int> batchBitPos(nbQubits, -1);
+  for (size_t i = 0; i < openQubits.size(); ++i)
+  {
+    batchBitPos[openQubits[i]] = i;
+  }
+
+  // Expected acceptance rate is ~1/M for Porter-Thomas distributed outputs:
+  // beyond that (e.g. structured circuits whose amplitudes are mostly zero),
+  // fall back to exact sampling for the missing shots.
+  const size_t maxNbBatches = 16 + 4 * static_cast<size_t>(std::ceil(in_nbShots * rejectionFactor / batchSize));
+  std::vector<std::string> samples;
+  samples.reserve(in_nbShots);
+  size_t nbBatches = 0;
+  auto& randEngine = randomEngine::get_instance();
+  while (samples.size() < static_cast<size_t>(in_nbShots) && nbBatches < maxNbBatches)
+  {
+    ++nbBatches;
+    // Project the other qubits to uniformly random bits (the unmeasured ones are marginalized that way).
+    std::vector<int> bitString(nbQubits, -1);
+    const auto fixedBitProbs = randEngine.randProbs(nbQubits);
+    for (int i = 0; i < nbQubits; ++i)
+    {
+      if (batchBitPos[i] < 0)
+      {
+        bitString[i] = fixedBitProbs[i] < 0.5 ? 0 : 1;
+      }
+    }
+
+    const auto amplitudes = computeWaveFuncSlice(in_tensorNetwork, bitString, exatn::getDefaultProcessGroup());
+    assert(amplitudes.size() == batchSize);
+    // Candidates are visited in random order so that the shots accepted from the last batch are unbiased.
+    std::vector<uint64_t> candidates(batchSize);
+    std::iota(candidates.begin(), candidates.end(), 0);
+    const auto shuffleProbs = randEngine.randProbs(batchSize);
+    for (uint64_t i = batchSize - 1; i > 0; --i)
+    {
+      std::swap(candidates[i], candidates[std::min<uint64_t>(i, static_cast<uint64_t>(shuffleProbs[i] * (i + 1)))]);
+    }
+    const auto acceptProbs = randEngine.randProbs(batchSize);
+    for (uint64_t i = 0; i < batchSize && samples.size() < static_cast<size_t>(in_nbShots); ++i)
+    {
+      const uint64_t idx = candidates[i];
+      // Accept with probability min(1, 2^n * p(x) / M)
+      const double scaledProb = std::ldexp(std::norm(amplitudes[idx]), nbQubits) / rejectionFactor;
+      if (acceptProbs[i] < scaledProb)
+      {
+        std::string bitStr(in_qubitIdx.size(), '0');
+        for (size_t j = 0; j < in_qubitIdx.size(); ++j)
+        {
+          const int qubitIdx = in_qubitIdx[j];
+          const int bitVal = batchBitPos[qubitIdx] < 0 ? bitString[qubitIdx] : ((idx >> batchBitPos[qubitIdx]) & 1ULL);
+          bitStr[j] = bitVal ? '1' : '0';
+        }
+        samples.emplace_back(std::move(bitStr));
+      }
+    }
+  }
+
+  auto& metrics = MetricsRegistry::get_instance();
+  metrics.increment("exatn::frugal-sampling:batches", nbBatches);
+  metrics.increment("exatn::frugal-sampling:accepted", samples.size());
+  if (samples.size() < static_cast<size_t>(in_nbShots))
+  {
+    xacc::warning("Frugal rejection sampling accepted " + std::to_string(samples.size()) + " out of " +
+                  std::to_string(in_nbShots) + " shots in " + std::to_string(nbBatches) +
+                  " batches (output distribution far from Porter-Thomas?), sampling the remaining shots exactly.");
+    while (samples.size() < static_cast<size_t>(in_nbShots))
+    {
+      std::string bitStr;
+      for (const auto& bit : generateMeasureSample(in_tensorNetwork, in_qubitIdx))
+      {
+        bitStr.append(std::to_string(bit));
+      }
+      samples.emplace_back(std::move(bitStr));
+    }
+  }
+  return samples;
+}
+
 template<typename TNQVM_COMPLEX_TYPE>
 std::vector<std::pair<double, double>> ExatnVisitor<TNQVM_COMPLEX_TYPE>::calcFlopsAndMemoryForSample(const TensorNetwork& in_tensorNetwork)
 {
@@ -2033,11 +2314,13 @@ std::vector<std::pair<double, double>> ExatnVisitor<TNQVM_COMPLEX_TYPE>::calcFlo
     }
     combinedNetwork.appendTensorNetwork(std::move(bra), pairings);
     const bool isoCollapsed = combinedNetwork.collapseIsometries();
-    const std::string optimizerName = options.stringExists("exatn-contract-seq-optimizer") ? options.getString("exatn-contract-seq-optimizer") : "metis";
-    // Get the tensor operation list, i.e. run the tensor optimizer.
-    combinedNetwork.getOperationList(optimizerName);
-    const double flops = combinedNetwork.getFMAFlops();
-    const double intermediatesVolume = combinedNetwork.getMaxIntermediatePresenceVolume();
+    // Get the contraction plan, i.e. run the tensor optimizer (unless cached).
+    // Note: these are the networks that generateMeasureSample contracts when all qubits are measured in order,
+    // hence their plans are reused for sampling.
+    ContractionSeqCache::Cost planCost;
+    applyContractionSeqCache(combinedNetwork, &planCost);
+    const double flops = planCost.flops >= 0.0 ? planCost.flops : combinedNetwork.getFMAFlops();
+    const double intermediatesVolume = planCost.maxIntermediateVolume >= 0.0 ? planCost.maxIntermediateVolume : combinedNetwork.getMaxIntermediatePresenceVolume();
     const double sizeInBytes = intermediatesVolume * sizeof(TNQVM_COMPLEX_TYPE);
     // Save the data:
     resultData.emplace_back(flops, sizeInBytes);
@@ -2075,6 +2358,7 @@ bool ExatnVisitor<TNQVM_COMPLEX_TYPE>::validateTensorNetworkContraction(TensorNe
     if (exatn::evaluateSync(combinedNetwork))
     {
       exatn::sync();
+      tnqvm::recordNetworkMetrics(combinedNetwork, sizeof(TNQVM_COMPLEX_TYPE));
       auto talsh_tensor = exatn::getLocalTensor(combinedNetwork.getTensor(0)->getName());
       const auto tensorVolume = talsh_tensor->getVolume();
       // Double check the size of the RDM
@@ -2098,8 +2382,19 @@ std::vector<TNQVM_COMPLEX_TYPE>
 ExatnVisitor<TNQVM_COMPLEX_TYPE>::computeWaveFuncSlice(
     const TensorNetwork &in_tensorNetwork, const std::vector<int> &bitString,
     const exatn::ProcessGroup &in_processGroup) const {
+  auto slice = submitWaveFuncSlice(in_tensorNetwork, bitString, in_processGroup);
+  return collectWaveFuncSlice(slice);
+}
+
+template <typename TNQVM_COMPLEX_TYPE>
+typename ExatnVisitor<TNQVM_COMPLEX_TYPE>::WaveFuncSliceContraction
+ExatnVisitor<TNQVM_COMPLEX_TYPE>::submitWaveFuncSlice(
+    const TensorNetwork &in_tensorNetwork, const std::vector<int> &bitString,
+    const exatn::ProcessGroup &in_processGroup,
+    const std::string &in_nameSuffix) const {
   // Closing the tensor network with the bra
   std::vector<std::pair<unsigned int, unsigned int>> pairings;
+  std::vector<std::string> braTensorNames;
   int nbOpenLegs = 0;
   const auto constructBraNetwork = [&](const std::vector<int> &in_bitString) {
     int tensorIdCounter = 1;
@@ -2107,7 +2402,7 @@ ExatnVisitor<TNQVM_COMPLEX_TYPE>::computeWaveFuncSlice(
     // Create the qubit register tensor
     for (int i = 0; i < in_bitString.size(); ++i) {
       const auto bitVal = in_bitString[i];
-      const std::string braQubitName = "QB" + std::to_string(i);
+      const std::string braQubitName = "QB" + std::to_string(i) + in_nameSuffix;
       if (bitVal == 0) {
         const bool created =
             exatn::createTensor(in_processGroup, braQubitName,
@@ -2149,6 +2444,7 @@ ExatnVisitor<TNQVM_COMPLEX_TYPE>::computeWaveFuncSlice(
       braTensorNet.appendTensor(
           tensorIdCounter, exatn::getTensor(braQubitName),
           std::vector<std::pair<unsigned int, unsigned int>>{});
+      braTensorNames.emplace_back(braQubitName);
       tensorIdCounter++;
     }
 
@@ -2162,16 +2458,35 @@ ExatnVisitor<TNQVM_COMPLEX_TYPE>::computeWaveFuncSlice(
   combinedTensorNetwork.appendTensorNetwork(std::move(braTensors), pairings);
   combinedTensorNetwork.collapseIsometries();
   // combinedTensorNetwork.printIt();
-  std::vector<TNQVM_COMPLEX_TYPE> waveFnSlice;
+  // Note: slices in flight at the same time must have distinct (output tensor) names.
+  combinedTensorNetwork.rename(m_kernelName + in_nameSuffix);
+  applyContractionSeqCache(combinedTensorNetwork);
   {
-    TNQVM_TELEMETRY_ZONE("exatn::evaluateSync", __FILE__, __LINE__);
+    TNQVM_TELEMETRY_ZONE("exatn::evaluate", __FILE__, __LINE__);
     // std::cout << "SUBMIT TENSOR NETWORK FOR EVALUATION\n";
     // combinedTensorNetwork.printIt();
-    combinedTensorNetwork.rename(m_kernelName);
-    if (exatn::evaluateSync(in_processGroup, combinedTensorNetwork)) {
-      exatn::sync();
-      auto talsh_tensor =
-          exatn::getLocalTensor(combinedTensorNetwork.getTensor(0)->getName());
+    const bool submitted = exatn::evaluate(in_processGroup, combinedTensorNetwork);
+    assert(submitted);
+  }
+  return WaveFuncSliceContraction{combinedTensorNetwork, braTensorNames};
+}
+
+template <typename TNQVM_COMPLEX_TYPE>
+bool ExatnVisitor<TNQVM_COMPLEX_TYPE>::isWaveFuncSliceReady(
+    const WaveFuncSliceContraction &in_slice) const {
+  return exatn::sync(in_slice.network.getTensor(0)->getName(), false);
+}
+
+template <typename TNQVM_COMPLEX_TYPE>
+std::vector<TNQVM_COMPLEX_TYPE>
+ExatnVisitor<TNQVM_COMPLEX_TYPE>::collectWaveFuncSlice(
+    WaveFuncSliceContraction &io_slice) const {
+  std::vector<TNQVM_COMPLEX_TYPE> waveFnSlice;
+  const std::string resultTensorName = io_slice.network.getTensor(0)->getName();
+  {
+    TNQVM_TELEMETRY_ZONE("exatn::sync", __FILE__, __LINE__);
+    if (exatn::sync(resultTensorName)) {
+      auto talsh_tensor = exatn::getLocalTensor(resultTensorName);
       const TNQVM_COMPLEX_TYPE *body_ptr;
       if (talsh_tensor->getDataAccessHostConst(&body_ptr)) {
         waveFnSlice.assign(body_ptr, body_ptr + talsh_tensor->getVolume());
@@ -2179,11 +2494,14 @@ ExatnVisitor<TNQVM_COMPLEX_TYPE>::computeWaveFuncSlice(
     }
   }
   // Destroy bra tensors
-  for (int i = 0; i < m_buffer->size(); ++i) {
-    const std::string braQubitName = "QB" + std::to_string(i);
+  for (const auto &braQubitName : io_slice.braTensorNames) {
     const bool destroyed = exatn::destroyTensor(braQubitName);
     assert(destroyed);
   }
+  // Release the slice (host buffer) for the next ones.
+  const bool resultDestroyed = exatn::destroyTensor(resultTensorName);
+  assert(resultDestroyed);
+  io_slice.braTensorNames.clear();
   return waveFnSlice;
 }
 
@@ -40,6 +40,8 @@
 #include <utility>
 #include "TNQVMVisitor.hpp"
 #include "tensor_network.hpp"
+#include "ExatnRuntime.hpp"
+#include "ContractionSeqCache.hpp"
 
 using namespace xacc;
 using namespace xacc::quantum;
@@ -55,6 +57,8 @@ using TensorFunctor = talsh::TensorFunctor<exatn::Identifiable>;
 // |  Initialization Parameter   |                  Parameter Description                                 |    type     |         default          |
 // +=============================+========================================================================+=============+==========================+
 // | exatn-buffer-size-gb        | ExaTN's host memory buffer size (in GB)                                |    int      | 8 (GB)                   |
+// |                             | The runtime is shared by all ExaTN visitors; a different size resizes  |             |                          |
+// |                             | (re-initializes) it before the next simulation.                        |             |                          |
 // +-----------------------------+------------------------------------------------------------------------+-------------+--------------------------+
 // | exatn-contract-seq-optimizer| ExaTN's contraction sequence optimizer to use.                         |    string   | metis                    |
 // +-----------------------------+------------------------------------------------------------------------+-------------+--------------------------+
@@ -83,6 +87,28 @@ using TensorFunctor = talsh::TensorFunctor<exatn::Identifiable>;
 // | exp-val-by-conjugate        | If true, expectation value of *large* circuits (exceeding memory limit)|    bool     | false                    |
 // |                             | is computed by closing the tensor network with its conjugate.          |             |                          |
 // +-----------------------------+------------------------------------------------------------------------+-------------+--------------------------+
+// | exatn-contract-seq-cache-dir| Directory to persist optimized contraction sequences across runs.      |    string   | <unused>                 |
+// |                             | Sequences are keyed by the network topology and the optimizer name.    |             |                          |
+// +-----------------------------+------------------------------------------------------------------------+-------------+--------------------------+
+// | max-concurrent-slices       | Max number of wave function slices that are contracted concurrently    |    int      | 4                        |
+// |                             | when computing exp-val-z by slicing (single process).                  |             |                          |
+// |                             | Slices are made smaller accordingly to keep the same memory footprint. |             |                          |
+// +-----------------------------+------------------------------------------------------------------------+-------------+--------------------------+
+// | gate-fusion                 | Fuse runs of 1-qubit gates into adjacent gates and drop inverse pairs  |    bool     | true                     |
+// |                             | before building the tensor network (fewer, exact gate tensors).        |             |                          |
+// +-----------------------------+------------------------------------------------------------------------+-------------+--------------------------+
+// | sampling-method             | Shot sampling method for circuits too large for the state vector:      |    string   | exact                    |
+// |                             | - `exact`: one ket+bra contraction per measured qubit and per shot.    |             |                          |
+// |                             | - `frugal-rejection`: frugal rejection sampling of amplitude batches   |             |                          |
+// |                             | (random bits + `sampling-open-qubits` open legs), for random circuits: |             |                          |
+// |                             | approximate if the output is far from Porter-Thomas distributed.       |             |                          |
+// +-----------------------------+------------------------------------------------------------------------+-------------+--------------------------+
+// | sampling-open-qubits        | Number of measured qubits left open in each amplitude batch            |    int      | 10                       |
+// |                             | (`frugal-rejection` sampling), capped by the max state vector size.    |             |                          |
+// +-----------------------------+------------------------------------------------------------------------+-------------+--------------------------+
+// | frugal-rejection-factor     | Acceptance scale M: bitstring x is accepted w/ prob min(1, 2^n p(x)/M) |   double    | 10.0                     |
+// |                             | Larger values are more exact (less clipping) but accept fewer samples. |             |                          |
+// +-----------------------------+------------------------------------------------------------------------+-------------+--------------------------+
 
 namespace tnqvm {
     // Simple struct to identify a concrete quantum gate instance,
@@ -240,6 +266,7 @@ namespace tnqvm {
         // Virtual function impls:
         virtual void initialize(std::shared_ptr<AcceleratorBuffer> buffer, int nbShots) override;
         virtual void finalize() override;
+        virtual void prewarm(const HeterogeneousMap& in_options) override { ExatnRuntime::get().prewarm(in_options); }
 
         // Service name as defined in manifest.json
         virtual const std::string name() const override { return "exatn"; }
@@ -272,7 +299,13 @@ namespace tnqvm {
         // others
         virtual void visit(Measure& in_MeasureGate) override;
         virtual bool supportVqeMode() const override { return true; }
+        virtual bool supportGateFusion() const override { return true; }
+        virtual void applyFusedGate(const std::vector<size_t>& in_bits, const std::vector<std::vector<std::complex<double>>>& in_matrix) override;
         virtual const double getExpectationValueZ(std::shared_ptr<CompositeInstruction> in_function) override;
+        // VQE mode: observable terms are grouped by (qubit-wise compatible) measurement basis,
+        // each basis change is applied once to a copy of the cached ansatz state vector,
+        // then all Z-parities of the group are reduced from that vector in a single pass.
+        virtual std::vector<double> getExpectationValueZBatch(const std::vector<std::shared_ptr<CompositeInstruction>>& in_functions) override;
 
         void subscribe(IExatnListener<TNQVM_COMPLEX_TYPE>* listener) { m_listeners.emplace_back(listener); }
         std::vector<TNQVM_COMPLEX_TYPE> retrieveStateVector();
@@ -315,13 +348,28 @@ namespace tnqvm {
     private:
         template<tnqvm::CommonGates GateType, typename... GateParams>
         void appendGateTensor(const xacc::Instruction& in_gateInstruction, GateParams&&... in_params);
+        // Creates and initializes a (1 or 2-qubit) gate tensor.
+        void createGateTensor(const std::string& in_uniqueGateName, const std::vector<std::vector<std::complex<double>>>& in_gateMatrix, size_t in_nbQubits);
+        // Appends a gate tensor (which must have been created) to the circuit network.
+        void appendGateTensorToNetwork(const std::string& in_uniqueGateName, const std::string& in_gateName, const std::vector<unsigned int>& in_gatePairing);
         void evaluateNetwork();
+        // Sets the contraction sequence of the network from the plan cache (in-memory, and persistent
+        // if `exatn-contract-seq-cache-dir` is set), running the optimizer on a miss.
+        // Returns true on a cache hit; the plan cost is returned if known (negative otherwise).
+        bool applyContractionSeqCache(TensorNetwork& io_network, ContractionSeqCache::Cost* out_cost = nullptr) const;
+        // VQE mode: evaluates the ansatz network (once), caches its state vector (m_cacheStateVec)
+        // and replaces the qubit register by the "RESET_" tensor holding that state.
+        void cacheAnsatzState();
         void resetExaTN();
         void resetNetwork();
         TNQVM_COMPLEX_TYPE expVal(const std::vector<ObservableTerm>& in_observableExpression);
         TNQVM_COMPLEX_TYPE evaluateTerm(const std::vector<std::shared_ptr<Instruction>>& in_observableTerm);
         void applyInverse();
         std::vector<uint8_t> generateMeasureSample(const TensorNetwork& in_tensorNetwork, const std::vector<int>& in_qubitIdx);
+        // Frugal rejection sampling of many shots from batches of 2^k amplitudes:
+        // each batch fixes the other qubits to uniformly random bits and leaves k measured qubits open.
+        // Returns the bitstrings of the measured qubits (in the order of in_qubitIdx).
+        std::vector<std::string> generateFrugalSamples(const TensorNetwork& in_tensorNetwork, const std::vector<int>& in_qubitIdx, int in_nbShots);
         // Calculate the flops and memory requirements to generate a full sample (all qubits) for the input tensor network.
         // Note: this doesn't actually contract the tensor network, just getting this data from the ExaTN optimizer.
         // Output: pairs of flops and memory (in bytes); one pair for each qubit.
@@ -337,6 +385,24 @@ namespace tnqvm {
         computeWaveFuncSlice(const TensorNetwork &in_tensorNetwork,
                              const std::vector<int> &in_bitString,
                              const exatn::ProcessGroup &in_processGroup) const;
+        // Asynchronous version of computeWaveFuncSlice:
+        // submit the slice network (non-blocking), then collect its result.
+        // The name suffix keeps the tensors of slices that are in flight at the same time apart.
+        struct WaveFuncSliceContraction
+        {
+            TensorNetwork network;
+            std::vector<std::string> braTensorNames;
+        };
+        WaveFuncSliceContraction
+        submitWaveFuncSlice(const TensorNetwork &in_tensorNetwork,
+                            const std::vector<int> &in_bitString,
+                            const exatn::ProcessGroup &in_processGroup,
+                            const std::string &in_nameSuffix = "") const;
+        // Returns true if the slice contraction has completed (no waiting).
+        bool isWaveFuncSliceReady(const WaveFuncSliceContraction &in_slice) const;
+        // Waits for the slice contraction, returns its data and releases its tensors.
+        std::vector<TNQVM_COMPLEX_TYPE>
+        collectWaveFuncSlice(WaveFuncSliceContraction &io_slice) const;
 
         // Compute exp-val-z for large circuits:
         // Select the appropriate method based on user config:
@@ -409,10 +475,20 @@ namespace tnqvm {
         // Tensor network of the qubit register (to close the tensor network for
         // expectation calculation)
         TensorNetwork m_qubitRegTensor;
+        // Name of the tensor holding the state after the previous circuit segment
+        // (root tensor of its evaluation), empty if the network starts from the qubit register.
+        std::string m_stateTensorName;
         std::string m_kernelName;
         std::vector<TNQVM_COMPLEX_TYPE> m_cacheStateVec;
         // Max number of qubits that we allow full wave function contraction.
         size_t m_maxQubit;
+        // Max number of wave function slices that are contracted concurrently
+        // (exp-val-z by slicing w/o MPI).
+        size_t m_maxConcurrentSlices;
+        // Contraction sequence (plan) cache.
+        std::shared_ptr<ContractionSeqCache> m_contractSeqCache;
+        // Counter to name the tensors of fused gates (gate fusion).
+        size_t m_fusedGateCounter;
         // Make the debug logger friend, e.g. retrieve internal states for
         // logging purposes.
         friend class ExatnDebugLogger<TNQVM_COMPLEX_TYPE>;
@@ -285,6 +285,35 @@ TEST(ExatnVisitorInternalTester, testMissingGates) {
   qpu->execute(buffer, program);
 }
 
+// Batched parity-mask exp-val-z reduction vs. direct parity counting
+TEST(ExatnVisitorInternalTester, testBatchExpValZ) {
+  // Large enough to use multiple chunks
+  constexpr size_t NB_QUBITS = 16;
+  auto stateVector = AllocateStateVector(NB_QUBITS);
+  for (size_t i = 0; i < NB_QUBITS; ++i) {
+    ApplySingleQubitGate(stateVector, i, GetGateMatrix<CommonGates::Ry>(0.1 * (i + 1)));
+  }
+  for (size_t i = 0; i + 1 < NB_QUBITS; ++i) {
+    ApplyCNOTGate(stateVector, i, i + 1);
+  }
+
+  const std::vector<std::vector<int>> zStrings{{0}, {3, 7}, {0, 1, 15}, {}};
+  const auto batchResults = CalcExpValueZBatch(stateVector, zStrings);
+  ASSERT_EQ(batchResults.size(), zStrings.size());
+  for (size_t j = 0; j < zStrings.size(); ++j) {
+    double expected = 0.0;
+    for (uint64_t i = 0; i < stateVector.size(); ++i) {
+      int parity = 0;
+      for (const auto &bit : zStrings[j]) {
+        parity ^= (i >> bit) & 1;
+      }
+      expected += (parity ? -1.0 : 1.0) * std::norm(stateVector[i]);
+    }
+    EXPECT_NEAR(batchResults[j], expected, 1e-12);
+    EXPECT_NEAR(CalcExpValueZ(stateVector, zStrings[j]), expected, 1e-12);
+  }
+}
+
 int main(int argc, char **argv)
 {
   ::testing::InitGoogleTest(&argc, argv);
@@ -38,47 +38,66 @@
 #include "Eigen/Dense"
 #include "utils/GateMatrixAlgebra.hpp"
 #include "base/Gates.hpp"
+#include "utils/RandomEngine.hpp"
+#include <map>
+#include <thread>
 namespace {
 using namespace tnqvm;
 
+std::vector<std::vector<std::complex<double>>>
+singleQubitGateMatrix(const xacc::Instruction &in_gate) {
+  const auto gateEnum = GetGateType(in_gate.name());
+  switch (gateEnum) {
+  case CommonGates::Rx:
+    return GetGateMatrix<CommonGates::Rx>(
+        in_gate.getParameter(0).as<double>());
+  case CommonGates::Ry:
+    return GetGateMatrix<CommonGates::Ry>(
+        in_gate.getParameter(0).as<double>());
+  case CommonGates::Rz:
+    return GetGateMatrix<CommonGates::Rz>(
+        in_gate.getParameter(0).as<double>());
+  case CommonGates::U:
+    return GetGateMatrix<CommonGates::U>(
+        in_gate.getParameter(0).as<double>(),
+        in_gate.getParameter(1).as<double>(),
+        in_gate.getParameter(2).as<double>());
+  case CommonGates::I:
+    return GetGateMatrix<CommonGates::I>();
+  case CommonGates::H:
+    return GetGateMatrix<CommonGates::H>();
+  case CommonGates::X:
+    return GetGateMatrix<CommonGates::X>();
+  case CommonGates::Y:
+    return GetGateMatrix<CommonGates::Y>();
+  case CommonGates::Z:
+    return GetGateMatrix<CommonGates::Z>();
+  case CommonGates::T:
+    return GetGateMatrix<CommonGates::T>();
+  case CommonGates::Tdg:
+    return GetGateMatrix<CommonGates::Tdg>();
+  default:
+    xacc::error("Invalid single qubit gates!");
+    return GetGateMatrix<CommonGates::I>();
+  }
+}
+
+// Product of two row-major 2x2 matrices
+std::array<std::complex<double>, 4>
+multiplyOps(const std::array<std::complex<double>, 4> &in_a,
+            const std::array<std::complex<double>, 4> &in_b) {
+  std::array<std::complex<double>, 4> result;
+  for (int i = 0; i < 2; ++i) {
+    for (int j = 0; j < 2; ++j) {
+      result[2 * i + j] = in_a[2 * i] * in_b[j] + in_a[2 * i + 1] * in_b[2 + j];
+    }
+  }
+  return result;
+}
+
 itensor::ITensor singleQubitTensor(const itensor::Index &s,
                                    const xacc::Instruction &in_gate) {
-  const auto gate_mat = [&]() {
-    const auto gateEnum = GetGateType(in_gate.name());
-    switch (gateEnum) {
-    case CommonGates::Rx:
-      return GetGateMatrix<CommonGates::Rx>(
-          in_gate.getParameter(0).as<double>());
-    case CommonGates::Ry:
-      return GetGateMatrix<CommonGates::Ry>(
-          in_gate.getParameter(0).as<double>());
-    case CommonGates::Rz:
-      return GetGateMatrix<CommonGates::Rz>(
-          in_gate.getParameter(0).as<double>());
-    case CommonGates::U:
-      return GetGateMatrix<CommonGates::U>(
-          in_gate.getParameter(0).as<double>(),
-          in_gate.getParameter(1).as<double>(),
-          in_gate.getParameter(2).as<double>());
-    case CommonGates::I:
-      return GetGateMatrix<CommonGates::I>();
-    case CommonGates::H:
-      return GetGateMatrix<CommonGates::H>();
-    case CommonGates::X:
-      return GetGateMatrix<CommonGates::X>();
-    case CommonGates::Y:
-      return GetGateMatrix<CommonGates::Y>();
-    case CommonGates::Z:
-      return GetGateMatrix<CommonGates::Z>();
-    case CommonGates::T:
-      return GetGateMatrix<CommonGates::T>();
-    case CommonGates::Tdg:
-      return GetGateMatrix<CommonGates::Tdg>();
-    default:
-      xacc::error("Invalid single qubit gates!");
-      return GetGateMatrix<CommonGates::I>();
-    }
-  }();
+  const auto gate_mat = singleQubitGateMatrix(in_gate);
   assert(gate_mat.size() == 2 && gate_mat[0].size() == 2 && gate_mat[1].size());
   auto sP = itensor::prime(s);
   auto Up = s(1);
@@ -111,6 +130,7 @@ void ITensorMPSVisitor::initialize(
   m_mps = itensor::MPS(state);
   m_measureBits.clear();
   m_buffer = accbuffer_in;
+  m_nbShots = nbShots;
 
   // Parse SVD options:
   // Default:
@@ -156,6 +176,29 @@ void ITensorMPSVisitor::initialize(
   }
 }
 
+namespace {
+struct ITensorMPSState : public VisitorState {
+  itensor::MPS mps;
+  std::vector<size_t> measureBits;
+};
+} // namespace
+
+std::shared_ptr<VisitorState> ITensorMPSVisitor::saveState() {
+  auto state = std::make_shared<ITensorMPSState>();
+  state->mps = m_mps;
+  state->measureBits = m_measureBits;
+  return state;
+}
+
+void ITensorMPSVisitor::restoreState(const std::shared_ptr<VisitorState> &in_state) {
+  auto state = std::dynamic_pointer_cast<ITensorMPSState>(in_state);
+  if (!state || static_cast<size_t>(itensor::length(state->mps)) != m_buffer->size()) {
+    xacc::error("Invalid ITensor MPS state snapshot.");
+  }
+  m_mps = state->mps;
+  m_measureBits = state->measureBits;
+}
+
 itensor::Index ITensorMPSVisitor::getSiteIndex(size_t site_id) {
   if (m_buffer->size() > 1) {
     return itensor::siteIndex(m_mps, site_id);
@@ -279,10 +322,150 @@ void ITensorMPSVisitor::finalize() {
     return;
   }
 
-  // Assign the exp-val-z (single Composite mode)
   if (!m_measureBits.empty()) {
-    m_buffer->addExtraInfo("exp-val-z", compute_expectation_z(m_measureBits));
+    if (m_nbShots < 1) {
+      // Assign the exp-val-z (single Composite mode)
+      m_buffer->addExtraInfo("exp-val-z", compute_expectation_z(m_measureBits));
+    } else {
+      for (const auto &bitString :
+           sampleMeasurements(m_measureBits, m_nbShots)) {
+        m_buffer->appendMeasurement(bitString);
+      }
+    }
+  }
+}
+
+std::vector<ITensorMPSVisitor::DenseSiteTensor>
+ITensorMPSVisitor::getRightCanonicalSites(size_t in_lastSite) {
+  // IMPORTTANT: shift the gauge position to the first site:
+  // all the other sites are then right-orthonormal.
+  m_mps.position(1);
+  const size_t nbQubits = m_buffer->size();
+  std::vector<DenseSiteTensor> sites(in_lastSite + 1);
+  for (size_t i = 0; i <= in_lastSite; ++i) {
+    const auto site_idx = i + 1;
+    const auto &siteTensor = m_mps(site_idx);
+    const auto s = getSiteIndex(site_idx);
+    const auto l = itensor::leftLinkIndex(m_mps, site_idx);
+    const auto r = site_idx < nbQubits ? itensor::rightLinkIndex(m_mps, site_idx)
+                                       : Index();
+    auto &site = sites[i];
+    site.leftDim = l ? l.dim() : 1;
+    site.rightDim = r ? r.dim() : 1;
+    site.data.resize(2 * site.leftDim * site.rightDim);
+    const auto siteInds = itensor::inds(siteTensor);
+    std::vector<IndexVal> ivs(siteInds.size());
+    for (size_t lv = 0; lv < site.leftDim; ++lv) {
+      for (size_t p = 0; p < 2; ++p) {
+        for (size_t rv = 0; rv < site.rightDim; ++rv) {
+          for (size_t k = 0; k < siteInds.size(); ++k) {
+            const auto &idx = siteInds[k];
+            // Any other index, e.g. of a single-site MPS, is a trivial one.
+            ivs[k] = (idx == s)   ? idx(p + 1)
+                     : (idx == l) ? idx(lv + 1)
+                     : (idx == r) ? idx(rv + 1)
+                                  : idx(1);
+          }
+          site.data[(lv * 2 + p) * site.rightDim + rv] = siteTensor.eltC(ivs);
+        }
+      }
+    }
   }
+  return sites;
+}
+
+std::vector<std::string>
+ITensorMPSVisitor::sampleMeasurements(const std::vector<size_t> &in_measureBits,
+                                      int in_nbShots) {
+  std::vector<std::string> result;
+  if (in_measureBits.empty() || in_nbShots < 1) {
+    return result;
+  }
+
+  // The sites after the last measured one don't contribute (right-orthonormal),
+  // i.e. the conditional probabilities only need the (collapsed) left boundary
+  // vector.
+  const size_t lastSite =
+      *std::max_element(in_measureBits.begin(), in_measureBits.end());
+  const auto sites = getRightCanonicalSites(lastSite);
+
+  // Position of each measured qubit in the result bit string
+  std::vector<std::vector<size_t>> bitPositions(lastSite + 1);
+  for (size_t i = 0; i < in_measureBits.size(); ++i) {
+    bitPositions[in_measureBits[i]].emplace_back(i);
+  }
+
+  const auto sampleShot = [&](const double *in_randProbs) {
+    std::string bitString(in_measureBits.size(), '0');
+    std::vector<std::complex<double>> leftVec{1.0};
+    std::vector<std::complex<double>> projVecs[2];
+    for (size_t i = 0; i <= lastSite; ++i) {
+      const auto &site = sites[i];
+      double probs[2];
+      for (int bit = 0; bit < 2; ++bit) {
+        auto &projVec = projVecs[bit];
+        projVec.assign(site.rightDim, 0.0);
+        for (size_t lv = 0; lv < site.leftDim; ++lv) {
+          const auto coeff = leftVec[lv];
+          const auto *row = site.data.data() + (lv * 2 + bit) * site.rightDim;
+          for (size_t rv = 0; rv < site.rightDim; ++rv) {
+            projVec[rv] += coeff * row[rv];
+          }
+        }
+        double prob = 0.0;
+        for (const auto &val : projVec) {
+          prob += std::norm(val);
+        }
+        probs[bit] = prob;
+      }
+      const double totalProb = probs[0] + probs[1];
+      const int pickedBit =
+          (totalProb > 0.0 && in_randProbs[i] * totalProb >= probs[0]) ? 1 : 0;
+      for (const auto &pos : bitPositions[i]) {
+        bitString[pos] = pickedBit ? '1' : '0';
+      }
+      // Renormalize the collapsed boundary vector.
+      leftVec = std::move(projVecs[pickedBit]);
+      const double normFactor = std::sqrt(probs[pickedBit]);
+      if (normFactor > 0.0) {
+        for (auto &val : leftVec) {
+          val /= normFactor;
+        }
+      }
+    }
+    return bitString;
+  };
+
+  // Draw the random numbers upfront (in shot order), i.e. the result for a
+  // given seed doesn't depend on the number of threads.
+  const size_t nbShots = in_nbShots;
+  const size_t nbSites = lastSite + 1;
+  result.resize(nbShots);
+  constexpr size_t SHOT_BATCH_SIZE = 1024;
+  const size_t nbThreads = getThreadBudget();
+  for (size_t batchStart = 0; batchStart < nbShots;
+       batchStart += SHOT_BATCH_SIZE) {
+    const size_t batchSize = std::min(SHOT_BATCH_SIZE, nbShots - batchStart);
+    const auto randProbs =
+        randomEngine::get_instance().randProbs(batchSize * nbSites);
+    const auto sampleRange = [&](size_t in_begin, size_t in_end) {
+      for (size_t i = in_begin; i < in_end; ++i) {
+        result[batchStart + i] = sampleShot(randProbs.data() + i * nbSites);
+      }
+    };
+    const size_t nbWorkers = std::min(nbThreads, batchSize);
+    const size_t chunkSize = (batchSize + nbWorkers - 1) / nbWorkers;
+    std::vector<std::thread> workers;
+    for (size_t begin = chunkSize; begin < batchSize; begin += chunkSize) {
+      workers.emplace_back(sampleRange, begin,
+                           std::min(begin + chunkSize, batchSize));
+    }
+    sampleRange(0, std::min(chunkSize, batchSize));
+    for (auto &worker : workers) {
+      worker.join();
+    }
+  }
+  return result;
 }
 
 void ITensorMPSVisitor::applySingleQubitGate(xacc::Instruction &in_gate) {
@@ -463,5 +646,233 @@ const double ITensorMPSVisitor::getExpectationValueZ(
   return exp_val;
 }
 
+std::vector<double> ITensorMPSVisitor::getExpectationValueZBatch(
+    const std::vector<std::shared_ptr<CompositeInstruction>> &functions) {
+  static const SingleQubitOp IDENTITY{1.0, 0.0, 0.0, 1.0};
+  static const SingleQubitOp PAULI_Z{1.0, 0.0, 0.0, -1.0};
+  const auto adjoint = [](const SingleQubitOp &in_op) {
+    return SingleQubitOp{std::conj(in_op[0]), std::conj(in_op[2]),
+                         std::conj(in_op[1]), std::conj(in_op[3])};
+  };
+
+  // Measuring Z after a single-qubit change of basis U is the same as
+  // measuring U^dagger Z U on the current state.
+  std::vector<double> result(functions.size(), 0.0);
+  std::vector<ProductOperator> terms;
+  std::vector<size_t> termFunctionIdx;
+  for (size_t i = 0; i < functions.size(); ++i) {
+    std::map<size_t, SingleQubitOp> basisChanges;
+    std::vector<size_t> measureBits;
+    bool isProductObservable = true;
+    InstructionIterator it(functions[i]);
+    while (it.hasNext()) {
+      auto nextInst = it.next();
+      if (!nextInst->isEnabled() || nextInst->isComposite()) {
+        continue;
+      }
+      if (nextInst->name() == "Measure") {
+        measureBits.emplace_back(nextInst->bits()[0]);
+      } else if (nextInst->bits().size() == 1) {
+        const auto gateMat = singleQubitGateMatrix(*nextInst);
+        const SingleQubitOp gateOp{gateMat[0][0], gateMat[0][1], gateMat[1][0],
+                                   gateMat[1][1]};
+        auto iter = basisChanges.emplace(nextInst->bits()[0], IDENTITY).first;
+        iter->second = multiplyOps(gateOp, iter->second);
+      } else {
+        isProductObservable = false;
+        break;
+      }
+    }
+
+    if (!isProductObservable || measureBits.empty()) {
+      // Fall back to simulating the sub-circuit.
+      result[i] = getExpectationValueZ(functions[i]);
+      continue;
+    }
+
+    ProductOperator term;
+    for (const auto &bit : measureBits) {
+      const auto iter = basisChanges.find(bit);
+      term.emplace_back(bit, iter == basisChanges.end()
+                                 ? PAULI_Z
+                                 : multiplyOps(adjoint(iter->second),
+                                               multiplyOps(PAULI_Z, iter->second)));
+    }
+    terms.emplace_back(std::move(term));
+    termFunctionIdx.emplace_back(i);
+  }
+
+  const auto expVals = computeProductExpectations(terms);
+  for (size_t i = 0; i < expVals.size(); ++i) {
+    result[termFunctionIdx[i]] = expVals[i];
+  }
+  return result;
+}
+
+std::vector<double> ITensorMPSVisitor::getPauliExpectationValues(
+    const std::vector<std::vector<std::pair<size_t, char>>> &in_pauliStrings) {
+  std::vector<ProductOperator> terms;
+  terms.reserve(in_pauliStrings.size());
+  for (const auto &pauliString : in_pauliStrings) {
+    ProductOperator term;
+    for (const auto &[bit, pauli] : pauliString) {
+      switch (pauli) {
+      case 'I':
+        break;
+      case 'X':
+        term.emplace_back(bit, SingleQubitOp{0.0, 1.0, 1.0, 0.0});
+        break;
+      case 'Y':
+        term.emplace_back(bit, SingleQubitOp{0.0, std::complex<double>(0.0, -1.0),
+                                             std::complex<double>(0.0, 1.0),
+                                             0.0});
+        break;
+      case 'Z':
+        term.emplace_back(bit, SingleQubitOp{1.0, 0.0, 0.0, -1.0});
+        break;
+      default:
+        xacc::error("Invalid Pauli operator '" + std::string(1, pauli) + "'.");
+      }
+    }
+    terms.emplace_back(std::move(term));
+  }
+  return computeProductExpectations(terms);
+}
+
+std::vector<double> ITensorMPSVisitor::computeProductExpectations(
+    const std::vector<ProductOperator> &in_terms) {
+  std::vector<double> result(in_terms.size(), 1.0);
+  // Sort the operators of each term by qubit (merging repeated qubits).
+  std::vector<std::map<size_t, SingleQubitOp>> sortedTerms(in_terms.size());
+  size_t lastSite = 0;
+  bool hasOps = false;
+  for (size_t i = 0; i < in_terms.size(); ++i) {
+    for (const auto &[bit, op] : in_terms[i]) {
+      auto iter = sortedTerms[i].find(bit);
+      if (iter == sortedTerms[i].end()) {
+        sortedTerms[i].emplace(bit, op);
+      } else {
+        // Later operator applied after the earlier one.
+        iter->second = multiplyOps(op, iter->second);
+      }
+      lastSite = std::max(lastSite, bit);
+      hasOps = true;
+    }
+  }
+  if (!hasOps) {
+    return result;
+  }
+
+  const auto sites = getRightCanonicalSites(lastSite);
+  // Contracts a site (and its conjugate) into a left environment,
+  // E'(rb, rk) = Sum conj(A(lb, p, rb)) * Op(p, p') * E(lb, lk) * A(lk, p', rk),
+  // environments are row-major (bra, ket) matrices.
+  const auto transfer = [](const std::vector<std::complex<double>> &in_env,
+                           const DenseSiteTensor &in_site,
+                           const SingleQubitOp *in_op) {
+    const size_t leftDim = in_site.leftDim;
+    const size_t rightDim = in_site.rightDim;
+    // temp(lb, p', rk) = Sum_lk E(lb, lk) * A(lk, p', rk)
+    std::vector<std::complex<double>> temp(leftDim * 2 * rightDim, 0.0);
+    for (size_t lb = 0; lb < leftDim; ++lb) {
+      for (size_t lk = 0; lk < leftDim; ++lk) {
+        const auto envVal = in_env[lb * leftDim + lk];
+        if (envVal == 0.0) {
+          continue;
+        }
+        for (size_t pr = 0; pr < 2 * rightDim; ++pr) {
+          temp[lb * 2 * rightDim + pr] += envVal * in_site.data[lk * 2 * rightDim + pr];
+        }
+      }
+    }
+    if (in_op) {
+      const auto &op = *in_op;
+      for (size_t lb = 0; lb < leftDim; ++lb) {
+        auto *row0 = temp.data() + (lb * 2) * rightDim;
+        auto *row1 = row0 + rightDim;
+        for (size_t rk = 0; rk < rightDim; ++rk) {
+          const auto val0 = row0[rk];
+          const auto val1 = row1[rk];
+          row0[rk] = op[0] * val0 + op[1] * val1;
+          row1[rk] = op[2] * val0 + op[3] * val1;
+        }
+      }
+    }
+    std::vector<std::complex<double>> result(rightDim * rightDim, 0.0);
+    for (size_t lp = 0; lp < leftDim * 2; ++lp) {
+      const auto *braRow = in_site.data.data() + lp * rightDim;
+      const auto *tempRow = temp.data() + lp * rightDim;
+      for (size_t rb = 0; rb < rightDim; ++rb) {
+        const auto braVal = std::conj(braRow[rb]);
+        if (braVal == 0.0) {
+          continue;
+        }
+        for (size_t rk = 0; rk < rightDim; ++rk) {
+          result[rb * rightDim + rk] += braVal * tempRow[rk];
+        }
+      }
+    }
+    return result;
+  };
+  const auto trace = [](const std::vector<std::complex<double>> &in_env) {
+    const size_t dim = std::llround(std::sqrt(in_env.size()));
+    double sum = 0.0;
+    for (size_t i = 0; i < dim; ++i) {
+      sum += in_env[i * dim + i].real();
+    }
+    return sum;
+  };
+
+  // Shared left environments (identity on sites [0, k)), from a single sweep.
+  std::vector<std::vector<std::complex<double>>> leftEnvs(lastSite + 2);
+  leftEnvs[0] = {1.0};
+  for (size_t k = 0; k <= lastSite; ++k) {
+    leftEnvs[k + 1] = transfer(leftEnvs[k], sites[k], nullptr);
+  }
+  // The remaining sites are right-orthonormal: the norm is the trace of any
+  // environment after the orthogonality center.
+  const double norm = trace(leftEnvs[1]);
+
+  const auto evaluateTerm = [&](size_t in_termIdx) {
+    const auto &term = sortedTerms[in_termIdx];
+    if (term.empty()) {
+      return 1.0;
+    }
+    const size_t firstSite = term.begin()->first;
+    const size_t termLastSite = term.rbegin()->first;
+    auto env = leftEnvs[firstSite];
+    auto opIter = term.begin();
+    for (size_t k = firstSite; k <= termLastSite; ++k) {
+      const SingleQubitOp *op = nullptr;
+      if (opIter != term.end() && opIter->first == k) {
+        op = &opIter->second;
+        ++opIter;
+      }
+      env = transfer(env, sites[k], op);
+    }
+    return norm > 0.0 ? trace(env) / norm : 0.0;
+  };
+
+  // Terms are independent, i.e. evaluate them across threads.
+  const size_t nbTerms = in_terms.size();
+  const size_t nbWorkers = std::min<size_t>(getThreadBudget(), nbTerms);
+  const size_t chunkSize = (nbTerms + nbWorkers - 1) / nbWorkers;
+  const auto evaluateRange = [&](size_t in_begin, size_t in_end) {
+    for (size_t i = in_begin; i < in_end; ++i) {
+      result[i] = evaluateTerm(i);
+    }
+  };
+  std::vector<std::thread> workers;
+  for (size_t begin = chunkSize; begin < nbTerms; begin += chunkSize) {
+    workers.emplace_back(evaluateRange, begin,
+                         std::min(begin + chunkSize, nbTerms));
+  }
+  evaluateRange(0, std::min(chunkSize, nbTerms));
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  return result;
+}
+
 ITensorMPSVisitor::~ITensorMPSVisitor() {}
 } // namespace tnqvm
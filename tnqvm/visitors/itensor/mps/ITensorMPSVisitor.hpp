@@ -31,6 +31,7 @@
 #ifndef QUANTUM_GATE_ACCELERATORS_TNQVM_ITensorMPSVisitor_HPP_
 #define QUANTUM_GATE_ACCELERATORS_TNQVM_ITensorMPSVisitor_HPP_
 
+#include <array>
 #include <cstdlib>
 #include "TNQVMVisitor.hpp"
 #include "Cloneable.hpp"
@@ -89,8 +90,35 @@ public:
   // others
   void visit(Measure &gate);
   virtual bool supportVqeMode() const override { return true; }
+  // ITensor has no shared mutable state (e.g. index ids are generated per thread).
+  virtual bool supportConcurrentKernels() const override { return true; }
+  // Snapshots hold a copy of the MPS (copy-on-write storage) and the measured bits.
+  virtual bool supportStateSnapshot() const override { return true; }
+  virtual std::shared_ptr<VisitorState> saveState() override;
+  virtual void restoreState(const std::shared_ptr<VisitorState> &in_state) override;
+  // Evaluates all observable sub-circuits in a single sweep (see
+  // computeProductExpectations) when they only contain single-qubit gates
+  // (change of basis) and measurements.
+  virtual std::vector<double> getExpectationValueZBatch(
+      const std::vector<std::shared_ptr<CompositeInstruction>> &functions)
+      override;
+  // Expectation values of Pauli strings against the current state,
+  // e.g. {{0, 'X'}, {3, 'Y'}} for X0Y3 (an empty string is the identity).
+  std::vector<double> getPauliExpectationValues(
+      const std::vector<std::vector<std::pair<size_t, char>>> &in_pauliStrings);
 
 private:
+  // Dense copy of an MPS site tensor: A(l, p, r) at [(l * 2 + p) * rightDim + r]
+  struct DenseSiteTensor {
+    size_t leftDim;
+    size_t rightDim;
+    std::vector<std::complex<double>> data;
+  };
+  // Row-major 2x2 operator
+  using SingleQubitOp = std::array<std::complex<double>, 4>;
+  // Tensor product of single-qubit operators (identity on the other qubits)
+  using ProductOperator = std::vector<std::pair<size_t, SingleQubitOp>>;
+
   void applySingleQubitGate(xacc::Instruction &in_gate);
   void applyTwoQubitGate(itensor::ITensor &in_gateTensor, size_t in_siteId1,
                          size_t in_siteId2);
@@ -104,11 +132,27 @@ private:
   getTwoQubitOpInds(size_t in_siteId1, size_t in_siteId2);
   itensor::ITensor createTwoQubitOpTensor(size_t in_siteId1, size_t in_siteId2);
   double compute_expectation_z(const std::vector<size_t> &in_measureBits);
+  // Perfect sampling of measurement bit strings (in measure order):
+  // the orthogonality center is moved to the first site once, then each shot
+  // is drawn site by site (conditioned on the previous bits) from a dense copy
+  // of the MPS tensors. Shots are processed in batches across threads.
+  std::vector<std::string>
+  sampleMeasurements(const std::vector<size_t> &in_measureBits, int in_nbShots);
+  // Moves the orthogonality center to the first site and returns dense copies of
+  // the site tensors up to in_lastSite (the others are right-orthonormal).
+  std::vector<DenseSiteTensor> getRightCanonicalSites(size_t in_lastSite);
+  // Expectation values of product operators in a single pass:
+  // the identity left environments are computed once (one canonical sweep) and
+  // shared, each term then only contracts the sites between its first and last
+  // qubits (the sites after it are right-orthonormal).
+  std::vector<double>
+  computeProductExpectations(const std::vector<ProductOperator> &in_terms);
 
 private:
   itensor::MPS m_mps;
   std::vector<size_t> m_measureBits;
   std::shared_ptr<AcceleratorBuffer> m_buffer;
+  int m_nbShots;
   // SVD options
   double m_svdCutoff;
   int m_maxDim;
@@ -307,6 +307,36 @@ TEST(ITensorMPSVisitorTester, checkSampling) {
   }
 }
 
+TEST(ITensorMPSVisitorTester, checkMultiShotSampling) {
+  auto accelerator = xacc::getAccelerator(
+      "tnqvm", {{"tnqvm-visitor", "itensor-mps"}, {"shots", 8192}});
+  auto xasmCompiler = xacc::getCompiler("xasm");
+  auto program = xasmCompiler
+                     ->compile(R"(__qpu__ void ghzSampling(qbit q) {
+      H(q[0]);
+      CNOT(q[0], q[1]);
+      CNOT(q[1], q[2]);
+      X(q[3]);
+      Measure(q[3]);
+      Measure(q[0]);
+      Measure(q[2]);
+    })",
+                               accelerator)
+                     ->getComposites()[0];
+  auto buffer = xacc::qalloc(5);
+  accelerator->execute(buffer, program);
+  const auto counts = buffer->getMeasurementCounts();
+  int totalCount = 0;
+  for (const auto &[bitString, count] : counts) {
+    // Bits are in measure order: q3, q0, q2
+    EXPECT_TRUE(bitString == "100" || bitString == "111");
+    totalCount += count;
+  }
+  EXPECT_EQ(totalCount, 8192);
+  EXPECT_NEAR(buffer->computeMeasurementProbability("100"), 0.5, 0.05);
+  EXPECT_NEAR(buffer->computeMeasurementProbability("111"), 0.5, 0.05);
+}
+
 TEST(ITensorMPSVisitorTester, testParametricGate) {
   auto accelerator = xacc::getAccelerator("tnqvm");
   auto xasmCompiler = xacc::getCompiler("xasm");
@@ -482,6 +512,41 @@ TEST(ITensorMPSVisitorTester, testDeuteronVqeH2) {
   EXPECT_NEAR((*buffer)["opt-val"].as<double>(), -1.74886, 1e-4);
 }
 
+TEST(ITensorMPSVisitorTester, testPauliExpectationBatch) {
+  auto xasmCompiler = xacc::getCompiler("xasm");
+  auto program = xasmCompiler
+                     ->compile(R"(__qpu__ void bellPlusOne(qbit q) {
+      H(q[0]);
+      CNOT(q[0], q[1]);
+      Ry(q[3], 0.6);
+    })")
+                     ->getComposites()[0];
+  auto buffer = xacc::qalloc(4);
+  auto visitor = std::make_shared<ITensorMPSVisitor>();
+  visitor->initialize(buffer, -1);
+  InstructionIterator it(program);
+  while (it.hasNext()) {
+    auto nextInst = it.next();
+    if (nextInst->isEnabled()) {
+      nextInst->accept(visitor);
+    }
+  }
+
+  const auto expVals = visitor->getPauliExpectationValues({{{0, 'X'}, {1, 'X'}},
+                                                           {{0, 'Y'}, {1, 'Y'}},
+                                                           {{0, 'Z'}, {1, 'Z'}},
+                                                           {{0, 'Z'}},
+                                                           {{3, 'Z'}},
+                                                           {{3, 'X'}, {2, 'Z'}},
+                                                           {}});
+  const std::vector<double> expected{1.0, -1.0, 1.0, 0.0, std::cos(0.6),
+                                     std::sin(0.6), 1.0};
+  ASSERT_EQ(expVals.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_NEAR(expVals[i], expected[i], 1e-9);
+  }
+}
+
 TEST(ITensorMPSVisitorTester, testDeuteronVqeH3) {
   auto accelerator = xacc::getAccelerator("tnqvm");
   // Create the N=3 deuteron Hamiltonian